@@ -158,6 +158,13 @@ $builds += Invoke-Msvc `
         'deps',
         'deps\nuget\glm.0.9.9.700\build\native\include'
     )
+$builds += Invoke-Msvc `
+    -SourceFile 'src\BrushBench\sierra_brush_bench.cpp' -OutputName 'sierra_brush_bench' `
+    -IntermediateOutputDirName 'BrushBench' `
+    -IncludePaths @(
+        'deps',
+        'deps\nuget\glm.0.9.9.700\build\native\include'
+    )
 
 # don't try build the editor executable if it is currently running
 if (!(Get-Process 'sierra' -ErrorAction SilentlyContinue)) {
@@ -1,17 +1,66 @@
 #version 430 core
 layout(location = 0) in vec2 uv;
 
+// positions are measured in brush radii, relative to the minimum corner of the quad
+uniform vec2 segmentStart;
+uniform vec2 segmentEnd;
+uniform vec2 quadSize;
+
 uniform float brushFalloff;
 uniform float brushStrength;
+uniform int isIntegrated;
 
 out vec4 FragColor;
 
-void main()
+const float quadratureNodes[4] = float[4](0.1834346425f, 0.5255324099f, 0.7966664774f, 0.9602898565f);
+const float quadratureWeights[4] = float[4](0.3626837834f, 0.3137066459f, 0.2223810345f, 0.1012285363f);
+
+float getFalloff(float r)
 {
-    float d = 1 - min(distance(uv, vec2(0.5f)) * 2, 1);
+    float d = 1 - min(r, 1);
     float value = (cos(d * 3.14f) * 0.5f) + 0.5f;
     value = (1 - value) / (1 - brushFalloff);
-    value = max(min(value, 1.0f), 0.0f);
+    return max(min(value, 1.0f), 0.0f);
+}
+
+void main()
+{
+    vec2 axis = segmentEnd - segmentStart;
+    float segmentLength = length(axis);
+    vec2 direction = segmentLength > 0 ? axis / segmentLength : vec2(1, 0);
+
+    vec2 rel = (uv * quadSize) - segmentStart;
+    float along = dot(rel, direction);
+    float across = (rel.x * direction.y) - (rel.y * direction.x);
+    float acrossSq = across * across;
+
+    float value;
+    if (isIntegrated != 0)
+    {
+        // integrate the falloff over the part of the segment within one radius of this texel
+        float halfChord = sqrt(max(1 - acrossSq, 0));
+        float t0 = max(along - halfChord, 0);
+        float t1 = min(along + halfChord, segmentLength);
+        float halfWidth = max((t1 - t0) * 0.5f, 0);
+        float midOffset = ((t0 + t1) * 0.5f) - along;
+
+        float sum = 0;
+        for (int n = 0; n < 4; n++)
+        {
+            float nodeOffset = halfWidth * quadratureNodes[n];
+            float u0 = midOffset - nodeOffset;
+            float u1 = midOffset + nodeOffset;
+            float nodeSum = getFalloff(sqrt(acrossSq + (u0 * u0))) + getFalloff(sqrt(acrossSq + (u1 * u1)));
+            sum += nodeSum * quadratureWeights[n];
+        }
+        value = sum * halfWidth;
+    }
+    else
+    {
+        float u = along - clamp(along, 0, segmentLength);
+        value = getFalloff(sqrt(acrossSq + (u * u)));
+    }
+
     value = value * brushStrength;
     FragColor = vec4(value, 0, 0, 0);
 }
\ No newline at end of file
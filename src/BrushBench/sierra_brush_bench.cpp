@@ -0,0 +1,241 @@
+/*
+ * Headless driver for the CPU brush engine. It composites the same synthetic stroke over the same synthetic
+ * tile with each brush blend operation, once for every SIMD level the CPU supports. It then reports how long
+ * each run took and checks that every level produced exactly the same heightmaps as the scalar kernels. No
+ * GL context is needed so it can run on build machines, and it exits with a non-zero status if any kernels
+ * disagree. The checksums it prints can be compared across machines.
+ *
+ * The editor can also compare the CPU engine with the brush shaders, see DEBUG_VERIFY_CPU_BRUSH.
+ *
+ * build.ps1 builds it on Windows. Elsewhere it is a single translation unit, e.g.
+ *     g++ -std=c++17 -O2 -msse4.1 -mavx2 -I<glm include dir> src/BrushBench/sierra_brush_bench.cpp
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "../EditorCore/sierra_platform.h"
+#include "../EditorCore/sierra_math.h"
+#include "../EditorCore/sierra_simd.h"
+#include "../EditorCore/sierra_brush.h"
+#include "../EditorCore/sierra_brush.cpp"
+
+#define BENCH_TILE_DIM 1024
+#define BENCH_STROKE_VERTEX_COUNT 2048
+#define BENCH_VERTICES_PER_FRAME 4
+#define BENCH_ARENA_SIZE (256 * 1024 * 1024)
+
+struct BenchCase
+{
+    const char *name;
+    BrushBlendOperation blendOperation;
+    float blendSign;
+};
+
+global_variable BenchCase BenchCases[] = {
+    {"raise", BRUSH_BLEND_ADD_SUB, 1},
+    {"lower", BRUSH_BLEND_ADD_SUB, -1},
+    {"flatten", BRUSH_BLEND_FLATTEN, 1},
+    {"smooth", BRUSH_BLEND_SMOOTH, 1},
+    {"smooth box", BRUSH_BLEND_SMOOTH_BOX, 1},
+};
+global_variable const char *SimdLevelNames[] = {"scalar", "sse4", "avx2"};
+
+struct BenchResult
+{
+    double milliseconds;
+    uint16 *workingHeightmap;
+    uint16 *previewHeightmap;
+};
+
+BrushParameters getBenchBrushParameters(BenchCase *benchCase)
+{
+    // the editor's default brush settings, see getBrushParameters
+    BrushParameters result = {};
+    result.blendOperation = benchCase->blendOperation;
+    result.blendSign = benchCase->blendSign;
+    result.flattenHeight = 0.5f;
+    result.smoothRadius = 16;
+    result.radius = 60;
+    result.falloff = 0.5f;
+    if (benchCase->blendOperation == BRUSH_BLEND_FLATTEN)
+    {
+        result.maskBlendMode = BRUSH_MASK_BLEND_MAX;
+        result.strength = 1;
+        result.dabStrength = 1;
+    }
+    else
+    {
+        result.maskBlendMode = BRUSH_MASK_BLEND_ADDITIVE;
+        result.strength = 0.9568f * (0.01f + (0.01875f * 0.5f));
+        result.dabStrength = result.strength * 0.16f;
+        if (benchCase->blendOperation != BRUSH_BLEND_ADD_SUB)
+        {
+            result.strength *= 4;
+            result.dabStrength *= 4;
+        }
+    }
+    return result;
+}
+
+void initializeBenchTile(BrushTileBuffers *tile, BrushTileState *state, uint16 *committedHeightmap)
+{
+    uint32 texelCount = BENCH_TILE_DIM * BENCH_TILE_DIM;
+    memcpy(tile->committedHeightmap, committedHeightmap, texelCount * sizeof(uint16));
+    memcpy(tile->workingHeightmap, committedHeightmap, texelCount * sizeof(uint16));
+    memcpy(tile->previewHeightmap, committedHeightmap, texelCount * sizeof(uint16));
+    memset(tile->workingInfluenceMask, 0, texelCount * sizeof(uint16));
+    memset(tile->previewInfluenceMask, 0, texelCount * sizeof(uint16));
+
+    rect2 tileBounds = rectMinDim(0, 0, BENCH_TILE_DIM, BENCH_TILE_DIM);
+    brushUpdateSummedAreaTable(&tile->committedSums, tile->committedHeightmap, BENCH_TILE_DIM, tileBounds);
+    state->workingMaskRect = tileBounds;
+    state->previewMaskRect = tileBounds;
+    state->uncommittedRect = tileBounds;
+}
+
+BenchResult runBenchCase(MemoryArena *arena,
+    BrushTileBuffers *tile,
+    uint16 *committedHeightmap,
+    glm::vec2 *strokeVertices,
+    BenchCase *benchCase)
+{
+    BrushTileState state;
+    initializeBenchTile(tile, &state, committedHeightmap);
+    BrushParameters params = getBenchBrushParameters(benchCase);
+
+    // the stroke is composited a few vertices at a time with the cursor preview at its end, like the editor
+    BrushSegment segments[BENCH_VERTICES_PER_FRAME];
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32 first = 0; first < BENCH_STROKE_VERTEX_COUNT; first += BENCH_VERTICES_PER_FRAME)
+    {
+        for (uint32 i = 0; i < BENCH_VERTICES_PER_FRAME; i++)
+        {
+            uint32 vertexIndex = first + i;
+            segments[i].start = strokeVertices[vertexIndex > 0 ? vertexIndex - 1 : 0];
+            segments[i].end = strokeVertices[vertexIndex];
+            segments[i].isDab = vertexIndex == 0;
+        }
+        BrushSegment previewSegment;
+        previewSegment.start = strokeVertices[first + BENCH_VERTICES_PER_FRAME - 1];
+        previewSegment.end = previewSegment.start;
+        previewSegment.isDab = true;
+
+        brushCompositeTile(arena, tile, &state, &params, first == 0, segments, BENCH_VERTICES_PER_FRAME,
+            &previewSegment, glm::vec2(0, 0));
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    uint32 texelCount = BENCH_TILE_DIM * BENCH_TILE_DIM;
+    BenchResult result;
+    result.milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    result.workingHeightmap = pushArray(arena, uint16, texelCount);
+    result.previewHeightmap = pushArray(arena, uint16, texelCount);
+    memcpy(result.workingHeightmap, tile->workingHeightmap, texelCount * sizeof(uint16));
+    memcpy(result.previewHeightmap, tile->previewHeightmap, texelCount * sizeof(uint16));
+    return result;
+}
+
+uint64 getChecksum(uint16 *heightmap)
+{
+    // FNV-1a
+    uint64 hash = 14695981039346656037ull;
+    uint8 *bytes = (uint8 *)heightmap;
+    for (uint32 i = 0; i < BENCH_TILE_DIM * BENCH_TILE_DIM * sizeof(uint16); i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int main(int argc, char **argv)
+{
+    MemoryArena arena = {};
+    arena.size = BENCH_ARENA_SIZE;
+    arena.baseAddress = malloc(arena.size);
+    if (!arena.baseAddress)
+    {
+        fprintf(stderr, "couldn't allocate %u bytes\n", BENCH_ARENA_SIZE);
+        return 1;
+    }
+
+    uint32 texelCount = BENCH_TILE_DIM * BENCH_TILE_DIM;
+    BrushTileBuffers tile = {};
+    tile.dim = BENCH_TILE_DIM;
+    tile.neighbours[1][1] = &tile;
+    tile.tileSpacing = BENCH_TILE_DIM;
+    tile.committedHeightmap = pushArray(&arena, uint16, texelCount);
+    tile.workingInfluenceMask = pushArray(&arena, uint16, texelCount);
+    tile.workingHeightmap = pushArray(&arena, uint16, texelCount);
+    tile.previewInfluenceMask = pushArray(&arena, uint16, texelCount);
+    tile.previewHeightmap = pushArray(&arena, uint16, texelCount);
+    uint32 summedAreaCount = (BENCH_TILE_DIM + 1) * (BENCH_TILE_DIM + 1);
+    brushInitializeSummedAreaTable(
+        &tile.committedSums, pushArray(&arena, uint64, summedAreaCount), 0, 0, BENCH_TILE_DIM, BENCH_TILE_DIM);
+
+    // rolling hills with a little deterministic noise, so flat regions don't hide differences
+    uint16 *committedHeightmap = pushArray(&arena, uint16, texelCount);
+    uint32 noiseState = 0x12345678;
+    for (uint32 y = 0; y < BENCH_TILE_DIM; y++)
+    {
+        for (uint32 x = 0; x < BENCH_TILE_DIM; x++)
+        {
+            noiseState ^= noiseState << 13;
+            noiseState ^= noiseState >> 17;
+            noiseState ^= noiseState << 5;
+            float height = 0.5f + (0.3f * sinf(x * 0.013f) * cosf(y * 0.017f)) + ((noiseState & 0xFF) / 65535.0f);
+            committedHeightmap[(y * BENCH_TILE_DIM) + x] = (uint16)(height * 65535.0f);
+        }
+    }
+
+    // a wave across the tile that starts off its edge and ends inside it, so the final preview dab is visible
+    glm::vec2 *strokeVertices = pushArray(&arena, glm::vec2, BENCH_STROKE_VERTEX_COUNT);
+    for (uint32 i = 0; i < BENCH_STROKE_VERTEX_COUNT; i++)
+    {
+        float t = (float)i / (BENCH_STROKE_VERTEX_COUNT - 1);
+        float x = -64 + (t * BENCH_TILE_DIM);
+        float y = (BENCH_TILE_DIM * 0.5f) + (BENCH_TILE_DIM * 0.35f * sinf(t * 6 * glm::pi<float>()));
+        strokeVertices[i] = glm::vec2(x, y);
+    }
+
+    SimdLevel detectedLevel = getSimdLevel();
+    printf("detected SIMD level: %s\n", SimdLevelNames[detectedLevel]);
+
+    bool isAnyMismatched = false;
+    for (uint32 c = 0; c < arrayCount(BenchCases); c++)
+    {
+        BenchCase *benchCase = &BenchCases[c];
+        TemporaryMemory caseMemory = beginTemporaryMemory(&arena);
+
+        BenchResult reference = {};
+        for (uint32 level = SIMD_LEVEL_SCALAR; level <= (uint32)detectedLevel; level++)
+        {
+            SimdLevelLimit = (SimdLevel)level;
+            BenchResult result = runBenchCase(&arena, &tile, committedHeightmap, strokeVertices, benchCase);
+            if (level == SIMD_LEVEL_SCALAR)
+            {
+                reference = result;
+            }
+
+            bool isMatch = memcmp(result.workingHeightmap, reference.workingHeightmap, texelCount * sizeof(uint16))
+                    == 0
+                && memcmp(result.previewHeightmap, reference.previewHeightmap, texelCount * sizeof(uint16)) == 0;
+            isAnyMismatched |= !isMatch;
+            printf("%-10s %-6s %9.2f ms %7.3f ms/frame  working %016llx  preview %016llx%s\n", benchCase->name,
+                SimdLevelNames[level], result.milliseconds,
+                result.milliseconds / (BENCH_STROKE_VERTEX_COUNT / BENCH_VERTICES_PER_FRAME),
+                (unsigned long long)getChecksum(result.workingHeightmap),
+                (unsigned long long)getChecksum(result.previewHeightmap), isMatch ? "" : "  MISMATCH");
+        }
+        SimdLevelLimit = SIMD_LEVEL_AVX2;
+
+        endTemporaryMemory(&caseMemory);
+    }
+
+    free(arena.baseAddress);
+    return isAnyMismatched ? 1 : 0;
+}
@@ -13,6 +13,8 @@ namespace Sierra.Core
     internal delegate void PlatformNotifyAssetRegistered(in AssetRegistration assetReg);
     internal delegate void PlatformStartPerfCounter(string counterName);
     internal delegate void PlatformEndPerfCounter(string counterName);
+    internal delegate void PlatformJob(IntPtr context, uint jobIndex);
+    internal delegate void PlatformParallelFor(uint jobCount, IntPtr job, IntPtr context);
 
     internal struct EditorPlatformApi
     {
@@ -25,6 +27,7 @@ namespace Sierra.Core
         public IntPtr PublishTransaction;
         public IntPtr StartPerfCounter;
         public IntPtr EndPerfCounter;
+        public IntPtr ParallelFor;
     }
 
     [StructLayout(LayoutKind.Sequential)]
@@ -150,19 +153,19 @@ namespace Sierra.Core
     [StructLayout(LayoutKind.Sequential)]
     internal unsafe struct EditorUiState
     {
-        private const int MaxSelectedObjects = 32;
-
         public EditorContext CurrentContext;
 
         private uint* _selectedObjectIds;
         public uint SelectedObjectCount;
+        private uint _maxSelectedObjectCount;
         public Span<uint> SelectedObjectIds
-            => new Span<uint>(_selectedObjectIds, MaxSelectedObjects);
+            => new Span<uint>(_selectedObjectIds, (int)_maxSelectedObjectCount);
 
         public TerrainBrushTool TerrainBrushTool;
         public float TerrainBrushRadius;
         public float TerrainBrushFalloff;
         public float TerrainBrushStrength;
+        public float TerrainBrushSmoothRadius;
 
         public float SceneLightDirection;
 
@@ -177,6 +180,61 @@ namespace Sierra.Core
         public byte ShowTerrainTileHeightmap;
     }
 
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct HeightmapReadbackStats
+    {
+        public uint PendingCount;
+        public uint FramesBehind;
+        public uint MaxFramesBehind;
+        public uint BlockingCount;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct HoverHitCacheStats
+    {
+        public uint HitCount;
+        public uint MissCount;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct ObjectTransformStats
+    {
+        public uint RebuiltCount;
+        public uint ReusedCount;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct ObjectCullingStats
+    {
+        public uint VisibleCount;
+        public uint CulledCount;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct EditorRay
+    {
+        public Vector3 Origin;
+        public Vector3 Direction;
+    }
+
+    public enum RaycastHitType : uint
+    {
+        None = 0,
+        Terrain = 1,
+        Object = 2
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct EditorRaycastResult
+    {
+        public RaycastHitType HitType;
+        public float Distance;
+        public Vector3 Position;
+        public Vector3 Normal;
+        public int TileIndex;
+        public uint ObjectId;
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     struct TerrainMaterialProperties
     {
@@ -303,6 +361,9 @@ namespace Sierra.Core
     internal static class EditorCore
     {
         private static object reloadLock = new object();
+
+        // serializes the calls that read or modify the scene, so batch raycasts can come from any thread
+        private static object sceneLock = new object();
         private static IntPtr appMemoryDataPtr;
         private static IntPtr moduleHandle;
 
@@ -329,6 +390,12 @@ namespace Sierra.Core
         delegate IntPtr EditorGetImportedHeightmapAssetHandle(ref EditorMemory memory);
         delegate void EditorSaveHeightmap(ref EditorMemory memory, string filePath);
         delegate ref EditorUiState EditorGetUiState(ref EditorMemory memory);
+        delegate ref HeightmapReadbackStats EditorGetHeightmapReadbackStats(ref EditorMemory memory);
+        delegate ref HoverHitCacheStats EditorGetHoverHitCacheStats(ref EditorMemory memory);
+        delegate ref ObjectTransformStats EditorGetObjectTransformStats(ref EditorMemory memory);
+        delegate ref ObjectCullingStats EditorGetObjectCullingStats(ref EditorMemory memory);
+        delegate uint EditorRaycastBatch(ref EditorMemory memory, [In] EditorRay[] rays,
+            [Out] EditorRaycastResult[] results, uint rayCount);
         delegate void EditorAddMaterial(ref EditorMemory memory, TerrainMaterialProperties props);
         delegate void EditorDeleteMaterial(ref EditorMemory memory, uint index);
         delegate void EditorSwapMaterial(ref EditorMemory memory, uint indexA, uint indexB);
@@ -353,6 +420,11 @@ namespace Sierra.Core
         private static EditorGetImportedHeightmapAssetHandle editorGetImportedHeightmapAssetHandle;
         private static EditorSaveHeightmap editorSaveHeightmap;
         private static EditorGetUiState editorGetUiState;
+        private static EditorGetHeightmapReadbackStats editorGetHeightmapReadbackStats;
+        private static EditorGetHoverHitCacheStats editorGetHoverHitCacheStats;
+        private static EditorGetObjectTransformStats editorGetObjectTransformStats;
+        private static EditorGetObjectCullingStats editorGetObjectCullingStats;
+        private static EditorRaycastBatch editorRaycastBatch;
         private static EditorAddMaterial editorAddMaterial;
         private static EditorDeleteMaterial editorDeleteMaterial;
         private static EditorSwapMaterial editorSwapMaterial;
@@ -390,6 +462,7 @@ namespace Sierra.Core
             PlatformGetFileSize getFileSize, PlatformReadEntireFile readEntireFile,
             PlatformWriteEntireFile writeEntireFile,
             PlatformStartPerfCounter startPerfCounter, PlatformEndPerfCounter endPerfCounter,
+            PlatformParallelFor parallelFor,
             Func<string, IntPtr> loadLibrary, Func<IntPtr, string, IntPtr> getProcAddress,
             Func<IntPtr, bool> freeLibrary)
         {
@@ -412,10 +485,12 @@ namespace Sierra.Core
             memory.PlatformApi.PublishTransaction = Marshal.GetFunctionPointerForDelegate(onTransactionPublished);
             memory.PlatformApi.StartPerfCounter = Marshal.GetFunctionPointerForDelegate(startPerfCounter);
             memory.PlatformApi.EndPerfCounter = Marshal.GetFunctionPointerForDelegate(endPerfCounter);
+            memory.PlatformApi.ParallelFor = Marshal.GetFunctionPointerForDelegate(parallelFor);
         }
 
         internal static bool ReloadCode(string dllPath, string dllShadowCopyPath)
         {
+            lock (sceneLock)
             lock (reloadLock)
             {
                 if (moduleHandle != IntPtr.Zero)
@@ -456,6 +531,11 @@ namespace Sierra.Core
                 editorGetImportedHeightmapAssetHandle = GetApi<EditorGetImportedHeightmapAssetHandle>("editorGetImportedHeightmapAssetHandle");
                 editorSaveHeightmap = GetApi<EditorSaveHeightmap>("editorSaveHeightmap");
                 editorGetUiState = GetApi<EditorGetUiState>("editorGetUiState");
+                editorGetHeightmapReadbackStats = GetApi<EditorGetHeightmapReadbackStats>("editorGetHeightmapReadbackStats");
+                editorGetHoverHitCacheStats = GetApi<EditorGetHoverHitCacheStats>("editorGetHoverHitCacheStats");
+                editorGetObjectTransformStats = GetApi<EditorGetObjectTransformStats>("editorGetObjectTransformStats");
+                editorGetObjectCullingStats = GetApi<EditorGetObjectCullingStats>("editorGetObjectCullingStats");
+                editorRaycastBatch = GetApi<EditorRaycastBatch>("editorRaycastBatch");
                 editorAddMaterial = GetApi<EditorAddMaterial>("editorAddMaterial");
                 editorDeleteMaterial = GetApi<EditorDeleteMaterial>("editorDeleteMaterial");
                 editorSwapMaterial = GetApi<EditorSwapMaterial>("editorSwapMaterial");
@@ -494,13 +574,28 @@ namespace Sierra.Core
         }
 
         internal static void Update(float deltaTime)
-            => editorUpdate?.Invoke(ref GetEditorMemory(), deltaTime);
+        {
+            lock (sceneLock)
+            {
+                editorUpdate?.Invoke(ref GetEditorMemory(), deltaTime);
+            }
+        }
 
         internal static void RenderSceneView(ref EditorViewContext vctx, float deltaTime, ref EditorInput input)
-            => editorRenderSceneView?.Invoke(ref GetEditorMemory(), ref vctx, deltaTime, ref input);
+        {
+            lock (sceneLock)
+            {
+                editorRenderSceneView?.Invoke(ref GetEditorMemory(), ref vctx, deltaTime, ref input);
+            }
+        }
 
         internal static void RenderHeightmapPreview(ref EditorViewContext vctx, float deltaTime, ref EditorInput input)
-            => editorRenderHeightmapPreview?.Invoke(ref GetEditorMemory(), ref vctx, deltaTime, ref input);
+        {
+            lock (sceneLock)
+            {
+                editorRenderHeightmapPreview?.Invoke(ref GetEditorMemory(), ref vctx, deltaTime, ref input);
+            }
+        }
 
         internal static IntPtr GetImportedHeightmapAssetHandle()
             => editorGetImportedHeightmapAssetHandle?.Invoke(ref GetEditorMemory()) ?? IntPtr.Zero;
@@ -521,6 +616,67 @@ namespace Sierra.Core
             }
         }
 
+        internal static HeightmapReadbackStats GetHeightmapReadbackStats()
+        {
+            if (editorGetHeightmapReadbackStats == null)
+            {
+                return default(HeightmapReadbackStats);
+            }
+            else
+            {
+                ref EditorMemory memory = ref GetEditorMemory();
+                return editorGetHeightmapReadbackStats(ref memory);
+            }
+        }
+
+        internal static HoverHitCacheStats GetHoverHitCacheStats()
+        {
+            if (editorGetHoverHitCacheStats == null)
+            {
+                return default(HoverHitCacheStats);
+            }
+            else
+            {
+                ref EditorMemory memory = ref GetEditorMemory();
+                return editorGetHoverHitCacheStats(ref memory);
+            }
+        }
+
+        internal static ObjectTransformStats GetObjectTransformStats()
+        {
+            if (editorGetObjectTransformStats == null)
+            {
+                return default(ObjectTransformStats);
+            }
+            else
+            {
+                ref EditorMemory memory = ref GetEditorMemory();
+                return editorGetObjectTransformStats(ref memory);
+            }
+        }
+
+        internal static ObjectCullingStats GetObjectCullingStats()
+        {
+            if (editorGetObjectCullingStats == null)
+            {
+                return default(ObjectCullingStats);
+            }
+            else
+            {
+                ref EditorMemory memory = ref GetEditorMemory();
+                return editorGetObjectCullingStats(ref memory);
+            }
+        }
+
+        internal static uint RaycastBatch(EditorRay[] rays, EditorRaycastResult[] results)
+        {
+            uint rayCount = (uint)Math.Min(rays.Length, results.Length);
+            lock (sceneLock)
+            {
+                return editorRaycastBatch?.Invoke(ref GetEditorMemory(), rays, results, rayCount) ?? 0;
+            }
+        }
+
         internal static void AddMaterial(TerrainMaterialProperties props)
             => editorAddMaterial?.Invoke(ref GetEditorMemory(), props);
 
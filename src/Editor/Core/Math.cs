@@ -16,7 +16,7 @@ namespace Sierra.Core
     }
 
     [StructLayout(LayoutKind.Sequential)]
-    internal struct Vector3
+    public struct Vector3
     {
         public float X;
         public float Y;
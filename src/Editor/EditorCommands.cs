@@ -6,8 +6,6 @@ namespace Sierra
 {
     public static class EditorCommands
     {
-        private const int maxObjectCount = 32;
-
         public readonly static ActionCommand AddObject = new ActionCommand(() =>
         {
             if (EditorCore.BeginTransaction(out var tx))
@@ -32,9 +30,13 @@ namespace Sierra
             }
         });
 
+        // casts the rays against the scene as of the last update, can be called from any thread
+        public static uint RaycastBatch(EditorRay[] rays, EditorRaycastResult[] results)
+            => EditorCore.RaycastBatch(rays, results);
+
         internal static void Update(EditorDocumentViewModel doc, ref EditorUiState uiState)
         {
-            AddObject.UpdateCanExecute(doc.ObjectIds.Count < maxObjectCount);
+            AddObject.UpdateCanExecute(true);
             DeleteSelectedObject.UpdateCanExecute(uiState.SelectedObjectCount > 0);
         }
     }
@@ -152,6 +152,25 @@ namespace Sierra
                 PrintCounter(counter, 0);
             }
 
+            HeightmapReadbackStats readbackStats = EditorCore.GetHeightmapReadbackStats();
+            perfCounterSummaryBuilder.AppendLine(new string('-', lineLength));
+            perfCounterSummaryBuilder.AppendLine(
+                $"Heightmap readbacks: {readbackStats.PendingCount} pending, {readbackStats.FramesBehind} frames behind");
+            perfCounterSummaryBuilder.AppendLine(
+                $"  (max {readbackStats.MaxFramesBehind} frames behind, {readbackStats.BlockingCount} waited on)");
+
+            HoverHitCacheStats hoverStats = EditorCore.GetHoverHitCacheStats();
+            perfCounterSummaryBuilder.AppendLine(
+                $"Hover raycasts: {hoverStats.HitCount} cached, {hoverStats.MissCount} recomputed");
+
+            ObjectTransformStats transformStats = EditorCore.GetObjectTransformStats();
+            perfCounterSummaryBuilder.AppendLine(
+                $"Object transforms: {transformStats.RebuiltCount} rebuilt, {transformStats.ReusedCount} reused");
+
+            ObjectCullingStats cullingStats = EditorCore.GetObjectCullingStats();
+            perfCounterSummaryBuilder.AppendLine(
+                $"Object instances: {cullingStats.VisibleCount} drawn, {cullingStats.CulledCount} culled");
+
             tbPerfCounters.Text = perfCounterSummaryBuilder.ToString();
         }
     }
@@ -4,6 +4,7 @@ using System.Diagnostics;
 using System.IO;
 using System.Runtime.InteropServices;
 using System.Threading;
+using System.Threading.Tasks;
 using System.Windows;
 using System.Windows.Input;
 using System.Windows.Interop;
@@ -55,6 +56,7 @@ namespace Sierra.Platform
         private static PlatformWriteEntireFile editorPlatformWriteEntireFile = WriteEntireFile;
         private static PlatformStartPerfCounter editorPlatformStartPerfCounter = PerfCounters.StartPerfCounter;
         private static PlatformEndPerfCounter editorPlatformEndPerfCounter = PerfCounters.EndPerfCounter;
+        private static PlatformParallelFor editorPlatformParallelFor = ParallelFor;
 
         internal static void Tick()
         {
@@ -72,7 +74,7 @@ namespace Sierra.Platform
             EditorCore.Initialize(appMemoryPtr, appMemorySizeInBytes,
                 editorPlatformLogMessage, editorPlatformGetFileLastWriteTime, editorPlatformGetFileSize,
                 editorPlatformReadEntireFile, editorPlatformWriteEntireFile,
-                editorPlatformStartPerfCounter, editorPlatformEndPerfCounter,
+                editorPlatformStartPerfCounter, editorPlatformEndPerfCounter, editorPlatformParallelFor,
                 Win32.LoadLibrary, Win32.GetProcAddress, Win32.FreeLibrary);
 
             OpenGL.Initialize();
@@ -289,6 +291,12 @@ namespace Sierra.Platform
             Debug.WriteLine(message);
         }
 
+        private static void ParallelFor(uint jobCount, IntPtr job, IntPtr context)
+        {
+            var jobDelegate = Marshal.GetDelegateForFunctionPointer<PlatformJob>(job);
+            Parallel.For(0, (int)jobCount, jobIndex => jobDelegate(context, (uint)jobIndex));
+        }
+
         private static string GetAssetFilePath(string relativePath)
         {
             return Path.Combine(assetsDirectoryPath, relativePath);
@@ -106,6 +106,9 @@ namespace Sierra.Utilities.Binding
                     case UiProperty.TerrainBrushStrength:
                         SetSourceProperty(ref state.TerrainBrushStrength);
                         break;
+                    case UiProperty.TerrainBrushSmoothRadius:
+                        SetSourceProperty(ref state.TerrainBrushSmoothRadius);
+                        break;
                     case UiProperty.SelectedObjectIds:
                         state.SelectedObjectCount = 0;
                         foreach (uint objectId in backingObservableCollection.OfType<uint>())
@@ -153,6 +156,7 @@ namespace Sierra.Utilities.Binding
                     UiProperty.TerrainBrushRadius => state.TerrainBrushRadius,
                     UiProperty.TerrainBrushFalloff => state.TerrainBrushFalloff,
                     UiProperty.TerrainBrushStrength => state.TerrainBrushStrength,
+                    UiProperty.TerrainBrushSmoothRadius => state.TerrainBrushSmoothRadius,
                     UiProperty.SceneLightDirection => state.SceneLightDirection,
 
                     UiProperty.Debug_ShowTerrainRaycastVis => state.DebugState.ShowTerrainRaycastVis,
@@ -187,6 +191,7 @@ namespace Sierra.Utilities.Binding
         TerrainBrushRadius,
         TerrainBrushFalloff,
         TerrainBrushStrength,
+        TerrainBrushSmoothRadius,
         SelectedObjectIds,
         SceneLightDirection,
 
@@ -25,8 +25,13 @@ TimedBlock::~TimedBlock()
 
 #include "sierra_renderer.cpp"
 #include "sierra_opengl.cpp"
+#include "sierra_geometry.cpp"
+#include "sierra_bvh.cpp"
 #include "sierra_assets.cpp"
 #include "sierra_transactions.cpp"
+#include "sierra_objects.cpp"
+#include "sierra_brush.cpp"
+#include "sierra_heightfield.cpp"
 #include "sierra_heightmap.cpp"
 
 #include "../../deps/stb/stb_image.c"
@@ -47,6 +52,12 @@ struct TerrainInteractionState
     bool isAdjustingBrushParameters;
     BrushStroke activeBrushStroke;
 };
+struct ObjectInteractionState
+{
+    // a marquee selection starts once the cursor is dragged far enough from where it was pressed
+    glm::vec2 startCursorPos;
+    bool isMarqueeActive;
+};
 struct ManipulatorInteractionState
 {
     glm::vec3 initialWorldPos;
@@ -88,41 +99,86 @@ bool isNewButtonPress(EditorInput *input, EditorInputButtons button)
         cmd->value = (val);                                                                                       \
     }
 
-float *getObjectProperty(EditorDocumentState *docState, uint32 objIndex, ObjectProperty property)
+/*
+ * Refreshes the height ranges of the regions of the tile overlapping changedRect (in heightmap texels), then
+ * the tile's bounds from all of them.
+ */
+void updateTileBounds(TerrainTile *tile, rect2 changedRect)
 {
-    assert(objIndex < docState->objectInstanceCount);
-    ObjectTransform *transform = &docState->objectTransforms[objIndex];
-    switch (property)
+    const float regionLength = TERRAIN_TILE_LENGTH_IN_WORLD_UNITS / TERRAIN_TILE_SUB_BOUNDS_PER_EDGE;
+    float heightmapDimWithoutOverlap = HEIGHTMAP_DIM - (2 * HEIGHTMAP_OVERLAP_IN_TEXELS);
+    float heightmapToWorldSpace = TERRAIN_TILE_LENGTH_IN_WORLD_UNITS / heightmapDimWithoutOverlap;
+
+    // a changed texel can affect the heightfield cells either side of the samples around it
+    glm::vec2 changedMin = ((getMin(changedRect) - HEIGHTMAP_OVERLAP_IN_TEXELS) * heightmapToWorldSpace)
+        - tile->heightfield.spacing;
+    glm::vec2 changedMax = ((getMax(changedRect) - HEIGHTMAP_OVERLAP_IN_TEXELS) * heightmapToWorldSpace)
+        + tile->heightfield.spacing;
+    glm::vec2 firstRegion =
+        glm::clamp(glm::floor(changedMin / regionLength), 0.0f, (float)TERRAIN_TILE_SUB_BOUNDS_PER_EDGE);
+    glm::vec2 endRegion =
+        glm::clamp(glm::ceil(changedMax / regionLength), 0.0f, (float)TERRAIN_TILE_SUB_BOUNDS_PER_EDGE);
+    for (uint32 y = (uint32)firstRegion.y; y < (uint32)endRegion.y; y++)
     {
-    case PROP_OBJ_POSITION_X:
-        return &transform->position.x;
-        break;
-    case PROP_OBJ_POSITION_Y:
-        return &transform->position.y;
-        break;
-    case PROP_OBJ_POSITION_Z:
-        return &transform->position.z;
-        break;
-    case PROP_OBJ_ROTATION_X:
-        return &transform->rotation.x;
-        break;
-    case PROP_OBJ_ROTATION_Y:
-        return &transform->rotation.y;
-        break;
-    case PROP_OBJ_ROTATION_Z:
-        return &transform->rotation.z;
-        break;
-    case PROP_OBJ_SCALE_X:
-        return &transform->scale.x;
-        break;
-    case PROP_OBJ_SCALE_Y:
-        return &transform->scale.y;
-        break;
-    case PROP_OBJ_SCALE_Z:
-        return &transform->scale.z;
-        break;
+        for (uint32 x = (uint32)firstRegion.x; x < (uint32)endRegion.x; x++)
+        {
+            uint32 regionIndex = (y * TERRAIN_TILE_SUB_BOUNDS_PER_EDGE) + x;
+            rect2 region = rectMinDim(x * regionLength, y * regionLength, regionLength, regionLength);
+            bool hasCells = heightfieldGetHeightRangeInRect(&tile->heightfield, region,
+                &tile->subBoundsMinHeights[regionIndex], &tile->subBoundsMaxHeights[regionIndex]);
+            assert(hasCells);
+        }
     }
-    return 0;
+
+    float minHeight = FLT_MAX;
+    float maxHeight = -FLT_MAX;
+    for (uint32 i = 0; i < arrayCount(tile->subBoundsMinHeights); i++)
+    {
+        minHeight = fminf(minHeight, tile->subBoundsMinHeights[i]);
+        maxHeight = fmaxf(maxHeight, tile->subBoundsMaxHeights[i]);
+    }
+
+    glm::vec2 minCorner = tile->center - (TERRAIN_TILE_LENGTH_IN_WORLD_UNITS * 0.5f);
+    glm::vec2 maxCorner = tile->center + (TERRAIN_TILE_LENGTH_IN_WORLD_UNITS * 0.5f);
+    tile->boundsMin = glm::vec3(minCorner.x, minHeight, minCorner.y);
+    tile->boundsMax = glm::vec3(maxCorner.x, maxHeight, maxCorner.y);
+}
+
+/*
+ * Returns whether the ray hits any of the tile's regions and the distance at which it first enters one. This
+ * is tighter than the tile's bounds, so rays skimming over a tile with a single peak can skip it entirely.
+ */
+bool isRayIntersectingTile(TerrainTile *tile, glm::vec3 rayOrigin, glm::vec3 rayDir, float *outEnterDistance)
+{
+    float enterDistance;
+    if (!isRayIntersectingBox(rayOrigin, rayDir, tile->boundsMin, tile->boundsMax, &enterDistance))
+    {
+        return false;
+    }
+
+    const float regionLength = TERRAIN_TILE_LENGTH_IN_WORLD_UNITS / TERRAIN_TILE_SUB_BOUNDS_PER_EDGE;
+    bool isHit = false;
+    float closestEnterDistance = FLT_MAX;
+    for (uint32 y = 0; y < TERRAIN_TILE_SUB_BOUNDS_PER_EDGE; y++)
+    {
+        for (uint32 x = 0; x < TERRAIN_TILE_SUB_BOUNDS_PER_EDGE; x++)
+        {
+            uint32 regionIndex = (y * TERRAIN_TILE_SUB_BOUNDS_PER_EDGE) + x;
+            glm::vec3 regionMin = glm::vec3(tile->boundsMin.x + (x * regionLength),
+                tile->subBoundsMinHeights[regionIndex], tile->boundsMin.z + (y * regionLength));
+            glm::vec3 regionMax = glm::vec3(regionMin.x + regionLength, tile->subBoundsMaxHeights[regionIndex],
+                regionMin.z + regionLength);
+            if (isRayIntersectingBox(rayOrigin, rayDir, regionMin, regionMax, &enterDistance)
+                && enterDistance < closestEnterDistance)
+            {
+                closestEnterDistance = enterDistance;
+                isHit = true;
+            }
+        }
+    }
+
+    *outEnterDistance = closestEnterDistance;
+    return isHit;
 }
 
 void initializeEditor(EditorMemory *memory)
@@ -137,6 +193,9 @@ void initializeEditor(EditorMemory *memory)
 
     state->assetsArena = pushSubArena(arena, 200 * 1024 * 1024);
     state->assetCtx = assetsInitialize(&state->assetsArena, state->renderCtx);
+
+    state->objectsArena = pushSubArena(arena, 64 * 1024 * 1024);
+    state->raycastArena = pushSubArena(arena, 1 * 1024 * 1024);
     Assets *assets = state->assetCtx;
     EditorAssets *editorAssets = &state->editorAssets;
 
@@ -178,10 +237,13 @@ void initializeEditor(EditorMemory *memory)
     editorAssets->meshRock = assetsRegisterMesh(assets, "rock.obj");
 
     state->uiState.selectedObjectCount = 0;
-    state->uiState.selectedObjectIds = pushArray(arena, uint32, MAX_OBJECT_INSTANCES);
+    state->uiState.maxSelectedObjectCount = OBJECT_CHUNK_CAPACITY;
+    state->uiState.selectedObjectIds =
+        pushArray(&state->objectsArena, uint32, state->uiState.maxSelectedObjectCount);
     state->uiState.terrainBrushRadius = 24.0f;
     state->uiState.terrainBrushFalloff = 0.55f;
     state->uiState.terrainBrushStrength = 0.12f;
+    state->uiState.terrainBrushSmoothRadius = 2.5f;
     state->uiState.sceneLightDirection = 0.5f;
 
     state->uiState.debugState.showTerrainRaycastVis = false;
@@ -211,16 +273,14 @@ void initializeEditor(EditorMemory *memory)
             TerrainTile *tile = currentTile++;
             tile->maxHeight = 200;
 
-            uint32 heightSampleCount = HEIGHTFIELD_SAMPLES_PER_EDGE * HEIGHTFIELD_SAMPLES_PER_EDGE;
-            tile->heights = pushArray(arena, float, heightSampleCount);
-            memset(tile->heights, 0, heightSampleCount);
+            heightfieldInitialize(&tile->heightfield, arena, HEIGHTFIELD_SAMPLES_PER_EDGE,
+                TERRAIN_TILE_LENGTH_IN_WORLD_UNITS, HEIGHTMAP_DIM, HEIGHTMAP_OVERLAP_IN_TEXELS);
+            tile->heightfieldDirtyRect = {};
 
             tile->committedHeightmap =
                 rendererCreateRenderTarget(arena, HEIGHTMAP_DIM, HEIGHTMAP_DIM, TEXTURE_FORMAT_R16, false);
             tile->workingBrushInfluenceMask =
                 rendererCreateRenderTarget(arena, HEIGHTMAP_DIM, HEIGHTMAP_DIM, TEXTURE_FORMAT_R16, false);
-            tile->workingPrevBrushInfluenceMask =
-                rendererCreateRenderTarget(arena, HEIGHTMAP_DIM, HEIGHTMAP_DIM, TEXTURE_FORMAT_R16, false);
             tile->workingHeightmap =
                 rendererCreateRenderTarget(arena, HEIGHTMAP_DIM, HEIGHTMAP_DIM, TEXTURE_FORMAT_R16, false);
             tile->previewBrushInfluenceMask =
@@ -228,7 +288,56 @@ void initializeEditor(EditorMemory *memory)
             tile->previewHeightmap =
                 rendererCreateRenderTarget(arena, HEIGHTMAP_DIM, HEIGHTMAP_DIM, TEXTURE_FORMAT_R16, false);
 
+            // the render targets start out uninitialized so the first composite must redraw them in full
+            rect2 heightmapBounds = rectMinDim(0, 0, HEIGHTMAP_DIM, HEIGHTMAP_DIM);
+            tile->brushState.workingMaskRect = heightmapBounds;
+            tile->brushState.previewMaskRect = heightmapBounds;
+            tile->brushState.uncommittedRect = heightmapBounds;
+
+            /*
+             * Keep a CPU copy of the committed and working heightmaps so they can be read without
+             * stalling on the GPU. The committed heightmap starts out flat on both the CPU and GPU.
+             */
+            uint32 heightmapTexelCount = HEIGHTMAP_DIM * HEIGHTMAP_DIM;
+            BrushTileBuffers *buffers = &tile->brushBuffers;
+            buffers->dim = HEIGHTMAP_DIM;
+            buffers->committedHeightmap = pushArray(arena, uint16, heightmapTexelCount);
+            buffers->workingHeightmap = pushArray(arena, uint16, heightmapTexelCount);
+            memset(buffers->committedHeightmap, 0, heightmapTexelCount * sizeof(uint16));
+            memset(buffers->workingHeightmap, 0, heightmapTexelCount * sizeof(uint16));
+            uploadHeightmapRegion(tile->committedHeightmap, buffers->committedHeightmap, heightmapBounds);
+            tile->isBrushCompositedOnCpu = false;
+#if FEATURE_CPU_SMOOTH_BRUSH || DEBUG_VERIFY_CPU_BRUSH
+            buffers->workingInfluenceMask = pushArray(arena, uint16, heightmapTexelCount);
+            buffers->previewInfluenceMask = pushArray(arena, uint16, heightmapTexelCount);
+            buffers->previewHeightmap = pushArray(arena, uint16, heightmapTexelCount);
+#endif
+#if FEATURE_CPU_SMOOTH_BRUSH
+            uint32 summedAreaCount = (HEIGHTMAP_DIM + 1) * (HEIGHTMAP_DIM + 1);
+            brushInitializeSummedAreaTable(&buffers->committedSums,
+                pushArray(arena, uint64, summedAreaCount), 0, 0, HEIGHTMAP_DIM, HEIGHTMAP_DIM);
+            brushUpdateSummedAreaTable(
+                &buffers->committedSums, buffers->committedHeightmap, HEIGHTMAP_DIM, heightmapBounds);
+
+            // the box smooth reads the texels past the edges of the tile from its neighbours
+            buffers->tileSpacing = HEIGHTMAP_DIM - (uint32)(2 * HEIGHTMAP_OVERLAP_IN_TEXELS);
+            for (int32 ty = 0; ty < 3; ty++)
+            {
+                for (int32 tx = 0; tx < 3; tx++)
+                {
+                    int32 neighbourX = (int32)x + tx - 1;
+                    int32 neighbourY = (int32)y + ty - 1;
+                    bool isInGrid =
+                        neighbourX >= 0 && neighbourX < tileColumns && neighbourY >= 0 && neighbourY < tileRows;
+                    buffers->neighbours[ty][tx] = isInGrid
+                        ? &sceneState->terrainTiles[(neighbourY * tileColumns) + neighbourX].brushBuffers
+                        : 0;
+                }
+            }
+#endif
+
             tile->center = topLeftTileCenter + glm::vec2(x * tileLengthInWorldUnits, y * tileLengthInWorldUnits);
+            updateTileBounds(tile, heightmapBounds);
             tile->tileToLeft = tileToLeft;
             tile->tileToRight = x == tileColumns - 1 ? 0 : &sceneState->terrainTiles[(y * tileColumns) + x + 1];
             tile->tileBelow = y == tileRows - 1 ? 0 : &sceneState->terrainTiles[((y + 1) * tileRows) + x];
@@ -242,10 +351,25 @@ void initializeEditor(EditorMemory *memory)
     // the first bit of the ID is used to signify that this is a mesh instance
     sceneState->nextObjectId = (1 << 31) | 1;
 
+    sceneState->rockMeshBvh = 0;
+    sceneState->rockMeshVersion = 0;
+    objectInstanceStoreInitialize(&sceneState->objectInstances, &state->objectsArena);
+    bvhInitialize(&sceneState->objectBvh, &state->objectsArena, OBJECT_CHUNK_CAPACITY);
+    sceneState->isObjectBvhDirty = true;
+    sceneState->isObjectBvhRefitNeeded = false;
+    sceneState->wasObjectBvhRefitted = false;
+    sceneState->objectBoundsCount = 0;
+    sceneState->lastChangedObjectIds = pushArray(&state->objectsArena, uint32, OBJECT_CHUNK_CAPACITY);
+    sceneState->lastChangedObjectIdCount = 0;
+    sceneState->maxLastChangedObjectIdCount = OBJECT_CHUNK_CAPACITY;
+
     // initialize document state
     state->docState.materialCount = 0;
     memset(state->docState.materials, 0, sizeof(state->docState.materials));
-    state->previewDocState = state->docState;
+    objectStoreInitialize(&state->docState.objects, &state->objectsArena);
+    state->previewDocState.materialCount = 0;
+    memset(state->previewDocState.materials, 0, sizeof(state->previewDocState.materials));
+    objectStoreInitialize(&state->previewDocState.objects, &state->objectsArena);
 
     // setup transaction state
     TransactionDataBlock *prevBlock = 0;
@@ -334,99 +458,231 @@ void initializeEditor(EditorMemory *memory)
 #endif
 }
 
-void updateHeightfieldHeights(TerrainTile *tile, uint32 heightmapWidth, uint32 heightmapHeight, uint16 *pixels)
+void updateTileHeightsFromHeightmap(EditorState *state)
 {
-    assert(heightmapWidth == heightmapHeight);
-    uint32 samplesPerEdge = HEIGHTFIELD_SAMPLES_PER_EDGE;
-    uint32 heightmapLengthWithoutOverlap = heightmapWidth - (2 * HEIGHTMAP_OVERLAP_IN_TEXELS);
-    float texelsPerSample = (float)heightmapLengthWithoutOverlap / (samplesPerEdge - 1);
-    float heightScalar = tile->maxHeight / (float)UINT16_MAX;
-    float *dst = (float *)tile->heights;
-    for (uint32 y = 0; y < samplesPerEdge; y++)
+    TIMED_BLOCK("Update Tile Heights");
+
+    for (uint32 i = 0; i < state->sceneState.terrainTileCount; i++)
     {
-        float ty = HEIGHTMAP_OVERLAP_IN_TEXELS + (y * texelsPerSample);
-        uint32 tTop = (uint32)floor(ty);
-        uint32 tBottom = tTop + 1;
-        float yLerp = ty - (float)tTop;
+        TerrainTile *tile = &state->sceneState.terrainTiles[i];
+        if (isRectEmpty(tile->heightfieldDirtyRect))
+        {
+            continue;
+        }
 
-        for (uint32 x = 0; x < samplesPerEdge; x++)
+        heightfieldUpdate(&tile->heightfield, tile->brushBuffers.workingHeightmap, HEIGHTMAP_DIM,
+            tile->heightfieldDirtyRect, tile->maxHeight);
+        updateTileBounds(tile, tile->heightfieldDirtyRect);
+        tile->heightfieldDirtyRect = {};
+        state->sceneState.terrainVersion++;
+    }
+}
+
+/*
+ * Raycasts the terrain tiles in the order the ray enters their bounds, stopping once the closest
+ * hit is nearer than the next tile. tileEntries must have room for an entry per tile.
+ */
+TerrainTile *raycastTerrain(SceneState *sceneState,
+    glm::vec3 rayOrigin,
+    glm::vec3 rayDir,
+    TerrainTileRayEntry *tileEntries,
+    RenderQueue *visRq,
+    HeightfieldRaycastHit *outHit)
+{
+    uint32 entryCount = 0;
+    for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
+    {
+        TerrainTile *tile = &sceneState->terrainTiles[i];
+        float enterDistance;
+        if (!isRayIntersectingTile(tile, rayOrigin, rayDir, &enterDistance))
+        {
+            continue;
+        }
+
+        uint32 insertIndex = entryCount++;
+        while (insertIndex > 0 && tileEntries[insertIndex - 1].enterDistance > enterDistance)
+        {
+            tileEntries[insertIndex] = tileEntries[insertIndex - 1];
+            insertIndex--;
+        }
+        tileEntries[insertIndex] = {tile, enterDistance};
+    }
+
+    TerrainTile *hitTile = 0;
+    float closestHitDistance = FLT_MAX;
+    for (uint32 i = 0; i < entryCount; i++)
+    {
+        // a hit in this tile or any tile after it can't be closer than the closest hit so far
+        if (tileEntries[i].enterDistance > closestHitDistance)
         {
-            float tx = HEIGHTMAP_OVERLAP_IN_TEXELS + (x * texelsPerSample);
-            uint32 tLeft = (uint32)floor(tx);
-            uint32 tRight = tLeft + 1;
-            float xLerp = tx - (float)tLeft;
+            break;
+        }
 
-            uint16 topLeft = pixels[(tTop * heightmapWidth) + tLeft];
-            uint16 topRight = pixels[(tTop * heightmapWidth) + tRight];
-            uint16 bottomLeft = pixels[(tBottom * heightmapWidth) + tLeft];
-            uint16 bottomRight = pixels[(tBottom * heightmapWidth) + tRight];
+        TerrainTile *tile = tileEntries[i].tile;
+        glm::vec2 minCorner = tile->center - (TERRAIN_TILE_LENGTH_IN_WORLD_UNITS * 0.5f);
 
-            float blended = lerp(lerp(topLeft, topRight, xLerp), lerp(bottomLeft, bottomRight, xLerp), yLerp);
-            *dst++ = blended * heightScalar;
+        HeightfieldRaycastHit hit;
+        if (heightfieldRaycast(&tile->heightfield, minCorner, rayOrigin, rayDir, visRq, &hit)
+            && hit.distance < closestHitDistance)
+        {
+            closestHitDistance = hit.distance;
+            *outHit = hit;
+            hitTile = tile;
         }
     }
+
+    return hitTile;
 }
 
-void updateTileHeightsFromHeightmap(EditorState *state, MemoryArena *arena)
+bool getTerrainHeight(SceneState *sceneState, glm::vec2 worldPos, float *outHeight)
 {
-    TIMED_BLOCK("Update Tile Heights");
+    float heightmapDimWithoutOverlap = HEIGHTMAP_DIM - (2 * HEIGHTMAP_OVERLAP_IN_TEXELS);
+    float worldToHeightmapSpace = heightmapDimWithoutOverlap / TERRAIN_TILE_LENGTH_IN_WORLD_UNITS;
+    for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
+    {
+        TerrainTile *tile = &sceneState->terrainTiles[i];
+        glm::vec2 relativePos = worldPos - (tile->center - (TERRAIN_TILE_LENGTH_IN_WORLD_UNITS * 0.5f));
+        if (relativePos.x < 0 || relativePos.y < 0 || relativePos.x > TERRAIN_TILE_LENGTH_IN_WORLD_UNITS
+            || relativePos.y > TERRAIN_TILE_LENGTH_IN_WORLD_UNITS)
+        {
+            continue;
+        }
 
-    TemporaryMemory tempMemory = beginTemporaryMemory(arena);
-    GetPixelsRequest *requests = pushArray(arena, GetPixelsRequest, state->sceneState.terrainTileCount);
+        // sample the working heightmap the same way as heightfieldUpdate
+        glm::vec2 texelPos = (relativePos * worldToHeightmapSpace) + HEIGHTMAP_OVERLAP_IN_TEXELS;
+        uint32 tLeft = (uint32)floor(texelPos.x);
+        uint32 tTop = (uint32)floor(texelPos.y);
+        uint32 tRight = min(tLeft + 1, (uint32)HEIGHTMAP_DIM - 1);
+        uint32 tBottom = min(tTop + 1, (uint32)HEIGHTMAP_DIM - 1);
+        float xLerp = texelPos.x - (float)tLeft;
+        float yLerp = texelPos.y - (float)tTop;
+
+        uint16 *pixels = tile->brushBuffers.workingHeightmap;
+        uint16 topLeft = pixels[(tTop * HEIGHTMAP_DIM) + tLeft];
+        uint16 topRight = pixels[(tTop * HEIGHTMAP_DIM) + tRight];
+        uint16 bottomLeft = pixels[(tBottom * HEIGHTMAP_DIM) + tLeft];
+        uint16 bottomRight = pixels[(tBottom * HEIGHTMAP_DIM) + tRight];
+
+        float blended = lerp(lerp(topLeft, topRight, xLerp), lerp(bottomLeft, bottomRight, xLerp), yLerp);
+        *outHeight = blended * (tile->maxHeight / (float)UINT16_MAX);
+        return true;
+    }
+    return false;
+}
 
-    // queue async texture reads for all tiles
-    for (uint32 i = 0; i < state->sceneState.terrainTileCount; i++)
+// at most this many full-resolution height samples are taken to refine the brush cursor each frame
+#define TERRAIN_HIT_REFINE_MARCH_STEPS 48
+#define TERRAIN_HIT_REFINE_BISECTION_STEPS 8
+#define TERRAIN_HIT_REFINE_WINDOW_IN_CELLS 2.0f
+
+/*
+ * The heightfield is a lower resolution proxy for the heightmaps, so a hit against it can be off the
+ * rendered surface. Marches the ray through a window around the heightfield hit, sampling the working
+ * heightmaps at full resolution, then bisects the step where the ray first passes below the surface.
+ * Returns false (leaving outDistance untouched) if the surface wasn't crossed inside the window.
+ */
+bool refineTerrainHit(
+    SceneState *sceneState, glm::vec3 rayOrigin, glm::vec3 rayDir, float coarseDistance, float *outDistance)
+{
+    TIMED_BLOCK("Refine Terrain Hit");
+
+    float cellSize = sceneState->terrainTiles[0].heightfield.spacing;
+    float window = (TERRAIN_HIT_REFINE_WINDOW_IN_CELLS * cellSize) / glm::length(rayDir);
+    float startDistance = fmaxf(coarseDistance - window, 0);
+    float endDistance = coarseDistance + window;
+    float step = (endDistance - startDistance) / TERRAIN_HIT_REFINE_MARCH_STEPS;
+
+    // if the ray is already below the surface at the start of the window it crossed it earlier on
+    float aboveDistance = startDistance;
+    glm::vec3 pos = rayOrigin + (rayDir * aboveDistance);
+    float height;
+    if (getTerrainHeight(sceneState, glm::vec2(pos.x, pos.z), &height) && pos.y <= height)
     {
-        TerrainTile *tile = &state->sceneState.terrainTiles[i];
-        RenderTarget *target = tile->workingHeightmap;
-        requests[i] =
-            rendererQueueGetPixels(state->renderCtx, target->textureHandle, target->width, target->height);
+        return false;
     }
 
-    // read tile heightmaps
-    for (uint32 i = 0; i < state->sceneState.terrainTileCount; i++)
+    for (uint32 i = 1; i <= TERRAIN_HIT_REFINE_MARCH_STEPS; i++)
     {
-        GetPixelsRequest *request = &requests[i];
-        TerrainTile *tile = &state->sceneState.terrainTiles[i];
-        RenderTarget *target = tile->workingHeightmap;
+        float belowDistance = startDistance + (step * i);
+        pos = rayOrigin + (rayDir * belowDistance);
+        if (!getTerrainHeight(sceneState, glm::vec2(pos.x, pos.z), &height) || pos.y > height)
+        {
+            aboveDistance = belowDistance;
+            continue;
+        }
 
-        GetPixelsResult result = rendererBeginReadPixels(request);
-        updateHeightfieldHeights(tile, target->width, target->height, (uint16 *)result.pixels);
-        rendererEndReadPixels(request);
+        for (uint32 j = 0; j < TERRAIN_HIT_REFINE_BISECTION_STEPS; j++)
+        {
+            float midDistance = (aboveDistance + belowDistance) * 0.5f;
+            pos = rayOrigin + (rayDir * midDistance);
+            if (getTerrainHeight(sceneState, glm::vec2(pos.x, pos.z), &height) && pos.y <= height)
+            {
+                belowDistance = midDistance;
+            }
+            else
+            {
+                aboveDistance = midDistance;
+            }
+        }
+
+        *outDistance = (aboveDistance + belowDistance) * 0.5f;
+        return true;
     }
 
-    endTemporaryMemory(&tempMemory);
+    return false;
 }
 
 bool commitChanges(EditorMemory *memory, BrushStroke *activeBrushStroke, glm::vec2 *brushCursorPos)
 {
     EditorState *state = (EditorState *)memory->arena.baseAddress;
 
-    bool committed = false;
+    // the CPU copies of the working heightmaps are about to be committed so they need to be up to date
+    applyHeightmapReadbacks(state, true);
+
+    bool committed = true;
     for (uint32 i = 0; i < state->sceneState.terrainTileCount; i++)
     {
         TerrainTile *tile = &state->sceneState.terrainTiles[i];
 
+        // only the region touched by the stroke needs to be copied
+        rect2 uncommittedRect = tile->brushState.uncommittedRect;
+        if (isRectEmpty(uncommittedRect))
+        {
+            continue;
+        }
+
         TemporaryMemory renderQueueMemory = beginTemporaryMemory(&memory->arena);
         RenderQueue *rq =
             rendererCreateQueue(state->renderCtx, &memory->arena, getRenderOutput(tile->committedHeightmap));
         rendererSetCameraOrtho(rq);
+        rendererSetClipRect(rq, uncommittedRect);
         rendererClear(rq, 0, 0, 0, 1);
         rendererPushTexturedQuad(
             rq, getBounds(tile->committedHeightmap), tile->workingHeightmap->textureHandle, true);
         if (rendererDraw(rq))
         {
-            committed = true;
+            // the CPU copy of the working heightmap already matches the render target
+            BrushTileBuffers *buffers = &tile->brushBuffers;
+            brushCopyRegion(buffers->committedHeightmap, buffers->workingHeightmap, HEIGHTMAP_DIM,
+                uncommittedRect, (uint32)uncommittedRect.x, (uint32)uncommittedRect.y);
+#if FEATURE_CPU_SMOOTH_BRUSH
+            brushUpdateSummedAreaTable(
+                &buffers->committedSums, buffers->committedHeightmap, HEIGHTMAP_DIM, uncommittedRect);
+#endif
+            tile->brushState.uncommittedRect = {};
+        }
+        else
+        {
+            committed = false;
         }
         endTemporaryMemory(&renderQueueMemory);
     }
 
     if (committed)
     {
-        activeBrushStroke->totalInstanceCount = 0;
-        activeBrushStroke->renderedInstanceCount = 0;
+        brushStrokeReset(activeBrushStroke);
         compositeHeightmaps(memory, activeBrushStroke, brushCursorPos);
-        updateTileHeightsFromHeightmap(state, &memory->arena);
+        updateTileHeightsFromHeightmap(state);
     }
     return committed;
 }
@@ -436,10 +692,9 @@ void discardChanges(EditorMemory *memory, BrushStroke *activeBrushStroke, glm::v
     MemoryArena *arena = &memory->arena;
     EditorState *state = (EditorState *)arena->baseAddress;
 
-    activeBrushStroke->totalInstanceCount = 0;
-    activeBrushStroke->renderedInstanceCount = 0;
+    brushStrokeReset(activeBrushStroke);
     compositeHeightmaps(memory, activeBrushStroke, brushCursorPos);
-    updateTileHeightsFromHeightmap(state, arena);
+    updateTileHeightsFromHeightmap(state);
 }
 
 void applyTransaction(TransactionEntry *tx, EditorDocumentState *docState)
@@ -546,53 +801,33 @@ void applyTransaction(TransactionEntry *tx, EditorDocumentState *docState)
         case EDITOR_COMMAND_AddObjectCommand:
         {
             AddObjectCommand *cmd = (AddObjectCommand *)cmdEntry.data;
-
-            assert(docState->objectInstanceCount < MAX_OBJECT_INSTANCES);
-            uint32 index = docState->objectInstanceCount++;
-
-            docState->objectIds[index] = cmd->objectId;
-
-            ObjectTransform *transform = &docState->objectTransforms[index];
-            transform->position = glm::vec3(0);
-            transform->rotation = glm::vec3(0);
-            transform->scale = glm::vec3(1);
+            objectStoreAdd(&docState->objects, cmd->objectId);
         }
         break;
         case EDITOR_COMMAND_DeleteObjectCommand:
         {
             DeleteObjectCommand *cmd = (DeleteObjectCommand *)cmdEntry.data;
 
-            bool foundObject = false;
-            for (uint32 i = 0; i < docState->objectInstanceCount; i++)
-            {
-                if (docState->objectIds[i] == cmd->objectId)
-                {
-                    foundObject = true;
-                    docState->objectIds[i] = docState->objectIds[docState->objectInstanceCount - 1];
-                    docState->objectTransforms[i] = docState->objectTransforms[docState->objectInstanceCount - 1];
-                    break;
-                }
-            }
-            assert(foundObject);
-            if (foundObject)
+            int32 index = objectStoreFind(&docState->objects, cmd->objectId);
+            assert(index >= 0);
+            if (index >= 0)
             {
-                docState->objectInstanceCount--;
+                objectStoreRemove(&docState->objects, index);
             }
         }
         break;
         case EDITOR_COMMAND_SetObjectPropertyCommand:
         {
             SetObjectPropertyCommand *cmd = (SetObjectPropertyCommand *)cmdEntry.data;
-            for (uint32 i = 0; i < docState->objectInstanceCount; i++)
+
+            int32 index = objectStoreFind(&docState->objects, cmd->objectId);
+            if (index >= 0)
             {
-                if (docState->objectIds[i] == cmd->objectId)
+                float *prop = objectStoreGetProperty(&docState->objects, index, cmd->property);
+                if (prop)
                 {
-                    float *prop = getObjectProperty(docState, i, cmd->property);
-                    if (prop)
-                    {
-                        *prop = cmd->value;
-                    }
-                    break;
+                    *prop = cmd->value;
+                    objectStoreMarkDirty(&docState->objects, index);
                 }
             }
         }
@@ -606,45 +841,212 @@ void updateFromDocumentState(EditorMemory *memory, EditorDocumentState *docState
     EditorState *state = (EditorState *)memory->arena.baseAddress;
     SceneState *sceneState = &state->sceneState;
 
-    // update object instance state
-    sceneState->objectInstanceCount = docState->objectInstanceCount;
-    for (uint32 i = 0; i < docState->objectInstanceCount; i++)
+    // update the instances of objects that were changed by committed or active transactions
+    ObjectStore *objects = &docState->objects;
+    ObjectInstanceStore *instances = &sceneState->objectInstances;
+    uint32 previousInstanceCount = instances->count;
+    objectInstanceStoreResize(instances, objects->count);
+
+    /*
+     * Objects changed last frame are updated again in case they were changed by an active transaction
+     * that has since been discarded. Only the objects changed this frame are remembered for next frame.
+     */
+    uint32 changedObjectCount = objects->dirtyIdCount;
+    for (uint32 i = 0; i < sceneState->lastChangedObjectIdCount; i++)
     {
-        ObjectTransform *transform = &docState->objectTransforms[i];
-        glm::mat4 matrix = glm::identity<glm::mat4>();
-        matrix = glm::translate(matrix, transform->position);
-        matrix = glm::scale(matrix, transform->scale);
-        glm::vec3 rockRotEuler = glm::radians(transform->rotation);
-        glm::quat rockRotQuat = glm::quat(rockRotEuler);
-        glm::mat4 rockRotMat = glm::toMat4(rockRotQuat);
-        matrix *= rockRotMat;
-        uint32 objectId = docState->objectIds[i];
+        int32 index = objectStoreFind(objects, sceneState->lastChangedObjectIds[i]);
+        if (index >= 0)
+        {
+            objectStoreMarkDirty(objects, index);
+        }
+    }
 
-        RenderMeshInstance *instance = &sceneState->objectInstanceData[i];
-        instance->id = objectId;
-        instance->transform = matrix;
+    TemporaryMemory rebuildMemory = beginTemporaryMemory(&memory->arena);
+    uint32 *rebuiltIndices = pushArray(&memory->arena, uint32, objects->dirtyIdCount);
+    uint32 rebuiltCount = 0;
+    for (uint32 i = 0; i < objects->dirtyIdCount; i++)
+    {
+        // objects that were removed are no longer found
+        int32 index = objectStoreFind(objects, objects->dirtyIds[i]);
+        if (index >= 0)
+        {
+            rebuiltIndices[rebuiltCount++] = index;
+        }
+    }
+    objectInstanceStoreUpdateTransforms(instances, objects, rebuiltIndices, rebuiltCount);
+
+    // once the rock mesh is loaded every instance's bounds are kept up to date
+    if (sceneState->rockMeshBvh && sceneState->rockMeshBvh->bvh.nodeCount > 0)
+    {
+        Bvh *meshBvh = &sceneState->rockMeshBvh->bvh;
+        objectInstanceStoreUpdateBounds(
+            instances, rebuiltIndices, rebuiltCount, meshBvh->boundsMin, meshBvh->boundsMax);
+        sceneState->objectBoundsCount = instances->count;
+    }
+    endTemporaryMemory(&rebuildMemory);
+
+    /*
+     * Moving objects only refits the object BVH as rebuilding it every frame while dragging is too slow.
+     * The refitted hierarchy gets worse the further objects move, so it is rebuilt once they stop changing.
+     */
+    if (instances->count != previousInstanceCount)
+    {
+        sceneState->isObjectBvhDirty = true;
+    }
+    else if (rebuiltCount > 0)
+    {
+        sceneState->isObjectBvhRefitNeeded = true;
+    }
+    else if (sceneState->wasObjectBvhRefitted)
+    {
+        sceneState->isObjectBvhDirty = true;
+    }
+    state->objectTransformStats.rebuiltCount += rebuiltCount;
+    state->objectTransformStats.reusedCount += objects->count - rebuiltCount;
+
+    if (changedObjectCount > sceneState->maxLastChangedObjectIdCount)
+    {
+        uint32 newMaxCount = sceneState->maxLastChangedObjectIdCount * 2;
+        while (newMaxCount < changedObjectCount)
+        {
+            newMaxCount *= 2;
+        }
+        sceneState->lastChangedObjectIds = pushArray(&state->objectsArena, uint32, newMaxCount);
+        sceneState->maxLastChangedObjectIdCount = newMaxCount;
+    }
+    memcpy(sceneState->lastChangedObjectIds, objects->dirtyIds, sizeof(uint32) * changedObjectCount);
+    sceneState->lastChangedObjectIdCount = changedObjectCount;
+    objectStoreClearDirty(objects);
+
+    // make sure every object can be selected at once
+    EditorUiState *uiState = &state->uiState;
+    if (objects->count > uiState->maxSelectedObjectCount)
+    {
+        uint32 newMaxSelectedObjectCount = uiState->maxSelectedObjectCount * 2;
+        while (newMaxSelectedObjectCount < objects->count)
+        {
+            newMaxSelectedObjectCount *= 2;
+        }
+        uint32 *newSelectedObjectIds = pushArray(&state->objectsArena, uint32, newMaxSelectedObjectCount);
+        memcpy(newSelectedObjectIds, uiState->selectedObjectIds, sizeof(uint32) * uiState->selectedObjectCount);
+        uiState->selectedObjectIds = newSelectedObjectIds;
+        uiState->maxSelectedObjectCount = newMaxSelectedObjectCount;
     }
 
     // remove any objects that no longer exists from the selection state
-    for (uint32 i = 0; i < state->uiState.selectedObjectCount; i++)
+    for (uint32 i = 0; i < uiState->selectedObjectCount; i++)
+    {
+        uint32 objectId = uiState->selectedObjectIds[i];
+        if (objectStoreFind(objects, objectId) < 0)
+        {
+            uiState->selectedObjectIds[i] = uiState->selectedObjectIds[uiState->selectedObjectCount - 1];
+            uiState->selectedObjectCount--;
+            i--;
+        }
+    }
+}
+
+void updateObjectBvh(EditorMemory *memory)
+{
+    EditorState *state = (EditorState *)memory->arena.baseAddress;
+    SceneState *sceneState = &state->sceneState;
+    MemoryArena *arena = &memory->arena;
+
+    LoadedAsset *rockMeshAsset = assetsGetMesh(state->editorAssets.meshRock);
+    if (!rockMeshAsset->mesh)
+    {
+        return;
+    }
+    ObjectInstanceStore *instances = &sceneState->objectInstances;
+    if (rockMeshAsset->version != sceneState->rockMeshVersion)
+    {
+        sceneState->rockMeshBvh = &rockMeshAsset->mesh->bvh;
+        sceneState->rockMeshVersion = rockMeshAsset->version;
+        sceneState->isObjectBvhDirty = true;
+
+        // every instance's bounds depend on the mesh's bounds
+        Bvh *meshBvh = &sceneState->rockMeshBvh->bvh;
+        sceneState->objectBoundsCount = meshBvh->nodeCount > 0 ? instances->count : 0;
+        objectInstanceStoreUpdateBounds(
+            instances, 0, sceneState->objectBoundsCount, meshBvh->boundsMin, meshBvh->boundsMax);
+    }
+    if (!sceneState->isObjectBvhDirty && !sceneState->isObjectBvhRefitNeeded)
     {
-        uint32 objectId = state->uiState.selectedObjectIds[i];
-        bool exists = false;
-        for (uint32 j = 0; j < docState->objectInstanceCount; j++)
+        return;
+    }
+
+    TIMED_BLOCK("Update Object BVH");
+
+    TemporaryMemory buildMemory = beginTemporaryMemory(arena);
+
+    uint32 instanceCount = sceneState->objectBoundsCount;
+    glm::vec3 *instanceMins = pushArray(arena, glm::vec3, instanceCount);
+    glm::vec3 *instanceMaxs = pushArray(arena, glm::vec3, instanceCount);
+    for (uint32 i = 0; i < instanceCount; i++)
+    {
+        uint32 slot;
+        ObjectInstanceChunk *chunk = objectInstanceStoreGetChunk(instances, i, &slot);
+        instanceMins[i] = glm::vec3(chunk->boundsMinX[slot], chunk->boundsMinY[slot], chunk->boundsMinZ[slot]);
+        instanceMaxs[i] = glm::vec3(chunk->boundsMaxX[slot], chunk->boundsMaxY[slot], chunk->boundsMaxZ[slot]);
+    }
+
+    Bvh *objectBvh = &sceneState->objectBvh;
+    if (sceneState->isObjectBvhDirty || objectBvh->primitiveCount != instanceCount)
+    {
+        if (instanceCount > objectBvh->maxPrimitiveCount)
         {
-            if (docState->objectIds[j] == objectId)
+            // the previous hierarchy's storage is abandoned, doubling its size keeps the waste bounded
+            uint32 maxInstanceCount = objectBvh->maxPrimitiveCount * 2;
+            while (maxInstanceCount < instanceCount)
             {
-                exists = true;
-                break;
+                maxInstanceCount *= 2;
             }
+            bvhInitialize(objectBvh, &state->objectsArena, maxInstanceCount);
         }
-        if (!exists)
+        bvhBuild(objectBvh, arena, instanceMins, instanceMaxs, instanceCount);
+        sceneState->wasObjectBvhRefitted = false;
+    }
+    else
+    {
+        bvhRefit(objectBvh, instanceMins, instanceMaxs);
+        sceneState->wasObjectBvhRefitted = true;
+    }
+
+    endTemporaryMemory(&buildMemory);
+
+    sceneState->isObjectBvhDirty = false;
+    sceneState->isObjectBvhRefitNeeded = false;
+    sceneState->objectVersion++;
+}
+
+BVH_RAYCAST_LEAF(raycastObjectBvhLeaf)
+{
+    SceneState *sceneState = (SceneState *)context;
+
+    bool wasUpdated = false;
+    for (uint32 i = 0; i < count; i++)
+    {
+        // raycast the mesh in the instance's local space, distances along the ray are unchanged
+        uint32 instanceIndex = bvh->primitiveIndices[first + i];
+        uint32 slot;
+        ObjectInstanceChunk *chunk =
+            objectInstanceStoreGetChunk(&sceneState->objectInstances, instanceIndex, &slot);
+        glm::mat4 *invTransform = &chunk->invTransforms[slot];
+        glm::vec3 localRayOrigin = glm::vec3(*invTransform * glm::vec4(rayOrigin, 1));
+        glm::vec3 localRayDir = glm::vec3(*invTransform * glm::vec4(rayDir, 0));
+
+        BvhRaycastHit meshHit;
+        if (meshBvhRaycast(sceneState->rockMeshBvh, localRayOrigin, localRayDir, closestHit->distance, &meshHit)
+            && meshHit.distance < closestHit->distance)
         {
-            state->uiState.selectedObjectIds[i] =
-                state->uiState.selectedObjectIds[state->uiState.selectedObjectCount--];
-            i--;
+            // normals transform by the inverse transpose of the instance's transform
+            closestHit->primitiveIndex = instanceIndex;
+            closestHit->distance = meshHit.distance;
+            closestHit->normal = glm::transpose(glm::mat3(*invTransform)) * meshHit.normal;
+            wasUpdated = true;
         }
     }
+    return wasUpdated;
 }
 
 API_EXPORT EDITOR_UPDATE(editorUpdate)
@@ -668,6 +1070,15 @@ API_EXPORT EDITOR_UPDATE(editorUpdate)
     assetsWatchForChanges(state->assetCtx);
     assetsLoadQueuedAssets(state->assetCtx);
 
+    state->objectTransformStats = {};
+    state->objectCullingStats = {};
+
+    state->heightmapReadbacks.currentFrame++;
+    if (applyHeightmapReadbacks(state, false))
+    {
+        updateTileHeightsFromHeightmap(state);
+    }
+
     {
         TIMED_BLOCK("Apply Transactions");
 
@@ -681,7 +1092,12 @@ API_EXPORT EDITOR_UPDATE(editorUpdate)
         state->transactions.committedUsed = 0;
 
         // apply active transactions
-        state->previewDocState = state->docState;
+        state->previewDocState.materialCount = state->docState.materialCount;
+        memcpy(state->previewDocState.materialIds, state->docState.materialIds,
+            sizeof(state->docState.materialIds));
+        memcpy(state->previewDocState.materials, state->docState.materials, sizeof(state->docState.materials));
+        objectStoreCopy(&state->previewDocState.objects, &state->docState.objects);
+        objectStoreClearDirty(&state->docState.objects);
         for (TransactionEntry tx = getFirstActiveTransaction(&state->transactions); isTransactionValid(&tx);
              tx = getNextActiveTransaction(&tx))
         {
@@ -690,6 +1106,7 @@ API_EXPORT EDITOR_UPDATE(editorUpdate)
         }
         updateFromDocumentState(memory, &state->previewDocState);
     }
+    updateObjectBvh(memory);
 
     EditorAssets *editorAssets = &state->editorAssets;
     RenderContext *rctx = state->renderCtx;
@@ -714,7 +1131,9 @@ API_EXPORT EDITOR_UPDATE(editorUpdate)
         rendererPushTexturedQuad(rq, {0, 0, 1, 1}, state->importedHeightmapTexture, true);
         if (rendererDraw(rq, tile->committedHeightmap))
         {
-            updateHeightfieldHeights(tile->heightfield, texture->width, texture->height, (uint16 *)texture->data);
+            heightfieldUpdate(&tile->heightfield, (uint16 *)texture->data, texture->width,
+                rectMinDim(0, 0, texture->width, texture->height), tile->maxHeight);
+            updateTileBounds(tile, rectMinDim(0, 0, HEIGHTMAP_DIM, HEIGHTMAP_DIM));
             state->importedHeightmapTextureVersion = importedHeightmapAsset->version;
         }
 
@@ -766,43 +1185,43 @@ glm::vec2 worldToScreen(SceneViewState *viewState, glm::vec3 world)
     return result;
 }
 
-bool isRayIntersectingTriangle(glm::vec3 rayOrigin,
-    glm::vec3 rayVector,
-    glm::vec3 v1,
-    glm::vec3 v2,
-    glm::vec3 v3,
-    float *out_intersectionDistance)
-{
-    // Moller-Trumbore intersection algorithm
-    // https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
-
-    const float EPSILON = 0.0000001f;
-    glm::vec3 h, s, q;
-    float a, f, u, v;
-    glm::vec3 edge1 = v2 - v1;
-    glm::vec3 edge2 = v3 - v1;
-    h = glm::cross(rayVector, edge2);
-    a = glm::dot(edge1, h);
-    if (a > -EPSILON && a < EPSILON)
-        return false; // ray is parallel to this triangle
-
-    f = 1.0 / a;
-    s = rayOrigin - v1;
-    u = f * glm::dot(s, h);
-    if (u < 0.0 || u > 1.0)
-        return false;
-    q = glm::cross(s, edge1);
-    v = f * glm::dot(rayVector, q);
-    if (v < 0.0 || u + v > 1.0)
-        return false;
-
-    // compute t to find out where the intersection point is on the line
-    float t = f * glm::dot(edge2, q);
-    if (t <= EPSILON)
-        return false; // there is a line intersection but not a ray intersection
+// selects the object instances whose bounds intersect the part of the view frustum covered by a screen rectangle
+void selectObjectsInScreenRect(EditorState *state, SceneViewState *viewState, rect2 screenRect)
+{
+    SceneState *sceneState = &state->sceneState;
+    EditorUiState *uiState = &state->uiState;
 
-    *out_intersectionDistance = t;
-    return true;
+    glm::vec2 ndcMin = screenToNdc(viewState, getMin(screenRect));
+    glm::vec2 ndcMax = screenToNdc(viewState, getMax(screenRect));
+    Frustum frustum = getFrustum(viewState->cameraTransform, ndcMin, ndcMax);
+
+    /*
+     * The selection has room for every instance, so write the indices of each chunk's instances that are
+     * inside the frustum there and replace them with their IDs.
+     */
+    ObjectInstanceStore *instances = &sceneState->objectInstances;
+    uint32 selectedCount = 0;
+    for (uint32 c = 0; c < getObjectChunkCount(sceneState->objectBoundsCount); c++)
+    {
+        ObjectInstanceChunk *chunk = instances->chunks[c];
+        BoundingBoxArray bounds;
+        bounds.minX = chunk->boundsMinX;
+        bounds.minY = chunk->boundsMinY;
+        bounds.minZ = chunk->boundsMinZ;
+        bounds.maxX = chunk->boundsMaxX;
+        bounds.maxY = chunk->boundsMaxY;
+        bounds.maxZ = chunk->boundsMaxZ;
+        bounds.count = getObjectCountInChunk(sceneState->objectBoundsCount, c);
+
+        uint32 *chunkSelectedIds = &uiState->selectedObjectIds[selectedCount];
+        uint32 chunkSelectedCount = getBoxesInFrustum(&frustum, &bounds, chunkSelectedIds);
+        for (uint32 i = 0; i < chunkSelectedCount; i++)
+        {
+            chunkSelectedIds[i] = chunk->instances[chunkSelectedIds[i]].id;
+        }
+        selectedCount += chunkSelectedCount;
+    }
+    uiState->selectedObjectCount = selectedCount;
 }
 
 uint64 getInteractionTriggerButtons(InteractionTargetType target)
@@ -967,42 +1386,29 @@ void sceneViewContinueInteraction(
             }
             else if (isButtonDown(input, EDITOR_INPUT_MOUSE_LEFT))
             {
-                // add brush instances
-                if (activeBrushStroke->totalInstanceCount == 0)
+                // extend the brush stroke, the brush is swept along the segments between its vertices
+                const float BRUSH_STROKE_MIN_SEGMENT_LENGTH = 1.0f;
+                if (activeBrushStroke->vertexCount == 0
+                    || glm::length(brushCursorPos - activeBrushStroke->lastVertex)
+                        >= BRUSH_STROKE_MIN_SEGMENT_LENGTH)
                 {
-                    activeBrushStroke->positions[0] = brushCursorPos;
-                    activeBrushStroke->totalInstanceCount = 1;
-                }
-                else if (activeBrushStroke->totalInstanceCount < MAX_BRUSH_QUADS - 1)
-                {
-                    glm::vec2 *nextBrushInstance =
-                        &activeBrushStroke->positions[activeBrushStroke->totalInstanceCount];
-                    glm::vec2 *prevBrushInstance = nextBrushInstance - 1;
-
-                    glm::vec2 diff = brushCursorPos - *prevBrushInstance;
-                    glm::vec2 direction = glm::normalize(diff);
-                    float distanceRemaining = glm::length(diff);
-
-                    const float BRUSH_INSTANCE_SPACING = 0.64f;
-                    while (distanceRemaining > BRUSH_INSTANCE_SPACING
-                        && activeBrushStroke->totalInstanceCount < MAX_BRUSH_QUADS - 1)
-                    {
-                        *nextBrushInstance++ = *prevBrushInstance++ + (direction * BRUSH_INSTANCE_SPACING);
-                        activeBrushStroke->totalInstanceCount++;
-
-                        distanceRemaining -= BRUSH_INSTANCE_SPACING;
-                    }
+                    brushStrokeAddVertex(activeBrushStroke, brushCursorPos);
                 }
             }
-            interactionState->hasUncommittedChanges = activeBrushStroke->totalInstanceCount > 0;
-            if (interactionState->isAdjustingBrushParameters)
+            if (interactionState->isAdjustingBrushParameters && activeBrushStroke->vertexCount > 0)
             {
-                activeBrushStroke->renderedInstanceCount = 0;
+                /*
+                 * The stroke so far was composited with the previous brush parameters. Commit it so the rest
+                 * of the stroke continues as a new stroke with the new parameters, rather than keeping every
+                 * vertex around to render the whole stroke again.
+                 */
+                commitChanges(memory, activeBrushStroke, &brushCursorPos);
             }
+            interactionState->hasUncommittedChanges = activeBrushStroke->vertexCount > 0;
             compositeHeightmaps(memory, activeBrushStroke, &brushCursorPos);
             if (!interactionState->isAdjustingBrushParameters)
             {
-                updateTileHeightsFromHeightmap(state, &memory->arena);
+                updateTileHeightsFromHeightmap(state);
             }
         }
         else
@@ -1011,6 +1417,30 @@ void sceneViewContinueInteraction(
         }
     }
     break;
+    case INTERACTION_TARGET_OBJECT:
+    {
+        ObjectInteractionState *interactionState =
+            (ObjectInteractionState *)viewState->interactionState.active.state;
+        if (!interactionState)
+        {
+            break;
+        }
+
+        const float MARQUEE_MIN_DRAG_DISTANCE = 4.0f;
+        if (glm::distance(input->cursorPos, interactionState->startCursorPos) >= MARQUEE_MIN_DRAG_DISTANCE)
+        {
+            interactionState->isMarqueeActive = true;
+        }
+        if (interactionState->isMarqueeActive)
+        {
+            TIMED_BLOCK("Marquee Selection");
+
+            glm::vec2 marqueeMin = glm::min(interactionState->startCursorPos, input->cursorPos);
+            glm::vec2 marqueeMax = glm::max(interactionState->startCursorPos, input->cursorPos);
+            selectObjectsInScreenRect(state, viewState, rectMinMax(marqueeMin, marqueeMax));
+        }
+    }
+    break;
     case INTERACTION_TARGET_MANIPULATOR:
     {
         TIMED_BLOCK("Continue Manipulator Interaction");
@@ -1087,17 +1517,13 @@ void sceneViewContinueInteraction(
         for (uint32 i = 0; i < interactionState->objectCount; i++)
         {
             uint32 objectId = interactionState->objectIds[i];
-            for (uint32 j = 0; j < state->docState.objectInstanceCount; j++)
+            int32 index = objectStoreFind(&state->docState.objects, objectId);
+            if (index >= 0)
             {
-                if (state->docState.objectIds[j] == objectId)
-                {
-                    ObjectTransform *transform = &state->docState.objectTransforms[j];
-                    glm::vec3 newP = transform->position + delta;
-                    setProperty(interactionState->tx, objectId, PROP_OBJ_POSITION_X, newP.x);
-                    setProperty(interactionState->tx, objectId, PROP_OBJ_POSITION_Y, newP.y);
-                    setProperty(interactionState->tx, objectId, PROP_OBJ_POSITION_Z, newP.z);
-                    break;
-                }
+                glm::vec3 newP = objectStoreGetPosition(&state->docState.objects, index) + delta;
+                setProperty(interactionState->tx, objectId, PROP_OBJ_POSITION_X, newP.x);
+                setProperty(interactionState->tx, objectId, PROP_OBJ_POSITION_Y, newP.y);
+                setProperty(interactionState->tx, objectId, PROP_OBJ_POSITION_Z, newP.z);
             }
         }
     }
@@ -1124,11 +1550,15 @@ void sceneViewBeginInteraction(
             pushStruct(&viewState->interactionState.activeArena, TerrainInteractionState);
         viewState->interactionState.hot.state = interactionState;
 
+        // the raycast only hits the low resolution heightfield, so sample the actual height under the cursor
+        float startingHeight = mouseWorldPos->y;
+        getTerrainHeight(&state->sceneState, glm::vec2(mouseWorldPos->x, mouseWorldPos->z), &startingHeight);
+
         TerrainTile *firstTile = &state->sceneState.terrainTiles[0];
         interactionState->hasUncommittedChanges = false;
         interactionState->isAdjustingBrushParameters = false;
-        interactionState->activeBrushStroke.startingHeight = mouseWorldPos->y / firstTile->maxHeight;
-        interactionState->activeBrushStroke.totalInstanceCount = 0;
+        brushStrokeInitialize(&interactionState->activeBrushStroke, &viewState->interactionState.activeArena,
+            startingHeight / firstTile->maxHeight);
     }
     break;
     case INTERACTION_TARGET_OBJECT:
@@ -1170,8 +1600,15 @@ void sceneViewBeginInteraction(
         }
         else
         {
-            // clear selection
+            // clear selection and start a marquee selection if the cursor is dragged
             uiState->selectedObjectCount = 0;
+
+            ObjectInteractionState *interactionState =
+                pushStruct(&viewState->interactionState.activeArena, ObjectInteractionState);
+            viewState->interactionState.hot.state = interactionState;
+
+            interactionState->startCursorPos = input->cursorPos;
+            interactionState->isMarqueeActive = false;
         }
     }
     break;
@@ -1194,15 +1631,11 @@ void sceneViewBeginInteraction(
         for (uint32 i = 0; i < state->uiState.selectedObjectCount; i++)
         {
             uint32 objectId = state->uiState.selectedObjectIds[i];
-            for (uint32 j = 0; j < state->docState.objectInstanceCount; j++)
+            int32 index = objectStoreFind(&state->docState.objects, objectId);
+            if (index >= 0)
             {
-                if (objectId == state->docState.objectIds[j])
-                {
-                    ObjectTransform *instance = &state->docState.objectTransforms[j];
-                    interactionState->objectIds[interactionState->objectCount++] = objectId;
-                    handlePos += instance->position;
-                    break;
-                }
+                interactionState->objectIds[interactionState->objectCount++] = objectId;
+                handlePos += objectStoreGetPosition(&state->docState.objects, index);
             }
         }
         assert(interactionState->objectCount);
@@ -1364,6 +1797,7 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
         viewState->cameraLookAt = glm::vec3(0, 0, 0);
         viewState->interactionState = {};
         viewState->interactionState.activeArena = pushSubArena(arena, 1 * 1024 * 1024);
+        viewState->hoverHitCache = {};
         viewState->sceneRenderTarget =
             rendererCreateRenderTarget(arena, view->width, view->height, TEXTURE_FORMAT_RGB8, true);
         viewState->selectionRenderTarget =
@@ -1425,6 +1859,20 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
     glm::vec3 mouseWorldPos = glm::vec3(-10000, -10000, -10000);
     bool wasMouseWorldPosFound = false;
 
+    // discard the cached hover results if the mouse ray or anything it could hit has changed
+    HoverHitCache *hoverCache = &viewState->hoverHitCache;
+    if (hoverCache->cameraTransform != viewState->cameraTransform || hoverCache->cursorPosNdc != mousePosNdc
+        || hoverCache->terrainVersion != sceneState->terrainVersion
+        || hoverCache->objectVersion != sceneState->objectVersion)
+    {
+        hoverCache->cameraTransform = viewState->cameraTransform;
+        hoverCache->cursorPosNdc = mousePosNdc;
+        hoverCache->terrainVersion = sceneState->terrainVersion;
+        hoverCache->objectVersion = sceneState->objectVersion;
+        hoverCache->isTerrainHitValid = false;
+        hoverCache->isObjectHitValid = false;
+    }
+
     // hit test terrain
     Interaction editTerrainInteraction = {};
     editTerrainInteraction.target.type = INTERACTION_TARGET_TERRAIN;
@@ -1438,76 +1886,53 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
     {
         TIMED_BLOCK("Raycast Terrain");
 
-        TerrainTile *firstTile = &sceneState->terrainTiles[0];
-        uint32 samplesPerEdge = HEIGHTFIELD_SAMPLES_PER_EDGE;
-        float spacing = TERRAIN_TILE_LENGTH_IN_WORLD_UNITS / (HEIGHTFIELD_SAMPLES_PER_EDGE - 1);
-        float closestRayHitDist = FLT_MAX;
-
-        for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
+        if (debugState->showTerrainTileBounds)
         {
-            TerrainTile *tile = &sceneState->terrainTiles[i];
-            glm::vec2 origin = tile->center - (TERRAIN_TILE_LENGTH_IN_WORLD_UNITS * 0.5f);
-            for (uint32 y = 0; y < samplesPerEdge - 1; y++)
+            for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
             {
-                uint32 yOffset = y * samplesPerEdge;
-                for (uint32 x = 0; x < samplesPerEdge - 1; x++)
-                {
-                    float *topLeftSample = tile->heights + yOffset + x;
-                    float *topRightSample = topLeftSample + 1;
-                    float *bottomRightSample = topLeftSample + samplesPerEdge + 1;
-                    float *bottomLeftSample = topLeftSample + samplesPerEdge;
-
-                    glm::vec2 start = glm::vec2(origin.x + (x * spacing), origin.y + (y * spacing));
-                    glm::vec3 topLeft = glm::vec3(start.x, *topLeftSample, start.y);
-                    glm::vec3 topRight = glm::vec3(start.x + spacing, *topRightSample, start.y);
-                    glm::vec3 bottomRight = glm::vec3(start.x + spacing, *bottomRightSample, start.y + spacing);
-                    glm::vec3 bottomLeft = glm::vec3(start.x, *bottomLeftSample, start.y + spacing);
-
-                    float rayHitDist;
-                    if (isRayIntersectingTriangle(
-                            viewState->cameraPos, mouseRayDir, topLeft, topRight, bottomRight, &rayHitDist)
-                        && rayHitDist < closestRayHitDist)
-                    {
-                        closestRayHitDist = rayHitDist;
-
-                        hitTriA = topLeft;
-                        hitTriB = topRight;
-                        hitTriC = bottomRight;
-                        hitTile = tile;
-                    }
-                    if (isRayIntersectingTriangle(
-                            viewState->cameraPos, mouseRayDir, topLeft, bottomLeft, bottomRight, &rayHitDist)
-                        && rayHitDist < closestRayHitDist)
-                    {
-                        closestRayHitDist = rayHitDist;
+                TerrainTile *tile = &sceneState->terrainTiles[i];
+                rect2 tileBounds = rectCenterDim(tile->center, TERRAIN_TILE_LENGTH_IN_WORLD_UNITS);
+                rendererPushQuadOutlineXz(sceneRq, tileBounds, glm::vec3(0, 0.5, 1));
+            }
+        }
 
-                        hitTriA = topLeft;
-                        hitTriB = bottomLeft;
-                        hitTriC = bottomRight;
-                        hitTile = tile;
-                    }
+        float closestRayHitDist = FLT_MAX;
 
-                    if (debugState->showTerrainRaycastVis)
-                    {
-                        TIMED_BLOCK("Push Raycast Vis");
-
-                        glm::vec3 color = glm::vec3(1, 0, 0.5);
-                        rendererBeginLine(sceneRq, topLeft, color);
-                        rendererExtendLine(sceneRq, topRight);
-                        rendererExtendLine(sceneRq, bottomRight);
-                        rendererEndLineLoop(sceneRq);
-                        rendererBeginLine(sceneRq, topLeft, color);
-                        rendererExtendLine(sceneRq, bottomRight);
-                        rendererExtendLine(sceneRq, bottomLeft);
-                        rendererEndLineLoop(sceneRq);
-                    }
-                }
+        // the raycast visualization is drawn while raycasting so it can't use the cached result
+        HeightfieldRaycastHit hit;
+        if (hoverCache->isTerrainHitValid && !debugState->showTerrainRaycastVis)
+        {
+            state->hoverHitCacheStats.hitCount++;
+            if (hoverCache->terrainHitTileIndex >= 0)
+            {
+                hitTile = &sceneState->terrainTiles[hoverCache->terrainHitTileIndex];
             }
-            if (debugState->showTerrainTileBounds)
+            hit = hoverCache->terrainHit;
+        }
+        else
+        {
+            state->hoverHitCacheStats.missCount++;
+
+            TerrainTileRayEntry *tileEntries =
+                pushArray(arena, TerrainTileRayEntry, sceneState->terrainTileCount);
+            RenderQueue *visRq = debugState->showTerrainRaycastVis ? sceneRq : 0;
+            hitTile = raycastTerrain(sceneState, viewState->cameraPos, mouseRayDir, tileEntries, visRq, &hit);
+            if (hitTile)
             {
-                rect2 tileBounds = rectCenterDim(tile->center, TERRAIN_TILE_LENGTH_IN_WORLD_UNITS);
-                rendererPushQuadOutlineXz(sceneRq, tileBounds, glm::vec3(0, 0.5, 1));
+                refineTerrainHit(sceneState, viewState->cameraPos, mouseRayDir, hit.distance, &hit.distance);
             }
+
+            hoverCache->isTerrainHitValid = true;
+            hoverCache->terrainHitTileIndex = hitTile ? (int32)(hitTile - sceneState->terrainTiles) : -1;
+            hoverCache->terrainHit = hit;
+        }
+        if (hitTile)
+        {
+            closestRayHitDist = hit.distance;
+
+            hitTriA = hit.triangle[0];
+            hitTriB = hit.triangle[1];
+            hitTriC = hit.triangle[2];
         }
 
         if (closestRayHitDist < FLT_MAX)
@@ -1588,14 +2013,57 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
 
         RenderEffect *rockEffect =
             rendererCreateEffect(arena, editorAssets->meshShaderRock, EFFECT_BLEND_ALPHA_BLEND);
-        rendererPushMeshes(sceneRq, editorAssets->meshRock, sceneState->objectInstanceData,
-            sceneState->objectInstanceCount, rockEffect);
-
         meshIdEffect = rendererCreateEffect(arena, editorAssets->meshShaderId, EFFECT_BLEND_ALPHA_BLEND);
+#if DEBUG_SHOW_PICKING_BUFFER
         RenderEffect *mesh32BitIdEffect = rendererCreateEffectOverride(meshIdEffect);
         rendererSetEffectUint(mesh32BitIdEffect, "idMask", 0xFFFFFFFF);
-        rendererPushMeshes(pickingRq, editorAssets->meshRock, sceneState->objectInstanceData,
-            sceneState->objectInstanceCount, mesh32BitIdEffect);
+#endif
+
+        /*
+         * Only the instances whose bounds intersect the view frustum are drawn. The bounds are updated along
+         * with the object BVH, so every instance is drawn if they are not up to date (e.g. the rock mesh
+         * has not loaded yet).
+         */
+        ObjectInstanceStore *instances = &sceneState->objectInstances;
+        bool canCull = sceneState->objectBoundsCount == instances->count;
+        Frustum frustum = getFrustum(viewState->cameraTransform, glm::vec2(-1, -1), glm::vec2(1, 1));
+        uint32 *visibleIndices = pushArray(arena, uint32, OBJECT_CHUNK_CAPACITY);
+        for (uint32 c = 0; c < getObjectChunkCount(instances->count); c++)
+        {
+            ObjectInstanceChunk *chunk = instances->chunks[c];
+            uint32 countInChunk = getObjectCountInChunk(instances->count, c);
+            if (!canCull)
+            {
+                rendererPushMeshes(sceneRq, editorAssets->meshRock, chunk->instances, countInChunk, rockEffect);
+#if DEBUG_SHOW_PICKING_BUFFER
+                rendererPushMeshes(
+                    pickingRq, editorAssets->meshRock, chunk->instances, countInChunk, mesh32BitIdEffect);
+#endif
+                state->objectCullingStats.visibleCount += countInChunk;
+                continue;
+            }
+
+            BoundingBoxArray bounds;
+            bounds.minX = chunk->boundsMinX;
+            bounds.minY = chunk->boundsMinY;
+            bounds.minZ = chunk->boundsMinZ;
+            bounds.maxX = chunk->boundsMaxX;
+            bounds.maxY = chunk->boundsMaxY;
+            bounds.maxZ = chunk->boundsMaxZ;
+            bounds.count = countInChunk;
+            uint32 visibleCount = getBoxesInFrustum(&frustum, &bounds, visibleIndices);
+            if (visibleCount)
+            {
+                rendererPushMeshesIndexed(
+                    sceneRq, editorAssets->meshRock, chunk->instances, visibleIndices, visibleCount, rockEffect);
+#if DEBUG_SHOW_PICKING_BUFFER
+                rendererPushMeshesIndexed(pickingRq, editorAssets->meshRock, chunk->instances, visibleIndices,
+                    visibleCount, mesh32BitIdEffect);
+#endif
+            }
+            state->objectCullingStats.visibleCount += visibleCount;
+            state->objectCullingStats.culledCount += countInChunk - visibleCount;
+        }
     }
 
     if (state->uiState.currentContext == EDITOR_CTX_OBJECTS)
@@ -1612,14 +2080,11 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
         for (uint32 i = 0; i < state->uiState.selectedObjectCount; i++)
         {
             uint32 objectId = state->uiState.selectedObjectIds[i];
-            for (uint32 j = 0; j < state->previewDocState.objectInstanceCount; j++)
+            int32 index = objectStoreFind(&state->previewDocState.objects, objectId);
+            if (index >= 0)
             {
-                if (objectId == state->previewDocState.objectIds[j])
-                {
-                    RenderMeshInstance *instance = &sceneState->objectInstanceData[j];
-                    rendererPushMeshes(selectionRq, editorAssets->meshRock, instance, 1, mesh7BitIdEffect);
-                    break;
-                }
+                RenderMeshInstance *instance = objectInstanceStoreGetInstance(&sceneState->objectInstances, index);
+                rendererPushMeshes(selectionRq, editorAssets->meshRock, instance, 1, mesh7BitIdEffect);
             }
         }
 
@@ -1631,15 +2096,12 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             uint64 hotObjectId64 = (uint64)viewState->interactionState.hot.target.id;
             assert(hotObjectId64 <= UINT32_MAX);
             uint32 hotObjectId = (uint32)hotObjectId64;
-            for (uint32 i = 0; i < state->previewDocState.objectInstanceCount; i++)
+            int32 index = objectStoreFind(&state->previewDocState.objects, hotObjectId);
+            if (index >= 0)
             {
-                if (state->previewDocState.objectIds[i] == hotObjectId)
-                {
-                    RenderMeshInstance *instance = &sceneState->objectInstanceData[i];
-                    hotInstance.transform = instance->transform;
-                    hotInstance.id = 0x80;
-                    break;
-                }
+                RenderMeshInstance *instance = objectInstanceStoreGetInstance(&sceneState->objectInstances, index);
+                hotInstance.transform = instance->transform;
+                hotInstance.id = 0x80;
             }
             if (hotInstance.id)
             {
@@ -1700,6 +2162,7 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
     else if (uiState->currentContext == EDITOR_CTX_OBJECTS)
     {
         // draw manipulator
+        ManipulatorInteractionMode hotManipulatorMode = MANIPULATOR_UNKNOWN;
         if (state->uiState.selectedObjectCount > 0)
         {
             TIMED_BLOCK("Push Object Manipulators");
@@ -1710,25 +2173,23 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             for (uint32 i = 0; i < state->uiState.selectedObjectCount; i++)
             {
                 uint32 objectId = state->uiState.selectedObjectIds[i];
-                for (uint32 j = 0; j < state->previewDocState.objectInstanceCount; j++)
+                int32 index = objectStoreFind(&state->previewDocState.objects, objectId);
+                if (index >= 0)
                 {
-                    if (objectId == state->previewDocState.objectIds[j])
-                    {
-                        ObjectTransform *instance = &state->previewDocState.objectTransforms[j];
-                        foundObjects++;
-                        manipulatorHandlePos += instance->position;
-                        break;
-                    }
+                    foundObjects++;
+                    manipulatorHandlePos += objectStoreGetPosition(&state->previewDocState.objects, index);
                 }
             }
             manipulatorHandlePos /= (float)foundObjects;
 
+#if DEBUG_SHOW_PICKING_BUFFER
             RenderEffect *quadIdEffect =
                 rendererCreateEffect(arena, editorAssets->quadShaderId, EFFECT_BLEND_ALPHA_BLEND);
+            RenderEffect *handleIdEffect;
+#endif
 
             float handleDim = 16;
             rect2 handleQuad;
-            RenderEffect *handleIdEffect;
             ManipulatorInteractionMode mode;
             bool isHot;
             glm::vec2 offsetHandleScreenPos;
@@ -1743,9 +2204,15 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             isHot = viewState->interactionState.hot.target.type == INTERACTION_TARGET_MANIPULATOR
                 && viewState->interactionState.hot.target.id == (void *)mode;
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(1, 1, 1));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
 
             handleDim = 8;
 
@@ -1758,9 +2225,15 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             isHot = viewState->interactionState.hot.target.type == INTERACTION_TARGET_MANIPULATOR
                 && viewState->interactionState.hot.target.id == (void *)mode;
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(1, 0, 0));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
 
             // Y-axis translation
             mode = MANIPULATOR_TRANSLATE_Y;
@@ -1771,9 +2244,15 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             isHot = viewState->interactionState.hot.target.type == INTERACTION_TARGET_MANIPULATOR
                 && viewState->interactionState.hot.target.id == (void *)mode;
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(0, 1, 0));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
 
             // Z-axis translation
             mode = MANIPULATOR_TRANSLATE_Z;
@@ -1784,9 +2263,15 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             isHot = viewState->interactionState.hot.target.type == INTERACTION_TARGET_MANIPULATOR
                 && viewState->interactionState.hot.target.id == (void *)mode;
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(0, 0, 1));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
 
             // XY-plane translation
             mode = MANIPULATOR_TRANSLATE_XY;
@@ -1798,9 +2283,15 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             rendererPushColoredQuad(sceneRq, rectCenterDim(handleScreenPos, 4), glm::vec3(0, 0, 1));
             handleQuad = rectCenterDim(handleScreenPos, handleDim);
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(0.5f, 0.5f, 0.5f));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
 
             // XZ-plane translation
             mode = MANIPULATOR_TRANSLATE_XZ;
@@ -1812,9 +2303,15 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             rendererPushColoredQuad(sceneRq, rectCenterDim(handleScreenPos, 4), glm::vec3(0, 1, 0));
             handleQuad = rectCenterDim(handleScreenPos, handleDim);
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(0.5f, 0.5f, 0.5f));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
 
             // YZ-plane translation
             mode = MANIPULATOR_TRANSLATE_YZ;
@@ -1826,34 +2323,77 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
             rendererPushColoredQuad(sceneRq, rectCenterDim(handleScreenPos, 4), glm::vec3(1, 0, 0));
             handleQuad = rectCenterDim(handleScreenPos, handleDim);
             rendererPushColoredQuad(sceneRq, handleQuad, isHot ? glm::vec3(1, 1, 0) : glm::vec3(0.5f, 0.5f, 0.5f));
+#if DEBUG_SHOW_PICKING_BUFFER
             handleIdEffect = rendererCreateEffectOverride(quadIdEffect);
             rendererSetEffectUint(handleIdEffect, "id", mode);
             rendererPushQuad(pickingRq, handleQuad, handleIdEffect);
+#endif
+            if (isPointInRect(handleQuad, mousePosScreen))
+            {
+                hotManipulatorMode = mode;
+            }
+        }
+
+        // draw marquee selection
+        InteractionState *interactionState = &viewState->interactionState;
+        if (interactionState->active.target.type == INTERACTION_TARGET_OBJECT && interactionState->active.state)
+        {
+            ObjectInteractionState *objectState = (ObjectInteractionState *)interactionState->active.state;
+            if (objectState->isMarqueeActive)
+            {
+                glm::vec2 marqueeMin = glm::min(objectState->startCursorPos, mousePosScreen);
+                glm::vec2 marqueeMax = glm::max(objectState->startCursorPos, mousePosScreen);
+                glm::vec2 marqueeDim = marqueeMax - marqueeMin;
+                glm::vec3 marqueeColor = glm::vec3(1, 1, 1);
+                rendererPushColoredQuad(sceneRq, rectMinDim(marqueeMin, glm::vec2(marqueeDim.x, 1)), marqueeColor);
+                rendererPushColoredQuad(sceneRq, rectMinDim(marqueeMin, glm::vec2(1, marqueeDim.y)), marqueeColor);
+                rendererPushColoredQuad(
+                    sceneRq, rectMaxDim(marqueeMax, glm::vec2(marqueeDim.x, 1)), marqueeColor);
+                rendererPushColoredQuad(
+                    sceneRq, rectMaxDim(marqueeMax, glm::vec2(1, marqueeDim.y)), marqueeColor);
+            }
         }
 
-        // identify hot object
+#if DEBUG_SHOW_PICKING_BUFFER
         rendererDraw(pickingRq);
-        uint32 cursorX = (uint32)mousePosScreen.x;
-        uint32 cursorY = (uint32)mousePosScreen.y;
-        TemporaryMemory pickingMemory = beginTemporaryMemory(arena);
-        GetPixelsResult pickedPixels =
-            rendererGetPixelsInRegion(arena, pickingRenderTarget->textureHandle, cursorX, cursorY, 1, 1);
-        assert(pickedPixels.count == 1);
-        uint32 pickedId = ((uint32 *)pickedPixels.pixels)[0];
-        endTemporaryMemory(&pickingMemory);
-
-        if (!pickedId || pickedId & 0x80000000)
-        {
-            // picked ID is a mesh instance
+#endif
+
+        // identify hot object, the manipulator handles are drawn over the objects so they take priority
+        if (hotManipulatorMode != MANIPULATOR_UNKNOWN)
+        {
             viewState->interactionState.nextHot = {};
-            viewState->interactionState.nextHot.target.type = INTERACTION_TARGET_OBJECT;
-            viewState->interactionState.nextHot.target.id = (void *)((uint64)pickedId);
+            viewState->interactionState.nextHot.target.type = INTERACTION_TARGET_MANIPULATOR;
+            viewState->interactionState.nextHot.target.id = (void *)((uint64)hotManipulatorMode);
         }
         else
         {
-            // picked ID is a manipulator
+            TIMED_BLOCK("Pick Objects");
+
+            uint32 pickedId = 0;
+            if (hoverCache->isObjectHitValid)
+            {
+                state->hoverHitCacheStats.hitCount++;
+                pickedId = hoverCache->objectHitId;
+            }
+            else
+            {
+                state->hoverHitCacheStats.missCount++;
+
+                BvhRaycastHit hit;
+                if (bvhRaycast(&sceneState->objectBvh, viewState->cameraPos, mouseRayDir, FLT_MAX,
+                        BVH_RAYCAST_CLOSEST_HIT, raycastObjectBvhLeaf, sceneState, &hit))
+                {
+                    RenderMeshInstance *instance =
+                        objectInstanceStoreGetInstance(&sceneState->objectInstances, hit.primitiveIndex);
+                    pickedId = instance->id;
+                }
+
+                hoverCache->isObjectHitValid = true;
+                hoverCache->objectHitId = pickedId;
+            }
+
             viewState->interactionState.nextHot = {};
-            viewState->interactionState.nextHot.target.type = INTERACTION_TARGET_MANIPULATOR;
+            viewState->interactionState.nextHot.target.type = INTERACTION_TARGET_OBJECT;
             viewState->interactionState.nextHot.target.id = (void *)((uint64)pickedId);
         }
     }
@@ -1866,7 +2406,7 @@ API_EXPORT EDITOR_RENDER_SCENE_VIEW(editorRenderSceneView)
     RenderEffect *compositeEffect = 0;
     if (state->uiState.currentContext == EDITOR_CTX_OBJECTS)
     {
-#if 0
+#if DEBUG_SHOW_PICKING_BUFFER
         compositeEffect =
             rendererCreateEffect(arena, editorAssets->quadShaderIdVisualiser, EFFECT_BLEND_ALPHA_BLEND);
         rendererSetEffectTexture(compositeEffect, 0, pickingRenderTarget->textureHandle);
@@ -1925,6 +2465,146 @@ API_EXPORT EDITOR_GET_UI_STATE(editorGetUiState)
     return &state->uiState;
 }
 
+API_EXPORT EDITOR_GET_HEIGHTMAP_READBACK_STATS(editorGetHeightmapReadbackStats)
+{
+    EditorState *state = (EditorState *)memory->arena.baseAddress;
+    return &state->heightmapReadbacks.stats;
+}
+
+API_EXPORT EDITOR_GET_HOVER_HIT_CACHE_STATS(editorGetHoverHitCacheStats)
+{
+    EditorState *state = (EditorState *)memory->arena.baseAddress;
+    return &state->hoverHitCacheStats;
+}
+
+API_EXPORT EDITOR_GET_OBJECT_TRANSFORM_STATS(editorGetObjectTransformStats)
+{
+    EditorState *state = (EditorState *)memory->arena.baseAddress;
+    return &state->objectTransformStats;
+}
+
+API_EXPORT EDITOR_GET_OBJECT_CULLING_STATS(editorGetObjectCullingStats)
+{
+    EditorState *state = (EditorState *)memory->arena.baseAddress;
+    return &state->objectCullingStats;
+}
+
+#define RAYCAST_BATCH_RAYS_PER_JOB 256
+
+struct RaycastBatchJob
+{
+    SceneState *sceneState;
+    EditorRay *rays;
+    EditorRaycastResult *results;
+    uint32 firstRay;
+    uint32 rayCount;
+
+    // each job sorts the terrain tiles for its rays in its own range of entries
+    TerrainTileRayEntry *tileEntries;
+};
+
+PLATFORM_JOB(raycastBatchJob)
+{
+    RaycastBatchJob *batch = (RaycastBatchJob *)context;
+    SceneState *sceneState = batch->sceneState;
+    TerrainTileRayEntry *tileEntries = &batch->tileEntries[jobIndex * sceneState->terrainTileCount];
+
+    uint32 firstRay = batch->firstRay + (jobIndex * RAYCAST_BATCH_RAYS_PER_JOB);
+    uint32 endRay = min(firstRay + RAYCAST_BATCH_RAYS_PER_JOB, batch->rayCount);
+    for (uint32 i = firstRay; i < endRay; i++)
+    {
+        EditorRay *ray = &batch->rays[i];
+        EditorRaycastResult *result = &batch->results[i];
+        *result = {};
+        result->hitType = RAYCAST_HIT_NONE;
+        result->distance = FLT_MAX;
+        result->tileIndex = -1;
+
+        HeightfieldRaycastHit terrainHit;
+        TerrainTile *hitTile =
+            raycastTerrain(sceneState, ray->origin, ray->direction, tileEntries, 0, &terrainHit);
+        if (hitTile)
+        {
+            glm::vec3 *triangle = terrainHit.triangle;
+            glm::vec3 normal = glm::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]);
+
+            result->hitType = RAYCAST_HIT_TERRAIN;
+            result->distance = terrainHit.distance;
+            result->normal = glm::normalize(normal.y < 0 ? -normal : normal);
+            result->tileIndex = (int32)(hitTile - sceneState->terrainTiles);
+        }
+
+        // only objects in front of the terrain hit can be hit
+        BvhRaycastHit objectHit;
+        if (bvhRaycast(&sceneState->objectBvh, ray->origin, ray->direction, result->distance,
+                BVH_RAYCAST_CLOSEST_HIT, raycastObjectBvhLeaf, sceneState, &objectHit))
+        {
+            result->hitType = RAYCAST_HIT_OBJECT;
+            result->distance = objectHit.distance;
+            result->normal = glm::normalize(
+                glm::dot(objectHit.normal, ray->direction) > 0 ? -objectHit.normal : objectHit.normal);
+            result->tileIndex = -1;
+            result->objectId =
+                objectInstanceStoreGetInstance(&sceneState->objectInstances, objectHit.primitiveIndex)->id;
+        }
+
+        if (result->hitType != RAYCAST_HIT_NONE)
+        {
+            result->position = ray->origin + (ray->direction * result->distance);
+        }
+    }
+}
+
+API_EXPORT EDITOR_RAYCAST_BATCH(editorRaycastBatch)
+{
+    TIMED_BLOCK("Raycast Batch");
+
+    EditorState *state = (EditorState *)memory->arena.baseAddress;
+    SceneState *sceneState = &state->sceneState;
+    if (rayCount == 0)
+    {
+        return 0;
+    }
+
+    // this is a read-only query of the scene as of the last update, which is what rebuilds the object BVH
+    assert(!sceneState->rockMeshBvh || (!sceneState->isObjectBvhDirty && !sceneState->isObjectBvhRefitNeeded));
+
+    MemoryArena *arena = &state->raycastArena;
+    TemporaryMemory batchMemory = beginTemporaryMemory(arena);
+
+    // large batches are split into passes that fit the jobs' tile entries in the raycast arena
+    uint32 tileEntriesPerJob = max(sceneState->terrainTileCount, 1u);
+    uint64 jobMemorySize = tileEntriesPerJob * sizeof(TerrainTileRayEntry);
+    uint32 maxJobsPerPass = (uint32)((arena->size - arena->used) / jobMemorySize);
+    assert(maxJobsPerPass > 0);
+
+    RaycastBatchJob batch;
+    batch.sceneState = sceneState;
+    batch.rays = rays;
+    batch.results = results;
+    batch.rayCount = rayCount;
+    batch.tileEntries = pushArray(arena, TerrainTileRayEntry, maxJobsPerPass * tileEntriesPerJob);
+    uint32 raysPerPass = maxJobsPerPass * RAYCAST_BATCH_RAYS_PER_JOB;
+    for (batch.firstRay = 0; batch.firstRay < rayCount; batch.firstRay += raysPerPass)
+    {
+        uint32 remainingRayCount = rayCount - batch.firstRay;
+        uint32 jobCount = (remainingRayCount + RAYCAST_BATCH_RAYS_PER_JOB - 1) / RAYCAST_BATCH_RAYS_PER_JOB;
+        Platform.parallelFor(min(jobCount, maxJobsPerPass), raycastBatchJob, &batch);
+    }
+
+    endTemporaryMemory(&batchMemory);
+
+    uint32 hitCount = 0;
+    for (uint32 i = 0; i < rayCount; i++)
+    {
+        if (results[i].hitType != RAYCAST_HIT_NONE)
+        {
+            hitCount++;
+        }
+    }
+    return hitCount;
+}
+
 API_EXPORT EDITOR_GET_IMPORTED_HEIGHTMAP_ASSET_HANDLE(editorGetImportedHeightmapAssetHandle)
 {
     EditorState *state = (EditorState *)memory->arena.baseAddress;
@@ -1940,37 +2620,24 @@ API_EXPORT EDITOR_SAVE_HEIGHTMAP(editorSaveHeightmap)
 
     // todo: make this work with more than 4 tiles
     assert(state->sceneState.terrainTileCount == 4);
-    TerrainTile *tile;
-    RenderTarget *target;
-    GetPixelsResult getPixelsResult;
-    uint64 pixelCount;
 
+    // the CPU copies of the committed heightmaps are always up to date so there is no need to read them back
     uint32 dim = HEIGHTMAP_DIM - (2 * HEIGHTMAP_OVERLAP_IN_TEXELS);
     uint32 overlap = HEIGHTMAP_OVERLAP_IN_TEXELS;
+    uint32 firstPixel = (overlap * HEIGHTMAP_DIM) + overlap;
+    uint64 pixelCount = dim * dim;
 
-    tile = &state->sceneState.terrainTiles[0];
-    target = tile->committedHeightmap;
-    getPixelsResult = rendererGetPixelsInRegion(arena, target->textureHandle, overlap, overlap, dim, dim);
-    uint16 *topLeftPixels = (uint16 *)getPixelsResult.pixels;
-    pixelCount = getPixelsResult.count;
+    TerrainTile *tile = &state->sceneState.terrainTiles[0];
+    uint16 *topLeftPixels = &tile->brushBuffers.committedHeightmap[firstPixel];
 
     tile = tile->tileToRight;
-    target = tile->committedHeightmap;
-    getPixelsResult = rendererGetPixelsInRegion(arena, target->textureHandle, overlap, overlap, dim, dim);
-    uint16 *topRightPixels = (uint16 *)getPixelsResult.pixels;
-    assert(getPixelsResult.count == pixelCount);
+    uint16 *topRightPixels = &tile->brushBuffers.committedHeightmap[firstPixel];
 
     tile = tile->tileBelow;
-    target = tile->committedHeightmap;
-    getPixelsResult = rendererGetPixelsInRegion(arena, target->textureHandle, overlap, overlap, dim, dim);
-    uint16 *bottomRightPixels = (uint16 *)getPixelsResult.pixels;
-    assert(getPixelsResult.count == pixelCount);
+    uint16 *bottomRightPixels = &tile->brushBuffers.committedHeightmap[firstPixel];
 
     tile = tile->tileToLeft;
-    target = tile->committedHeightmap;
-    getPixelsResult = rendererGetPixelsInRegion(arena, target->textureHandle, overlap, overlap, dim, dim);
-    uint16 *bottomLeftPixels = (uint16 *)getPixelsResult.pixels;
-    assert(getPixelsResult.count == pixelCount);
+    uint16 *bottomLeftPixels = &tile->brushBuffers.committedHeightmap[firstPixel];
 
     uint64 outputPixelCount = pixelCount * 4;
     uint16 *outputPixels = pushArray(arena, uint16, outputPixelCount);
@@ -1979,21 +2646,21 @@ API_EXPORT EDITOR_SAVE_HEIGHTMAP(editorSaveHeightmap)
     {
         memcpy(dstRow, topLeftPixels, dim * sizeof(uint16));
         dstRow += dim;
-        topLeftPixels += dim;
+        topLeftPixels += HEIGHTMAP_DIM;
 
         memcpy(dstRow, topRightPixels, dim * sizeof(uint16));
         dstRow += dim;
-        topRightPixels += dim;
+        topRightPixels += HEIGHTMAP_DIM;
     }
     for (uint32 y = 0; y < dim; y++)
     {
         memcpy(dstRow, bottomLeftPixels, dim * sizeof(uint16));
         dstRow += dim;
-        bottomLeftPixels += dim;
+        bottomLeftPixels += HEIGHTMAP_DIM;
 
         memcpy(dstRow, bottomRightPixels, dim * sizeof(uint16));
         dstRow += dim;
-        bottomRightPixels += dim;
+        bottomRightPixels += HEIGHTMAP_DIM;
     }
 
     Platform.writeEntireFile(filePath, outputPixels, outputPixelCount * sizeof(uint16));
@@ -2088,12 +2755,10 @@ API_EXPORT EDITOR_GET_OBJECT_PROPERTY(editorGetObjectProperty)
     EditorState *state = (EditorState *)memory->arena.baseAddress;
     EditorDocumentState *docState = &state->previewDocState;
 
-    for (uint32 i = 0; i < docState->objectInstanceCount; i++)
+    int32 index = objectStoreFind(&docState->objects, objectId);
+    if (index >= 0)
     {
-        if (docState->objectIds[i] == objectId)
-        {
-            return *getObjectProperty(docState, i, property);
-        }
+        return *objectStoreGetProperty(&docState->objects, index, property);
     }
     return 0;
 }
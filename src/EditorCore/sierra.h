@@ -3,25 +3,35 @@
 
 #include "sierra_platform.h"
 #include "sierra_math.h"
+#include "sierra_simd.h"
 #include "sierra_renderer_common.h"
 #include "sierra_renderer.h"
+#include "sierra_geometry.h"
+#include "sierra_bvh.h"
 #include "sierra_assets.h"
 #include "sierra_transactions.h"
+#include "sierra_objects.h"
+#include "sierra_brush.h"
+#include "sierra_heightfield.h"
 #include "sierra_heightmap.h"
 
 // feature flags
 #define FEATURE_TERRAIN_MATERIALS 0
 #define FEATURE_OBJECTS 0
+#define FEATURE_CPU_SMOOTH_BRUSH 1
+
+// debug flags
+#define DEBUG_SHOW_PICKING_BUFFER 0
+#define DEBUG_VERIFY_CPU_BRUSH 0
 
 #define MAX_MATERIAL_COUNT 8
-#define BRUSH_QUAD_INSTANCE_BUFFER_STRIDE (2 * sizeof(float))
-#define BRUSH_QUAD_INSTANCE_BUFFER_SIZE (MAX_BRUSH_QUADS * BRUSH_QUAD_INSTANCE_BUFFER_STRIDE)
-#define MAX_OBJECT_INSTANCES 32
 
-#define HEIGHTFIELD_SAMPLES_PER_EDGE 32
+// one sample every 4 heightmap texels
+#define HEIGHTFIELD_SAMPLES_PER_EDGE 236
 #define HEIGHTMAP_DIM 1024
 #define HEIGHTMAP_OVERLAP_IN_TEXELS 42.0f
 #define TERRAIN_TILE_LENGTH_IN_WORLD_UNITS 64.0f
+#define TERRAIN_TILE_SUB_BOUNDS_PER_EDGE 4
 
 enum EditorContext
 {
@@ -63,26 +73,22 @@ struct EditorUiState
 {
     EditorContext currentContext;
 
+    // the selection grows with the number of objects, so every object can be selected at once
     uint32 *selectedObjectIds;
     uint32 selectedObjectCount;
+    uint32 maxSelectedObjectCount;
 
     TerrainBrushTool terrainBrushTool;
     float terrainBrushRadius;
     float terrainBrushFalloff;
     float terrainBrushStrength;
+    float terrainBrushSmoothRadius;
 
     float sceneLightDirection;
 
     EditorDebugState debugState;
 };
 
-struct ObjectTransform
-{
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
-};
-
 enum InteractionTargetType
 {
     INTERACTION_TARGET_NONE,
@@ -110,6 +116,43 @@ struct InteractionState
     MemoryArena activeArena;
 };
 
+// result of the last hover raycast, which is reused while the camera, cursor and scene are unchanged
+struct HoverHitCache
+{
+    glm::mat4 cameraTransform;
+    glm::vec2 cursorPosNdc;
+    uint32 terrainVersion;
+    uint32 objectVersion;
+
+    // the terrain tile that was hit (or -1)
+    bool isTerrainHitValid;
+    int32 terrainHitTileIndex;
+    HeightfieldRaycastHit terrainHit;
+
+    // the ID of the object that was picked (or 0)
+    bool isObjectHitValid;
+    uint32 objectHitId;
+};
+struct HoverHitCacheStats
+{
+    // hover raycasts that reused the cached result and those that had to be recomputed
+    uint32 hitCount;
+    uint32 missCount;
+};
+
+struct ObjectTransformStats
+{
+    // object world matrices that were recomputed last frame because the object changed and those that were kept
+    uint32 rebuiltCount;
+    uint32 reusedCount;
+};
+struct ObjectCullingStats
+{
+    // object instances drawn last frame because they intersect a scene view's frustum and those that were not
+    uint32 visibleCount;
+    uint32 culledCount;
+};
+
 struct SceneViewState
 {
     float orbitCameraDistance;
@@ -126,34 +169,107 @@ struct SceneViewState
     RenderTarget *pickingRenderTarget;
 
     InteractionState interactionState;
+    HoverHitCache hoverHitCache;
 };
 
 struct TerrainTile
 {
     glm::vec2 center;
     float maxHeight;
-    float *heights;
+    Heightfield heightfield;
+
+    // texel region of the working heightmap that changed since the heightfield was last updated
+    rect2 heightfieldDirtyRect;
+
+    // world-space bounds of the heightfield, refreshed whenever its heights change
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+
+    // height ranges of a grid of equally sized regions of the tile, which bound it tighter than the tile's bounds
+    float subBoundsMinHeights[TERRAIN_TILE_SUB_BOUNDS_PER_EDGE * TERRAIN_TILE_SUB_BOUNDS_PER_EDGE];
+    float subBoundsMaxHeights[TERRAIN_TILE_SUB_BOUNDS_PER_EDGE * TERRAIN_TILE_SUB_BOUNDS_PER_EDGE];
 
     RenderTarget *committedHeightmap;
     RenderTarget *workingBrushInfluenceMask;
-    RenderTarget *workingPrevBrushInfluenceMask;
     RenderTarget *workingHeightmap;
     RenderTarget *previewBrushInfluenceMask;
     RenderTarget *previewHeightmap;
+    BrushTileState brushState;
+
+    /*
+     * CPU copies of the render targets. The committed and working heightmaps are always kept in
+     * sync, the rest are only used by brushes that are composited on the CPU.
+     */
+    BrushTileBuffers brushBuffers;
+    bool isBrushCompositedOnCpu;
 
     TerrainTile *tileToLeft;
     TerrainTile *tileToRight;
     TerrainTile *tileBelow;
 };
 
+struct TerrainTileRayEntry
+{
+    TerrainTile *tile;
+    float enterDistance;
+};
+
+struct EditorRay
+{
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+enum RaycastHitType
+{
+    RAYCAST_HIT_NONE,
+    RAYCAST_HIT_TERRAIN,
+    RAYCAST_HIT_OBJECT
+};
+struct EditorRaycastResult
+{
+    RaycastHitType hitType;
+
+    // distance along the ray in multiples of the ray direction's length
+    float distance;
+    glm::vec3 position;
+    glm::vec3 normal;
+
+    // the terrain tile that was hit (or -1) and the ID of the object that was hit (or 0)
+    int32 tileIndex;
+    uint32 objectId;
+};
+
 struct SceneState
 {
     TerrainTile *terrainTiles;
     uint32 terrainTileCount;
 
     uint32 nextObjectId;
-    RenderMeshInstance objectInstanceData[MAX_OBJECT_INSTANCES];
-    uint32 objectInstanceCount;
+    ObjectInstanceStore objectInstances;
+
+    /*
+     * Used to pick objects on the CPU. The object BVH is rebuilt when objects are added or removed or the
+     * rock mesh changes, and only refitted while objects are being moved until they stop changing.
+     */
+    MeshBvh *rockMeshBvh;
+    uint8 rockMeshVersion;
+    Bvh objectBvh;
+    bool isObjectBvhDirty;
+    bool isObjectBvhRefitNeeded;
+    bool wasObjectBvhRefitted;
+
+    // the number of object instances with up-to-date bounds, none until the rock mesh is loaded
+    uint32 objectBoundsCount;
+
+    // IDs of the objects whose instances were updated last frame because they were changed
+    uint32 *lastChangedObjectIds;
+    uint32 lastChangedObjectIdCount;
+    uint32 maxLastChangedObjectIdCount;
+
+    // incremented whenever the terrain heightfields or the object BVH change, used to invalidate hover results
+    uint32 terrainVersion;
+    uint32 objectVersion;
 
     uint32 nextMaterialId;
 };
@@ -195,9 +311,7 @@ struct EditorDocumentState
     uint32 materialIds[MAX_MATERIAL_COUNT];
     RenderTerrainMaterial materials[MAX_MATERIAL_COUNT];
 
-    uint32 objectInstanceCount;
-    uint32 objectIds[MAX_OBJECT_INSTANCES];
-    ObjectTransform objectTransforms[MAX_OBJECT_INSTANCES];
+    ObjectStore objects;
 };
 
 struct EditorState
@@ -206,6 +320,8 @@ struct EditorState
 
     MemoryArena rendererArena;
     MemoryArena assetsArena;
+    MemoryArena objectsArena;
+    MemoryArena raycastArena;
 
     EditorAssets editorAssets;
     RenderContext *renderCtx;
@@ -215,6 +331,10 @@ struct EditorState
     uint8 importedHeightmapTextureVersion;
 
     RenderTarget *temporaryHeightmap;
+    HeightmapReadbackRing heightmapReadbacks;
+#if DEBUG_VERIFY_CPU_BRUSH
+    BrushVerificationStats brushVerificationStats;
+#endif
 
     // state related to the user interface e.g. current brush tool, brush radius etc.
     // can be directly read from and written to by the editor UI
@@ -229,6 +349,9 @@ struct EditorState
     EditorDocumentState previewDocState;
 
     SceneState sceneState;
+    HoverHitCacheStats hoverHitCacheStats;
+    ObjectTransformStats objectTransformStats;
+    ObjectCullingStats objectCullingStats;
 };
 
 struct EditorMemory
@@ -343,6 +466,21 @@ typedef EDITOR_SAVE_HEIGHTMAP(EditorSaveHeightmap);
 #define EDITOR_GET_UI_STATE(name) EditorUiState *name(EditorMemory *memory)
 typedef EDITOR_GET_UI_STATE(EditorGetUiState);
 
+#define EDITOR_GET_HEIGHTMAP_READBACK_STATS(name) HeightmapReadbackStats *name(EditorMemory *memory)
+typedef EDITOR_GET_HEIGHTMAP_READBACK_STATS(EditorGetHeightmapReadbackStats);
+
+#define EDITOR_GET_HOVER_HIT_CACHE_STATS(name) HoverHitCacheStats *name(EditorMemory *memory)
+typedef EDITOR_GET_HOVER_HIT_CACHE_STATS(EditorGetHoverHitCacheStats);
+#define EDITOR_GET_OBJECT_TRANSFORM_STATS(name) ObjectTransformStats *name(EditorMemory *memory)
+typedef EDITOR_GET_OBJECT_TRANSFORM_STATS(EditorGetObjectTransformStats);
+#define EDITOR_GET_OBJECT_CULLING_STATS(name) ObjectCullingStats *name(EditorMemory *memory)
+typedef EDITOR_GET_OBJECT_CULLING_STATS(EditorGetObjectCullingStats);
+
+// must not run at the same time as another batch or an update or render, the editor serializes these calls
+#define EDITOR_RAYCAST_BATCH(name)                                                                                \
+    uint32 name(EditorMemory *memory, EditorRay *rays, EditorRaycastResult *results, uint32 rayCount)
+typedef EDITOR_RAYCAST_BATCH(EditorRaycastBatch);
+
 #define EDITOR_ADD_MATERIAL(name) void name(EditorMemory *memory, TerrainMaterialProperties props)
 typedef EDITOR_ADD_MATERIAL(EditorAddMaterial);
 
@@ -339,6 +339,8 @@ void assetsLoadQueuedAssets(Assets *assets)
             }
             MeshAsset *mesh = reg->asset.mesh;
             fastObjLoadMesh(assets->arena, reg->fileState->relativePath, data, size, mesh);
+            meshBvhBuild(
+                &mesh->bvh, assets->arena, (float *)mesh->vertices, (uint32 *)mesh->indices, mesh->elementCount);
 
             mesh->handle = renderBackendCreateMesh(
                 assets->arena, mesh->vertices, mesh->vertexCount, mesh->indices, mesh->elementCount);
@@ -26,6 +26,9 @@ struct MeshAsset
     void *vertices;
     void *indices;
     MeshHandle handle;
+
+    // used to raycast the mesh on the CPU, built when the mesh is loaded
+    MeshBvh bvh;
 };
 struct LoadedAsset
 {
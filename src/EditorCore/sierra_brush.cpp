@@ -0,0 +1,1273 @@
+#include "sierra_brush.h"
+
+/*
+ * Every kernel below (apart from the box smooth, which is bound by its summed-area table lookups)
+ * has a scalar, SSE4 and AVX2 version. The vector versions perform exactly the same floating-point
+ * operations as the scalar version (without fused multiply-adds), so the output is identical
+ * regardless of which version runs. The scalar version is also used to process the tail of each row.
+ */
+
+// smooth shader constants, see quad_brush_blend_smooth.fs.glsl
+#define BRUSH_SMOOTH_SAMPLE_STEP_LENGTH 12.0f
+#define BRUSH_SMOOTH_OFFSET_INNER 1.3846153846f
+#define BRUSH_SMOOTH_OFFSET_OUTER 3.2307692308f
+#define BRUSH_SMOOTH_WEIGHT_CENTER 0.2270270270f
+#define BRUSH_SMOOTH_WEIGHT_INNER 0.3162162162f
+#define BRUSH_SMOOTH_WEIGHT_OUTER 0.0702702703f
+#define BRUSH_SMOOTH_TAP_COUNT 4
+
+struct BrushSmoothTap
+{
+    // each tap linearly interpolates between the texel at 'offset' and the texel after it
+    int32 offset;
+    float fraction;
+    float oneMinusFraction;
+    float weight;
+};
+struct BrushSmoothRowTaps
+{
+    // pointers to the lower/upper texels of each tap, aligned so that [x] is the sample for texel x
+    uint16 *baseLower[BRUSH_SMOOTH_TAP_COUNT];
+    uint16 *baseUpper[BRUSH_SMOOTH_TAP_COUNT];
+    uint16 *influenceLower[BRUSH_SMOOTH_TAP_COUNT];
+    uint16 *influenceUpper[BRUSH_SMOOTH_TAP_COUNT];
+};
+
+void getBrushSmoothTaps(BrushSmoothTap *taps)
+{
+    float offsetInner = BRUSH_SMOOTH_SAMPLE_STEP_LENGTH * BRUSH_SMOOTH_OFFSET_INNER;
+    float offsetOuter = BRUSH_SMOOTH_SAMPLE_STEP_LENGTH * BRUSH_SMOOTH_OFFSET_OUTER;
+    float offsets[BRUSH_SMOOTH_TAP_COUNT] = {-offsetOuter, -offsetInner, offsetInner, offsetOuter};
+    float weights[BRUSH_SMOOTH_TAP_COUNT] = {BRUSH_SMOOTH_WEIGHT_OUTER, BRUSH_SMOOTH_WEIGHT_INNER,
+        BRUSH_SMOOTH_WEIGHT_INNER, BRUSH_SMOOTH_WEIGHT_OUTER};
+
+    for (uint32 i = 0; i < BRUSH_SMOOTH_TAP_COUNT; i++)
+    {
+        float lower = floorf(offsets[i]);
+
+        BrushSmoothTap *tap = &taps[i];
+        tap->offset = (int32)lower;
+        tap->fraction = offsets[i] - lower;
+        tap->oneMinusFraction = 1 - tap->fraction;
+        tap->weight = weights[i];
+
+        assert(tap->offset >= -BRUSH_SMOOTH_MAX_TAP_TEXELS);
+        assert(tap->offset + 1 <= BRUSH_SMOOTH_MAX_TAP_TEXELS);
+    }
+}
+
+// dirty regions
+
+rect2 brushGetSegmentQuad(BrushSegment *segment, float radius)
+{
+    glm::vec2 min = glm::min(segment->start, segment->end) - radius;
+    glm::vec2 max = glm::max(segment->start, segment->end) + radius;
+    return rectMinMax(min, max);
+}
+
+rect2 brushGetStrokeBounds(
+    BrushSegment *segments, uint32 segmentCount, BrushSegment *previewSegment, float radius)
+{
+    rect2 bounds = {};
+    for (uint32 i = 0; i < segmentCount; i++)
+    {
+        bounds = rectUnion(bounds, brushGetSegmentQuad(&segments[i], radius));
+    }
+    if (previewSegment)
+    {
+        bounds = rectUnion(bounds, brushGetSegmentQuad(previewSegment, radius));
+    }
+    return bounds;
+}
+
+bool brushIsTileAffected(BrushTileState *state, bool isNewStroke, rect2 strokeBounds, rect2 tileBounds)
+{
+    // the previous preview and stroke still need to be erased from tiles the stroke has moved away from
+    if (!isRectEmpty(state->previewMaskRect) || (isNewStroke && !isRectEmpty(state->workingMaskRect)))
+    {
+        return true;
+    }
+    return rectsIntersect(strokeBounds, tileBounds);
+}
+
+rect2 getBrushSegmentTexelBounds(
+    BrushSegment *segments, uint32 segmentCount, float radius, glm::vec2 offset, uint32 dim)
+{
+    rect2 bounds = brushGetStrokeBounds(segments, segmentCount, 0, radius);
+    bounds.x -= offset.x;
+    bounds.y -= offset.y;
+    return rectIntersection(rectRoundOutward(bounds), rectMinDim(0, 0, (float)dim, (float)dim));
+}
+
+BrushTileUpdate brushUpdateTileRegions(BrushTileState *state,
+    uint32 dim,
+    BrushParameters *params,
+    bool isNewStroke,
+    BrushSegment *segments,
+    uint32 segmentCount,
+    BrushSegment *previewSegment,
+    glm::vec2 offset)
+{
+    BrushTileUpdate result = {};
+    rect2 tileBounds = rectMinDim(0, 0, (float)dim, (float)dim);
+
+    /*
+     * The heightmaps only differ from their base heightmap where the influence mask is non-zero,
+     * except for the Gaussian smooth which also reads the influence mask of neighbouring texels.
+     */
+    rect2 stampRect = getBrushSegmentTexelBounds(segments, segmentCount, params->radius, offset, dim);
+    rect2 affectedRect = stampRect;
+    if (params->blendOperation == BRUSH_BLEND_SMOOTH)
+    {
+        affectedRect = rectIntersection(
+            rectExpand(stampRect, BRUSH_SMOOTH_MAX_TAP_TEXELS, BRUSH_SMOOTH_MAX_TAP_TEXELS), tileBounds);
+    }
+
+    if (isNewStroke)
+    {
+        // erase the previous stroke
+        result.workingMaskClearRect = state->workingMaskRect;
+        result.workingHeightmapRect = rectUnion(state->workingMaskRect, affectedRect);
+        state->workingMaskRect = stampRect;
+    }
+    else
+    {
+        result.workingHeightmapRect = affectedRect;
+        state->workingMaskRect = rectUnion(state->workingMaskRect, stampRect);
+    }
+    state->uncommittedRect = rectUnion(state->uncommittedRect, state->workingMaskRect);
+
+    // the preview heightmap is based on the working heightmap so must also pick up its changes
+    rect2 previewStampRect = {};
+    if (previewSegment)
+    {
+        previewStampRect = getBrushSegmentTexelBounds(previewSegment, 1, params->radius, offset, dim);
+    }
+    result.previewMaskClearRect = state->previewMaskRect;
+    result.previewHeightmapRect = rectUnion(
+        rectUnion(state->previewMaskRect, previewStampRect), result.workingHeightmapRect);
+    state->previewMaskRect = previewStampRect;
+
+    return result;
+}
+
+rect2 brushGetSmoothHorizontalPassRect(rect2 outputRect, uint32 dim)
+{
+    // the vertical pass reads the output of the horizontal pass from the rows above and below
+    rect2 tileBounds = rectMinDim(0, 0, (float)dim, (float)dim);
+    return rectIntersection(rectExpand(outputRect, 0, BRUSH_SMOOTH_MAX_TAP_TEXELS), tileBounds);
+}
+
+// influence mask, see quad_brush_mask.fs.glsl
+
+// 8-point Gauss-Legendre quadrature, the nodes are symmetric around zero
+global_variable float BrushSegmentQuadratureNodes[4] = {
+    0.1834346425f, 0.5255324099f, 0.7966664774f, 0.9602898565f};
+global_variable float BrushSegmentQuadratureWeights[4] = {
+    0.3626837834f, 0.3137066459f, 0.2223810345f, 0.1012285363f};
+
+struct BrushSegmentRaster
+{
+    // all distances are measured in brush radii, relative to the start of the segment
+    glm::vec2 startTexel;
+    float invRadius;
+    glm::vec2 direction;
+    float length;
+
+    bool isIntegrated;
+    float oneMinusFalloff;
+    float strength;
+    BrushMaskBlendMode blendMode;
+};
+
+inline float getBrushFalloff(float r, float oneMinusFalloff)
+{
+    float d = 1 - fminf(r, 1);
+    float value = (cosApprox(d * 3.14f) * 0.5f) + 0.5f;
+    value = (1 - value) / oneMinusFalloff;
+    return fmaxf(fminf(value, 1.0f), 0.0f);
+}
+inline __m128 getBrushFalloff4(__m128 r, __m128 oneMinusFalloff)
+{
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 d = _mm_sub_ps(one, _mm_min_ps(r, one));
+    __m128 value = _mm_add_ps(_mm_mul_ps(cosApprox4(_mm_mul_ps(d, _mm_set1_ps(3.14f))), half), half);
+    value = _mm_div_ps(_mm_sub_ps(one, value), oneMinusFalloff);
+    return _mm_max_ps(_mm_min_ps(value, one), _mm_setzero_ps());
+}
+inline __m256 getBrushFalloff8(__m256 r, __m256 oneMinusFalloff)
+{
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 d = _mm256_sub_ps(one, _mm256_min_ps(r, one));
+    __m256 value = _mm256_add_ps(_mm256_mul_ps(cosApprox8(_mm256_mul_ps(d, _mm256_set1_ps(3.14f))), half), half);
+    value = _mm256_div_ps(_mm256_sub_ps(one, value), oneMinusFalloff);
+    return _mm256_max_ps(_mm256_min_ps(value, one), _mm256_setzero_ps());
+}
+
+void segmentRowScalar(uint16 *dst, uint32 count, int32 firstPixelX, float pixelCenterY, BrushSegmentRaster *seg)
+{
+    float relY = (pixelCenterY - seg->startTexel.y) * seg->invRadius;
+    for (uint32 i = 0; i < count; i++)
+    {
+        float pixelCenterX = (float)(firstPixelX + (int32)i) + 0.5f;
+        float relX = (pixelCenterX - seg->startTexel.x) * seg->invRadius;
+        float along = (relX * seg->direction.x) + (relY * seg->direction.y);
+        float across = (relX * seg->direction.y) - (relY * seg->direction.x);
+        float acrossSq = across * across;
+
+        float value;
+        if (seg->isIntegrated)
+        {
+            // integrate the falloff over the part of the segment within one radius of the pixel
+            float halfChord = sqrtf(fmaxf(1 - acrossSq, 0));
+            float t0 = fmaxf(along - halfChord, 0);
+            float t1 = fminf(along + halfChord, seg->length);
+            float halfWidth = fmaxf((t1 - t0) * 0.5f, 0);
+            float midOffset = ((t0 + t1) * 0.5f) - along;
+
+            float sum = 0;
+            for (uint32 n = 0; n < 4; n++)
+            {
+                float nodeOffset = halfWidth * BrushSegmentQuadratureNodes[n];
+                float u0 = midOffset - nodeOffset;
+                float u1 = midOffset + nodeOffset;
+                float r0 = sqrtf(acrossSq + (u0 * u0));
+                float r1 = sqrtf(acrossSq + (u1 * u1));
+                float nodeSum =
+                    getBrushFalloff(r0, seg->oneMinusFalloff) + getBrushFalloff(r1, seg->oneMinusFalloff);
+                sum += nodeSum * BrushSegmentQuadratureWeights[n];
+            }
+            value = sum * halfWidth;
+        }
+        else
+        {
+            float u = along - fmaxf(fminf(along, seg->length), 0);
+            float r = sqrtf(acrossSq + (u * u));
+            value = getBrushFalloff(r, seg->oneMinusFalloff);
+        }
+        value = value * seg->strength;
+
+        float existing = decodeUnorm16(dst[i]);
+        float result = seg->blendMode == BRUSH_MASK_BLEND_MAX ? fmaxf(existing, value) : existing + value;
+        dst[i] = encodeUnorm16(result);
+    }
+}
+void segmentRowSse4(uint16 *dst, uint32 count, int32 firstPixelX, float pixelCenterY, BrushSegmentRaster *seg)
+{
+    __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 startX = _mm_set1_ps(seg->startTexel.x);
+    __m128 invRadius = _mm_set1_ps(seg->invRadius);
+    __m128 relY = _mm_set1_ps((pixelCenterY - seg->startTexel.y) * seg->invRadius);
+    __m128 directionX = _mm_set1_ps(seg->direction.x);
+    __m128 directionY = _mm_set1_ps(seg->direction.y);
+    __m128 length = _mm_set1_ps(seg->length);
+    __m128 oneMinusFalloff = _mm_set1_ps(seg->oneMinusFalloff);
+    __m128 strength = _mm_set1_ps(seg->strength);
+
+    uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pixelX = _mm_add_epi32(_mm_set1_epi32(firstPixelX + (int32)i), laneOffsets);
+        __m128 pixelCenterX = _mm_add_ps(_mm_cvtepi32_ps(pixelX), half);
+        __m128 relX = _mm_mul_ps(_mm_sub_ps(pixelCenterX, startX), invRadius);
+        __m128 along = _mm_add_ps(_mm_mul_ps(relX, directionX), _mm_mul_ps(relY, directionY));
+        __m128 across = _mm_sub_ps(_mm_mul_ps(relX, directionY), _mm_mul_ps(relY, directionX));
+        __m128 acrossSq = _mm_mul_ps(across, across);
+
+        __m128 value;
+        if (seg->isIntegrated)
+        {
+            __m128 halfChord = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, acrossSq), zero));
+            __m128 t0 = _mm_max_ps(_mm_sub_ps(along, halfChord), zero);
+            __m128 t1 = _mm_min_ps(_mm_add_ps(along, halfChord), length);
+            __m128 halfWidth = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(t1, t0), half), zero);
+            __m128 midOffset = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(t0, t1), half), along);
+
+            __m128 sum = zero;
+            for (uint32 n = 0; n < 4; n++)
+            {
+                __m128 nodeOffset = _mm_mul_ps(halfWidth, _mm_set1_ps(BrushSegmentQuadratureNodes[n]));
+                __m128 u0 = _mm_sub_ps(midOffset, nodeOffset);
+                __m128 u1 = _mm_add_ps(midOffset, nodeOffset);
+                __m128 r0 = _mm_sqrt_ps(_mm_add_ps(acrossSq, _mm_mul_ps(u0, u0)));
+                __m128 r1 = _mm_sqrt_ps(_mm_add_ps(acrossSq, _mm_mul_ps(u1, u1)));
+                __m128 nodeSum =
+                    _mm_add_ps(getBrushFalloff4(r0, oneMinusFalloff), getBrushFalloff4(r1, oneMinusFalloff));
+                sum = _mm_add_ps(sum, _mm_mul_ps(nodeSum, _mm_set1_ps(BrushSegmentQuadratureWeights[n])));
+            }
+            value = _mm_mul_ps(sum, halfWidth);
+        }
+        else
+        {
+            __m128 u = _mm_sub_ps(along, _mm_max_ps(_mm_min_ps(along, length), zero));
+            __m128 r = _mm_sqrt_ps(_mm_add_ps(acrossSq, _mm_mul_ps(u, u)));
+            value = getBrushFalloff4(r, oneMinusFalloff);
+        }
+        value = _mm_mul_ps(value, strength);
+
+        __m128 existing = decodeUnorm16x4(&dst[i]);
+        __m128 result =
+            seg->blendMode == BRUSH_MASK_BLEND_MAX ? _mm_max_ps(existing, value) : _mm_add_ps(existing, value);
+        encodeUnorm16x4(&dst[i], result);
+    }
+    segmentRowScalar(&dst[i], count - i, firstPixelX + (int32)i, pixelCenterY, seg);
+}
+void segmentRowAvx2(uint16 *dst, uint32 count, int32 firstPixelX, float pixelCenterY, BrushSegmentRaster *seg)
+{
+    __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 startX = _mm256_set1_ps(seg->startTexel.x);
+    __m256 invRadius = _mm256_set1_ps(seg->invRadius);
+    __m256 relY = _mm256_set1_ps((pixelCenterY - seg->startTexel.y) * seg->invRadius);
+    __m256 directionX = _mm256_set1_ps(seg->direction.x);
+    __m256 directionY = _mm256_set1_ps(seg->direction.y);
+    __m256 length = _mm256_set1_ps(seg->length);
+    __m256 oneMinusFalloff = _mm256_set1_ps(seg->oneMinusFalloff);
+    __m256 strength = _mm256_set1_ps(seg->strength);
+
+    uint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixelX = _mm256_add_epi32(_mm256_set1_epi32(firstPixelX + (int32)i), laneOffsets);
+        __m256 pixelCenterX = _mm256_add_ps(_mm256_cvtepi32_ps(pixelX), half);
+        __m256 relX = _mm256_mul_ps(_mm256_sub_ps(pixelCenterX, startX), invRadius);
+        __m256 along = _mm256_add_ps(_mm256_mul_ps(relX, directionX), _mm256_mul_ps(relY, directionY));
+        __m256 across = _mm256_sub_ps(_mm256_mul_ps(relX, directionY), _mm256_mul_ps(relY, directionX));
+        __m256 acrossSq = _mm256_mul_ps(across, across);
+
+        __m256 value;
+        if (seg->isIntegrated)
+        {
+            __m256 halfChord = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(one, acrossSq), zero));
+            __m256 t0 = _mm256_max_ps(_mm256_sub_ps(along, halfChord), zero);
+            __m256 t1 = _mm256_min_ps(_mm256_add_ps(along, halfChord), length);
+            __m256 halfWidth = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(t1, t0), half), zero);
+            __m256 midOffset = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(t0, t1), half), along);
+
+            __m256 sum = zero;
+            for (uint32 n = 0; n < 4; n++)
+            {
+                __m256 nodeOffset = _mm256_mul_ps(halfWidth, _mm256_set1_ps(BrushSegmentQuadratureNodes[n]));
+                __m256 u0 = _mm256_sub_ps(midOffset, nodeOffset);
+                __m256 u1 = _mm256_add_ps(midOffset, nodeOffset);
+                __m256 r0 = _mm256_sqrt_ps(_mm256_add_ps(acrossSq, _mm256_mul_ps(u0, u0)));
+                __m256 r1 = _mm256_sqrt_ps(_mm256_add_ps(acrossSq, _mm256_mul_ps(u1, u1)));
+                __m256 nodeSum =
+                    _mm256_add_ps(getBrushFalloff8(r0, oneMinusFalloff), getBrushFalloff8(r1, oneMinusFalloff));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(nodeSum, _mm256_set1_ps(BrushSegmentQuadratureWeights[n])));
+            }
+            value = _mm256_mul_ps(sum, halfWidth);
+        }
+        else
+        {
+            __m256 u = _mm256_sub_ps(along, _mm256_max_ps(_mm256_min_ps(along, length), zero));
+            __m256 r = _mm256_sqrt_ps(_mm256_add_ps(acrossSq, _mm256_mul_ps(u, u)));
+            value = getBrushFalloff8(r, oneMinusFalloff);
+        }
+        value = _mm256_mul_ps(value, strength);
+
+        __m256 existing = decodeUnorm16x8(&dst[i]);
+        __m256 result = seg->blendMode == BRUSH_MASK_BLEND_MAX ? _mm256_max_ps(existing, value)
+                                                               : _mm256_add_ps(existing, value);
+        encodeUnorm16x8(&dst[i], result);
+    }
+    segmentRowScalar(&dst[i], count - i, firstPixelX + (int32)i, pixelCenterY, seg);
+}
+
+void brushRasterizeSegment(
+    uint16 *mask, uint32 dim, BrushSegment *segment, glm::vec2 offset, BrushParameters *params)
+{
+    rect2 quad = brushGetSegmentQuad(segment, params->radius);
+    quad.x -= offset.x;
+    quad.y -= offset.y;
+
+    // only pixels whose centers lie within the quad are covered, matching GL rasterization rules
+    int32 minX = max((int32)ceilf(quad.x - 0.5f), 0);
+    int32 minY = max((int32)ceilf(quad.y - 0.5f), 0);
+    int32 maxX = min((int32)ceilf(quad.x + quad.width - 0.5f), (int32)dim);
+    int32 maxY = min((int32)ceilf(quad.y + quad.height - 0.5f), (int32)dim);
+    if (minX >= maxX || minY >= maxY)
+    {
+        return;
+    }
+
+    BrushSegmentRaster seg;
+    seg.startTexel = segment->start - offset;
+    seg.invRadius = 1.0f / params->radius;
+    glm::vec2 axis = (segment->end - segment->start) * seg.invRadius;
+    seg.length = segment->isDab ? 0 : glm::length(axis);
+    seg.direction = seg.length > 0 ? axis / seg.length : glm::vec2(1, 0);
+    seg.isIntegrated = !segment->isDab && params->maskBlendMode == BRUSH_MASK_BLEND_ADDITIVE;
+    seg.oneMinusFalloff = 1 - params->falloff;
+    seg.strength = segment->isDab ? params->dabStrength : params->strength;
+    seg.blendMode = params->maskBlendMode;
+
+    SimdLevel simdLevel = getSimdLevel();
+    uint32 count = maxX - minX;
+    for (int32 y = minY; y < maxY; y++)
+    {
+        float pixelCenterY = (float)y + 0.5f;
+        uint16 *dst = &mask[(y * dim) + minX];
+
+        switch (simdLevel)
+        {
+        case SIMD_LEVEL_AVX2:
+            segmentRowAvx2(dst, count, minX, pixelCenterY, &seg);
+            break;
+        case SIMD_LEVEL_SSE4:
+            segmentRowSse4(dst, count, minX, pixelCenterY, &seg);
+            break;
+        default:
+            segmentRowScalar(dst, count, minX, pixelCenterY, &seg);
+            break;
+        }
+    }
+}
+void brushDrawInfluenceMask(uint16 *mask,
+    uint32 dim,
+    BrushSegment *segments,
+    uint32 segmentCount,
+    glm::vec2 offset,
+    BrushParameters *params)
+{
+    for (uint32 i = 0; i < segmentCount; i++)
+    {
+        brushRasterizeSegment(mask, dim, &segments[i], offset, params);
+    }
+}
+
+// add / subtract
+
+void addSubRowScalar(uint16 *dst, uint16 *base, uint16 *influence, uint32 count, float blendSign)
+{
+    for (uint32 i = 0; i < count; i++)
+    {
+        float baseValue = decodeUnorm16(base[i]);
+        float influenceValue = decodeUnorm16(influence[i]);
+        dst[i] = encodeUnorm16(baseValue + (influenceValue * blendSign));
+    }
+}
+void addSubRowSse4(uint16 *dst, uint16 *base, uint16 *influence, uint32 count, float blendSign)
+{
+    __m128 sign = _mm_set1_ps(blendSign);
+
+    uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 baseValue = decodeUnorm16x4(&base[i]);
+        __m128 influenceValue = decodeUnorm16x4(&influence[i]);
+        encodeUnorm16x4(&dst[i], _mm_add_ps(baseValue, _mm_mul_ps(influenceValue, sign)));
+    }
+    addSubRowScalar(&dst[i], &base[i], &influence[i], count - i, blendSign);
+}
+void addSubRowAvx2(uint16 *dst, uint16 *base, uint16 *influence, uint32 count, float blendSign)
+{
+    __m256 sign = _mm256_set1_ps(blendSign);
+
+    uint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 baseValue = decodeUnorm16x8(&base[i]);
+        __m256 influenceValue = decodeUnorm16x8(&influence[i]);
+        encodeUnorm16x8(&dst[i], _mm256_add_ps(baseValue, _mm256_mul_ps(influenceValue, sign)));
+    }
+    addSubRowScalar(&dst[i], &base[i], &influence[i], count - i, blendSign);
+}
+
+void brushApplyAddSub(
+    uint16 *dst, uint16 *base, uint16 *influence, uint32 dim, rect2 region, float blendSign)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    SimdLevel simdLevel = getSimdLevel();
+    uint32 minX = (uint32)region.x;
+    uint32 count = (uint32)region.width;
+    uint32 maxY = (uint32)(region.y + region.height);
+    for (uint32 y = (uint32)region.y; y < maxY; y++)
+    {
+        uint32 rowStart = (y * dim) + minX;
+        switch (simdLevel)
+        {
+        case SIMD_LEVEL_AVX2:
+            addSubRowAvx2(&dst[rowStart], &base[rowStart], &influence[rowStart], count, blendSign);
+            break;
+        case SIMD_LEVEL_SSE4:
+            addSubRowSse4(&dst[rowStart], &base[rowStart], &influence[rowStart], count, blendSign);
+            break;
+        default:
+            addSubRowScalar(&dst[rowStart], &base[rowStart], &influence[rowStart], count, blendSign);
+            break;
+        }
+    }
+}
+
+// flatten
+
+void flattenRowScalar(uint16 *dst, uint16 *base, uint16 *influence, uint32 count, float flattenHeight)
+{
+    for (uint32 i = 0; i < count; i++)
+    {
+        float baseValue = decodeUnorm16(base[i]);
+        float influenceValue = decodeUnorm16(influence[i]);
+
+        float invInfluence = 1 - influenceValue;
+        float t = 1 - (invInfluence * invInfluence);
+        dst[i] = encodeUnorm16((baseValue * (1 - t)) + (flattenHeight * t));
+    }
+}
+void flattenRowSse4(uint16 *dst, uint16 *base, uint16 *influence, uint32 count, float flattenHeight)
+{
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 height = _mm_set1_ps(flattenHeight);
+
+    uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 baseValue = decodeUnorm16x4(&base[i]);
+        __m128 influenceValue = decodeUnorm16x4(&influence[i]);
+
+        __m128 invInfluence = _mm_sub_ps(one, influenceValue);
+        __m128 t = _mm_sub_ps(one, _mm_mul_ps(invInfluence, invInfluence));
+        __m128 result = _mm_add_ps(_mm_mul_ps(baseValue, _mm_sub_ps(one, t)), _mm_mul_ps(height, t));
+        encodeUnorm16x4(&dst[i], result);
+    }
+    flattenRowScalar(&dst[i], &base[i], &influence[i], count - i, flattenHeight);
+}
+void flattenRowAvx2(uint16 *dst, uint16 *base, uint16 *influence, uint32 count, float flattenHeight)
+{
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 height = _mm256_set1_ps(flattenHeight);
+
+    uint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 baseValue = decodeUnorm16x8(&base[i]);
+        __m256 influenceValue = decodeUnorm16x8(&influence[i]);
+
+        __m256 invInfluence = _mm256_sub_ps(one, influenceValue);
+        __m256 t = _mm256_sub_ps(one, _mm256_mul_ps(invInfluence, invInfluence));
+        __m256 result =
+            _mm256_add_ps(_mm256_mul_ps(baseValue, _mm256_sub_ps(one, t)), _mm256_mul_ps(height, t));
+        encodeUnorm16x8(&dst[i], result);
+    }
+    flattenRowScalar(&dst[i], &base[i], &influence[i], count - i, flattenHeight);
+}
+
+void brushApplyFlatten(
+    uint16 *dst, uint16 *base, uint16 *influence, uint32 dim, rect2 region, float flattenHeight)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    SimdLevel simdLevel = getSimdLevel();
+    uint32 minX = (uint32)region.x;
+    uint32 count = (uint32)region.width;
+    uint32 maxY = (uint32)(region.y + region.height);
+    for (uint32 y = (uint32)region.y; y < maxY; y++)
+    {
+        uint32 rowStart = (y * dim) + minX;
+        switch (simdLevel)
+        {
+        case SIMD_LEVEL_AVX2:
+            flattenRowAvx2(&dst[rowStart], &base[rowStart], &influence[rowStart], count, flattenHeight);
+            break;
+        case SIMD_LEVEL_SSE4:
+            flattenRowSse4(&dst[rowStart], &base[rowStart], &influence[rowStart], count, flattenHeight);
+            break;
+        default:
+            flattenRowScalar(&dst[rowStart], &base[rowStart], &influence[rowStart], count, flattenHeight);
+            break;
+        }
+    }
+}
+
+// smooth
+
+void smoothRowScalar(uint16 *dst,
+    uint16 *base,
+    uint16 *influence,
+    uint32 start,
+    uint32 count,
+    BrushSmoothTap *taps,
+    BrushSmoothRowTaps *rowTaps)
+{
+    for (uint32 x = start; x < start + count; x++)
+    {
+        float baseValue = decodeUnorm16(base[x]);
+        float influenceValue = decodeUnorm16(influence[x]);
+        float newValue = baseValue;
+        if (influenceValue > 0)
+        {
+            float tapValues[BRUSH_SMOOTH_TAP_COUNT];
+            for (uint32 t = 0; t < BRUSH_SMOOTH_TAP_COUNT; t++)
+            {
+                BrushSmoothTap *tap = &taps[t];
+                float tapInfluence = (decodeUnorm16(rowTaps->influenceLower[t][x]) * tap->oneMinusFraction)
+                    + (decodeUnorm16(rowTaps->influenceUpper[t][x]) * tap->fraction);
+                float tapHeight = (decodeUnorm16(rowTaps->baseLower[t][x]) * tap->oneMinusFraction)
+                    + (decodeUnorm16(rowTaps->baseUpper[t][x]) * tap->fraction);
+
+                // samples outside the influence mask use the center value instead
+                tapValues[t] = tapInfluence == 0 ? baseValue : tapHeight;
+            }
+
+            float blurred = tapValues[0] * taps[0].weight;
+            blurred += tapValues[1] * taps[1].weight;
+            blurred += baseValue * BRUSH_SMOOTH_WEIGHT_CENTER;
+            blurred += tapValues[2] * taps[2].weight;
+            blurred += tapValues[3] * taps[3].weight;
+
+            newValue = (baseValue * (1 - influenceValue)) + (blurred * influenceValue);
+        }
+        dst[x] = encodeUnorm16(newValue);
+    }
+}
+void smoothRowSse4(uint16 *dst,
+    uint16 *base,
+    uint16 *influence,
+    uint32 start,
+    uint32 count,
+    BrushSmoothTap *taps,
+    BrushSmoothRowTaps *rowTaps)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 weightCenter = _mm_set1_ps(BRUSH_SMOOTH_WEIGHT_CENTER);
+
+    uint32 x = start;
+    uint32 end = start + count;
+    for (; x + 4 <= end; x += 4)
+    {
+        __m128 baseValue = decodeUnorm16x4(&base[x]);
+        __m128 influenceValue = decodeUnorm16x4(&influence[x]);
+
+        __m128 tapValues[BRUSH_SMOOTH_TAP_COUNT];
+        for (uint32 t = 0; t < BRUSH_SMOOTH_TAP_COUNT; t++)
+        {
+            BrushSmoothTap *tap = &taps[t];
+            __m128 fraction = _mm_set1_ps(tap->fraction);
+            __m128 oneMinusFraction = _mm_set1_ps(tap->oneMinusFraction);
+
+            __m128 tapInfluence =
+                _mm_add_ps(_mm_mul_ps(decodeUnorm16x4(&rowTaps->influenceLower[t][x]), oneMinusFraction),
+                    _mm_mul_ps(decodeUnorm16x4(&rowTaps->influenceUpper[t][x]), fraction));
+            __m128 tapHeight = _mm_add_ps(_mm_mul_ps(decodeUnorm16x4(&rowTaps->baseLower[t][x]), oneMinusFraction),
+                _mm_mul_ps(decodeUnorm16x4(&rowTaps->baseUpper[t][x]), fraction));
+            tapValues[t] = _mm_blendv_ps(tapHeight, baseValue, _mm_cmpeq_ps(tapInfluence, zero));
+        }
+
+        __m128 blurred = _mm_mul_ps(tapValues[0], _mm_set1_ps(taps[0].weight));
+        blurred = _mm_add_ps(blurred, _mm_mul_ps(tapValues[1], _mm_set1_ps(taps[1].weight)));
+        blurred = _mm_add_ps(blurred, _mm_mul_ps(baseValue, weightCenter));
+        blurred = _mm_add_ps(blurred, _mm_mul_ps(tapValues[2], _mm_set1_ps(taps[2].weight)));
+        blurred = _mm_add_ps(blurred, _mm_mul_ps(tapValues[3], _mm_set1_ps(taps[3].weight)));
+
+        __m128 smoothed = _mm_add_ps(
+            _mm_mul_ps(baseValue, _mm_sub_ps(one, influenceValue)), _mm_mul_ps(blurred, influenceValue));
+        __m128 result = _mm_blendv_ps(baseValue, smoothed, _mm_cmpgt_ps(influenceValue, zero));
+        encodeUnorm16x4(&dst[x], result);
+    }
+    smoothRowScalar(dst, base, influence, x, end - x, taps, rowTaps);
+}
+void smoothRowAvx2(uint16 *dst,
+    uint16 *base,
+    uint16 *influence,
+    uint32 start,
+    uint32 count,
+    BrushSmoothTap *taps,
+    BrushSmoothRowTaps *rowTaps)
+{
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 weightCenter = _mm256_set1_ps(BRUSH_SMOOTH_WEIGHT_CENTER);
+
+    uint32 x = start;
+    uint32 end = start + count;
+    for (; x + 8 <= end; x += 8)
+    {
+        __m256 baseValue = decodeUnorm16x8(&base[x]);
+        __m256 influenceValue = decodeUnorm16x8(&influence[x]);
+
+        __m256 tapValues[BRUSH_SMOOTH_TAP_COUNT];
+        for (uint32 t = 0; t < BRUSH_SMOOTH_TAP_COUNT; t++)
+        {
+            BrushSmoothTap *tap = &taps[t];
+            __m256 fraction = _mm256_set1_ps(tap->fraction);
+            __m256 oneMinusFraction = _mm256_set1_ps(tap->oneMinusFraction);
+
+            __m256 tapInfluence =
+                _mm256_add_ps(_mm256_mul_ps(decodeUnorm16x8(&rowTaps->influenceLower[t][x]), oneMinusFraction),
+                    _mm256_mul_ps(decodeUnorm16x8(&rowTaps->influenceUpper[t][x]), fraction));
+            __m256 tapHeight =
+                _mm256_add_ps(_mm256_mul_ps(decodeUnorm16x8(&rowTaps->baseLower[t][x]), oneMinusFraction),
+                    _mm256_mul_ps(decodeUnorm16x8(&rowTaps->baseUpper[t][x]), fraction));
+            tapValues[t] = _mm256_blendv_ps(tapHeight, baseValue, _mm256_cmp_ps(tapInfluence, zero, _CMP_EQ_OQ));
+        }
+
+        __m256 blurred = _mm256_mul_ps(tapValues[0], _mm256_set1_ps(taps[0].weight));
+        blurred = _mm256_add_ps(blurred, _mm256_mul_ps(tapValues[1], _mm256_set1_ps(taps[1].weight)));
+        blurred = _mm256_add_ps(blurred, _mm256_mul_ps(baseValue, weightCenter));
+        blurred = _mm256_add_ps(blurred, _mm256_mul_ps(tapValues[2], _mm256_set1_ps(taps[2].weight)));
+        blurred = _mm256_add_ps(blurred, _mm256_mul_ps(tapValues[3], _mm256_set1_ps(taps[3].weight)));
+
+        __m256 smoothed = _mm256_add_ps(_mm256_mul_ps(baseValue, _mm256_sub_ps(one, influenceValue)),
+            _mm256_mul_ps(blurred, influenceValue));
+        __m256 result = _mm256_blendv_ps(baseValue, smoothed, _mm256_cmp_ps(influenceValue, zero, _CMP_GT_OQ));
+        encodeUnorm16x8(&dst[x], result);
+    }
+    smoothRowScalar(dst, base, influence, x, end - x, taps, rowTaps);
+}
+
+void smoothRow(uint16 *dst,
+    uint16 *base,
+    uint16 *influence,
+    uint32 start,
+    uint32 count,
+    BrushSmoothTap *taps,
+    BrushSmoothRowTaps *rowTaps)
+{
+    switch (getSimdLevel())
+    {
+    case SIMD_LEVEL_AVX2:
+        smoothRowAvx2(dst, base, influence, start, count, taps, rowTaps);
+        break;
+    case SIMD_LEVEL_SSE4:
+        smoothRowSse4(dst, base, influence, start, count, taps, rowTaps);
+        break;
+    default:
+        smoothRowScalar(dst, base, influence, start, count, taps, rowTaps);
+        break;
+    }
+}
+
+void brushApplySmooth(
+    MemoryArena *arena, uint16 *dst, uint16 *temp, uint16 *base, uint16 *influence, uint32 dim, rect2 region)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    TemporaryMemory smoothMemory = beginTemporaryMemory(arena);
+
+    BrushSmoothTap taps[BRUSH_SMOOTH_TAP_COUNT];
+    getBrushSmoothTaps(taps);
+
+    uint32 minX = (uint32)region.x;
+    uint32 count = (uint32)region.width;
+    uint32 maxX = minX + count;
+
+    /*
+     * Textures are sampled with a black border, so texels outside the tile read as zero. For the
+     * horizontal pass we copy the part of each row read by the taps into a zero-padded buffer so the
+     * taps never need bounds checks. For the vertical pass, taps that fall outside the tile point at
+     * a row of zeroes.
+     */
+    uint32 paddedRowLength = dim + (2 * BRUSH_SMOOTH_MAX_TAP_TEXELS);
+    uint16 *paddedBase = pushArray(arena, uint16, paddedRowLength);
+    uint16 *paddedInfluence = pushArray(arena, uint16, paddedRowLength);
+    uint16 *zeroRow = pushArray(arena, uint16, dim);
+    memset(paddedBase, 0, paddedRowLength * sizeof(uint16));
+    memset(paddedInfluence, 0, paddedRowLength * sizeof(uint16));
+    memset(zeroRow, 0, dim * sizeof(uint16));
+
+    uint32 copyMinX = minX > BRUSH_SMOOTH_MAX_TAP_TEXELS ? minX - BRUSH_SMOOTH_MAX_TAP_TEXELS : 0;
+    uint32 copyMaxX = min(maxX + BRUSH_SMOOTH_MAX_TAP_TEXELS, dim);
+    uint32 copyCount = copyMaxX - copyMinX;
+
+    BrushSmoothRowTaps rowTaps;
+
+    // horizontal pass
+    rect2 horizontalRegion = brushGetSmoothHorizontalPassRect(region, dim);
+    uint32 horizontalMaxY = (uint32)(horizontalRegion.y + horizontalRegion.height);
+    for (uint32 y = (uint32)horizontalRegion.y; y < horizontalMaxY; y++)
+    {
+        uint32 rowStart = y * dim;
+        uint16 *rowBase = &paddedBase[BRUSH_SMOOTH_MAX_TAP_TEXELS];
+        uint16 *rowInfluence = &paddedInfluence[BRUSH_SMOOTH_MAX_TAP_TEXELS];
+        memcpy(&rowBase[copyMinX], &base[rowStart + copyMinX], copyCount * sizeof(uint16));
+        memcpy(&rowInfluence[copyMinX], &influence[rowStart + copyMinX], copyCount * sizeof(uint16));
+
+        for (uint32 t = 0; t < BRUSH_SMOOTH_TAP_COUNT; t++)
+        {
+            rowTaps.baseLower[t] = rowBase + taps[t].offset;
+            rowTaps.baseUpper[t] = rowBase + taps[t].offset + 1;
+            rowTaps.influenceLower[t] = rowInfluence + taps[t].offset;
+            rowTaps.influenceUpper[t] = rowInfluence + taps[t].offset + 1;
+        }
+        smoothRow(&temp[rowStart], rowBase, rowInfluence, minX, count, taps, &rowTaps);
+    }
+
+    // vertical pass
+    uint32 maxY = (uint32)(region.y + region.height);
+    for (uint32 y = (uint32)region.y; y < maxY; y++)
+    {
+        uint32 rowStart = y * dim;
+        for (uint32 t = 0; t < BRUSH_SMOOTH_TAP_COUNT; t++)
+        {
+            int32 lowerY = (int32)y + taps[t].offset;
+            int32 upperY = lowerY + 1;
+            bool isLowerInBounds = lowerY >= 0 && lowerY < (int32)dim;
+            bool isUpperInBounds = upperY >= 0 && upperY < (int32)dim;
+
+            rowTaps.baseLower[t] = isLowerInBounds ? &temp[lowerY * dim] : zeroRow;
+            rowTaps.baseUpper[t] = isUpperInBounds ? &temp[upperY * dim] : zeroRow;
+            rowTaps.influenceLower[t] = isLowerInBounds ? &influence[lowerY * dim] : zeroRow;
+            rowTaps.influenceUpper[t] = isUpperInBounds ? &influence[upperY * dim] : zeroRow;
+        }
+        smoothRow(&dst[rowStart], &temp[rowStart], &influence[rowStart], minX, count, taps, &rowTaps);
+    }
+
+    endTemporaryMemory(&smoothMemory);
+}
+
+void brushClearRegion(uint16 *buffer, uint32 dim, rect2 region)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    uint32 minX = (uint32)region.x;
+    uint32 count = (uint32)region.width;
+    uint32 maxY = (uint32)(region.y + region.height);
+    for (uint32 y = (uint32)region.y; y < maxY; y++)
+    {
+        memset(&buffer[(y * dim) + minX], 0, count * sizeof(uint16));
+    }
+}
+void brushCopyRegion(uint16 *dst, uint16 *src, uint32 dim, rect2 srcRegion, uint32 dstX, uint32 dstY)
+{
+    if (isRectEmpty(srcRegion))
+    {
+        return;
+    }
+
+    uint32 srcX = (uint32)srcRegion.x;
+    uint32 srcY = (uint32)srcRegion.y;
+    uint32 width = (uint32)srcRegion.width;
+    uint32 height = (uint32)srcRegion.height;
+    assert(srcX + width <= dim && dstX + width <= dim);
+    assert(srcY + height <= dim && dstY + height <= dim);
+
+    for (uint32 row = 0; row < height; row++)
+    {
+        memcpy(&dst[((dstY + row) * dim) + dstX], &src[((srcY + row) * dim) + srcX], width * sizeof(uint16));
+    }
+}
+
+// box smooth
+
+void brushInitializeSummedAreaTable(
+    BrushSummedAreaTable *table, uint64 *sums, uint32 minX, uint32 minY, uint32 width, uint32 height)
+{
+    table->sums = sums;
+    table->stride = width + 1;
+    table->minX = minX;
+    table->minY = minY;
+    table->width = width;
+    table->height = height;
+
+    memset(sums, 0, table->stride * sizeof(uint64));
+    for (uint32 y = 1; y <= height; y++)
+    {
+        sums[y * table->stride] = 0;
+    }
+}
+
+void brushUpdateSummedAreaTable(BrushSummedAreaTable *table, uint16 *heightmap, uint32 dim, rect2 changedRect)
+{
+    if (isRectEmpty(changedRect))
+    {
+        return;
+    }
+
+    /*
+     * A change to a texel affects the sums of every texel below and to the right of it, so
+     * everything from the changed region's minimum corner onwards needs to be recalculated.
+     */
+    uint32 startX = max((uint32)changedRect.x, table->minX) - table->minX;
+    uint32 startY = max((uint32)changedRect.y, table->minY) - table->minY;
+    if (startX >= table->width || startY >= table->height)
+    {
+        return;
+    }
+
+    uint32 stride = table->stride;
+    for (uint32 y = startY; y < table->height; y++)
+    {
+        uint16 *src = &heightmap[((table->minY + y) * dim) + table->minX];
+        uint64 *above = &table->sums[y * stride];
+        uint64 *row = &table->sums[(y + 1) * stride];
+
+        // resume the running sum of this row from the unchanged texels to the left
+        uint64 rowSum = row[startX] - above[startX];
+        for (uint32 x = startX; x < table->width; x++)
+        {
+            rowSum += src[x];
+            row[x + 1] = above[x + 1] + rowSum;
+        }
+    }
+}
+
+inline uint64 getSummedAreaTableSum(BrushSummedAreaTable *table, int32 minX, int32 minY, int32 maxX, int32 maxY)
+{
+    // the box is in tile texels and must lie within the table
+    uint32 left = (uint32)minX - table->minX;
+    uint32 top = (uint32)minY - table->minY;
+    uint32 right = (uint32)maxX - table->minX;
+    uint32 bottom = (uint32)maxY - table->minY;
+    assert(left <= right && right <= table->width);
+    assert(top <= bottom && bottom <= table->height);
+
+    uint64 *sumsTop = &table->sums[top * table->stride];
+    uint64 *sumsBottom = &table->sums[bottom * table->stride];
+    return sumsBottom[right] - sumsBottom[left] - sumsTop[right] + sumsTop[left];
+}
+
+/*
+ * Sums a box of texels that may extend past the edges of the tile. The box is split along the edges
+ * and each part is summed from the table of the tile it falls in. Parts over missing neighbours are
+ * left out, so outTexelCount is the number of texels that were actually summed.
+ */
+uint64 getNeighbourhoodBoxSum(BrushSummedAreaNeighbourhood *sums,
+    int32 minX,
+    int32 minY,
+    int32 maxX,
+    int32 maxY,
+    uint32 *outTexelCount)
+{
+    int32 dim = (int32)sums->dim;
+    int32 spacing = (int32)sums->tileSpacing;
+    int32 splitsX[4] = {minX, glm::clamp(0, minX, maxX), glm::clamp(dim, minX, maxX), maxX};
+    int32 splitsY[4] = {minY, glm::clamp(0, minY, maxY), glm::clamp(dim, minY, maxY), maxY};
+
+    uint64 sum = 0;
+    uint32 texelCount = 0;
+    for (int32 ty = 0; ty < 3; ty++)
+    {
+        for (int32 tx = 0; tx < 3; tx++)
+        {
+            BrushSummedAreaTable *table = sums->tables[ty][tx];
+            int32 partMinX = splitsX[tx];
+            int32 partMinY = splitsY[ty];
+            int32 partMaxX = splitsX[tx + 1];
+            int32 partMaxY = splitsY[ty + 1];
+            if (!table || partMinX == partMaxX || partMinY == partMaxY)
+            {
+                continue;
+            }
+
+            // move the part into the texels of the tile it falls in
+            int32 shiftX = (1 - tx) * spacing;
+            int32 shiftY = (1 - ty) * spacing;
+            sum += getSummedAreaTableSum(
+                table, partMinX + shiftX, partMinY + shiftY, partMaxX + shiftX, partMaxY + shiftY);
+            texelCount += (uint32)((partMaxX - partMinX) * (partMaxY - partMinY));
+        }
+    }
+
+    *outTexelCount = texelCount;
+    return sum;
+}
+
+void brushApplySmoothBox(uint16 *dst,
+    uint16 *base,
+    uint16 *influence,
+    uint32 dim,
+    rect2 region,
+    BrushSummedAreaNeighbourhood *baseSums,
+    uint32 kernelRadius)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    // the tile's table must cover every texel of the tile within the kernel radius of the region
+    BrushSummedAreaTable *table = baseSums->tables[1][1];
+    int32 minX = (int32)region.x;
+    int32 minY = (int32)region.y;
+    int32 maxX = minX + (int32)region.width;
+    int32 maxY = minY + (int32)region.height;
+    int32 radius = (int32)kernelRadius;
+    assert((int32)table->minX <= max(minX - radius, 0));
+    assert((int32)table->minY <= max(minY - radius, 0));
+    assert(table->minX + table->width >= (uint32)min(maxX + radius, (int32)dim));
+    assert(table->minY + table->height >= (uint32)min(maxY + radius, (int32)dim));
+
+    // boxes can only reach as far as the tiles adjacent to this one
+    assert(baseSums->dim == dim);
+    assert(kernelRadius <= baseSums->tileSpacing);
+
+    /*
+     * Each texel is blended towards the mean of the box around it. Boxes that reach past the edges of
+     * the tile are summed from the neighbouring tiles (and divided by the number of texels they
+     * actually cover where there are no neighbours) so the cost per texel doesn't depend on the kernel
+     * radius, and tiles agree on the texels they share.
+     */
+    int32 tableMinX = (int32)table->minX;
+    int32 tableMinY = (int32)table->minY;
+    uint32 stride = table->stride;
+    uint32 boxTexelCount = (uint32)((2 * radius) + 1) * (uint32)((2 * radius) + 1);
+    for (int32 y = minY; y < maxY; y++)
+    {
+        int32 boxMinY = y - radius;
+        int32 boxMaxY = y + radius + 1;
+        bool isRowInsideTile = boxMinY >= 0 && boxMaxY <= (int32)dim;
+        uint64 *sumsTop = 0;
+        uint64 *sumsBottom = 0;
+        if (isRowInsideTile)
+        {
+            sumsTop = &table->sums[(boxMinY - tableMinY) * stride];
+            sumsBottom = &table->sums[(boxMaxY - tableMinY) * stride];
+        }
+
+        uint32 rowStart = y * dim;
+        for (int32 x = minX; x < maxX; x++)
+        {
+            uint32 i = rowStart + x;
+            if (influence[i] == 0)
+            {
+                dst[i] = base[i];
+                continue;
+            }
+
+            int32 boxMinX = x - radius;
+            int32 boxMaxX = x + radius + 1;
+            uint64 sum;
+            uint32 texelCount;
+            if (isRowInsideTile && boxMinX >= 0 && boxMaxX <= (int32)dim)
+            {
+                int32 left = boxMinX - tableMinX;
+                int32 right = boxMaxX - tableMinX;
+                sum = sumsBottom[right] - sumsBottom[left] - sumsTop[right] + sumsTop[left];
+                texelCount = boxTexelCount;
+            }
+            else
+            {
+                sum = getNeighbourhoodBoxSum(baseSums, boxMinX, boxMinY, boxMaxX, boxMaxY, &texelCount);
+            }
+            float mean = (float)((double)sum / (double)texelCount) * UNORM16_TO_FLOAT;
+
+            float baseValue = decodeUnorm16(base[i]);
+            float influenceValue = decodeUnorm16(influence[i]);
+            dst[i] = encodeUnorm16((baseValue * (1 - influenceValue)) + (mean * influenceValue));
+        }
+    }
+}
+
+// box smooths the region using the committed sums of the tile and its neighbours
+void brushApplySmoothBoxToWorking(BrushTileBuffers *tile, rect2 region, uint32 kernelRadius)
+{
+    BrushSummedAreaNeighbourhood sums = {};
+    sums.dim = tile->dim;
+    sums.tileSpacing = tile->tileSpacing;
+    for (uint32 ty = 0; ty < 3; ty++)
+    {
+        for (uint32 tx = 0; tx < 3; tx++)
+        {
+            BrushTileBuffers *neighbour = tile->neighbours[ty][tx];
+            sums.tables[ty][tx] = neighbour ? &neighbour->committedSums : 0;
+        }
+    }
+    assert(tile->neighbours[1][1] == tile);
+
+    brushApplySmoothBox(tile->workingHeightmap, tile->committedHeightmap, tile->workingInfluenceMask, tile->dim,
+        region, &sums, kernelRadius);
+}
+
+/*
+ * Box smooths the region on top of the working heightmaps, which change every frame, so only the parts of
+ * the tile and its neighbours that the boxes around the region read are summed. The working heightmaps of
+ * the neighbours must already be up to date.
+ */
+void brushApplySmoothBoxToPreview(MemoryArena *arena, BrushTileBuffers *tile, rect2 region, uint32 kernelRadius)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    TemporaryMemory smoothMemory = beginTemporaryMemory(arena);
+
+    int32 dim = (int32)tile->dim;
+    int32 spacing = (int32)tile->tileSpacing;
+    rect2 tileBounds = rectMinDim(0, 0, (float)dim, (float)dim);
+    rect2 readRect = rectExpand(region, (float)kernelRadius, (float)kernelRadius);
+    float minX = readRect.x;
+    float minY = readRect.y;
+    float maxX = readRect.x + readRect.width;
+    float maxY = readRect.y + readRect.height;
+    float splitsX[4] = {minX, glm::clamp(0.0f, minX, maxX), glm::clamp((float)dim, minX, maxX), maxX};
+    float splitsY[4] = {minY, glm::clamp(0.0f, minY, maxY), glm::clamp((float)dim, minY, maxY), maxY};
+
+    BrushSummedAreaNeighbourhood sums = {};
+    sums.dim = tile->dim;
+    sums.tileSpacing = tile->tileSpacing;
+    for (int32 ty = 0; ty < 3; ty++)
+    {
+        for (int32 tx = 0; tx < 3; tx++)
+        {
+            // the part of the read rect that falls in this tile, in its own texels
+            BrushTileBuffers *neighbour = tile->neighbours[ty][tx];
+            rect2 partRect = rectMinMax(
+                glm::vec2(splitsX[tx], splitsY[ty]), glm::vec2(splitsX[tx + 1], splitsY[ty + 1]));
+            partRect.x += (float)((1 - tx) * spacing);
+            partRect.y += (float)((1 - ty) * spacing);
+            partRect = rectIntersection(partRect, tileBounds);
+            if (!neighbour || isRectEmpty(partRect))
+            {
+                continue;
+            }
+
+            uint32 width = (uint32)partRect.width;
+            uint32 height = (uint32)partRect.height;
+            BrushSummedAreaTable *table = pushStruct(arena, BrushSummedAreaTable);
+            brushInitializeSummedAreaTable(table, pushArray(arena, uint64, (width + 1) * (height + 1)),
+                (uint32)partRect.x, (uint32)partRect.y, width, height);
+            brushUpdateSummedAreaTable(table, neighbour->workingHeightmap, tile->dim, partRect);
+            sums.tables[ty][tx] = table;
+        }
+    }
+    assert(tile->neighbours[1][1] == tile);
+
+    brushApplySmoothBox(tile->previewHeightmap, tile->workingHeightmap, tile->previewInfluenceMask, tile->dim,
+        region, &sums, kernelRadius);
+
+    endTemporaryMemory(&smoothMemory);
+}
+
+// compositing
+
+// composite the regions of a tile given by brushUpdateTileRegions, which must already have been called
+void brushCompositeWorkingRegion(MemoryArena *arena,
+    BrushTileBuffers *tile,
+    BrushTileUpdate *update,
+    BrushParameters *params,
+    BrushSegment *segments,
+    uint32 segmentCount,
+    glm::vec2 offset)
+{
+    uint32 dim = tile->dim;
+    brushClearRegion(tile->workingInfluenceMask, dim, update->workingMaskClearRect);
+    brushDrawInfluenceMask(tile->workingInfluenceMask, dim, segments, segmentCount, offset, params);
+
+    rect2 workingRect = update->workingHeightmapRect;
+    switch (params->blendOperation)
+    {
+    case BRUSH_BLEND_ADD_SUB:
+        brushApplyAddSub(tile->workingHeightmap, tile->committedHeightmap, tile->workingInfluenceMask, dim,
+            workingRect, params->blendSign);
+        break;
+    case BRUSH_BLEND_FLATTEN:
+        brushApplyFlatten(tile->workingHeightmap, tile->committedHeightmap, tile->workingInfluenceMask, dim,
+            workingRect, params->flattenHeight);
+        break;
+    case BRUSH_BLEND_SMOOTH:
+    {
+        // holds the output of the horizontal pass, like the temporary render target used by the shader
+        TemporaryMemory smoothMemory = beginTemporaryMemory(arena);
+        uint16 *tempHeightmap = pushArray(arena, uint16, dim * dim);
+        brushApplySmooth(arena, tile->workingHeightmap, tempHeightmap, tile->committedHeightmap,
+            tile->workingInfluenceMask, dim, workingRect);
+        endTemporaryMemory(&smoothMemory);
+    }
+    break;
+    case BRUSH_BLEND_SMOOTH_BOX:
+        // the committed heightmaps don't change during a stroke so their sums are kept up to date by the caller
+        brushApplySmoothBoxToWorking(tile, workingRect, params->smoothRadius);
+        break;
+    }
+}
+
+// the box smooth reads the working heightmaps of neighbouring tiles, so they must be composited first
+void brushCompositePreviewRegion(MemoryArena *arena,
+    BrushTileBuffers *tile,
+    BrushTileUpdate *update,
+    BrushParameters *params,
+    BrushSegment *previewSegment,
+    glm::vec2 offset)
+{
+    uint32 dim = tile->dim;
+    brushClearRegion(tile->previewInfluenceMask, dim, update->previewMaskClearRect);
+    if (previewSegment)
+    {
+        brushDrawInfluenceMask(tile->previewInfluenceMask, dim, previewSegment, 1, offset, params);
+    }
+
+    rect2 previewRect = update->previewHeightmapRect;
+    switch (params->blendOperation)
+    {
+    case BRUSH_BLEND_ADD_SUB:
+        brushApplyAddSub(tile->previewHeightmap, tile->workingHeightmap, tile->previewInfluenceMask, dim,
+            previewRect, params->blendSign);
+        break;
+    case BRUSH_BLEND_FLATTEN:
+        brushApplyFlatten(tile->previewHeightmap, tile->workingHeightmap, tile->previewInfluenceMask, dim,
+            previewRect, params->flattenHeight);
+        break;
+    case BRUSH_BLEND_SMOOTH:
+    {
+        TemporaryMemory smoothMemory = beginTemporaryMemory(arena);
+        uint16 *tempHeightmap = pushArray(arena, uint16, dim * dim);
+        brushApplySmooth(arena, tile->previewHeightmap, tempHeightmap, tile->workingHeightmap,
+            tile->previewInfluenceMask, dim, previewRect);
+        endTemporaryMemory(&smoothMemory);
+    }
+    break;
+    case BRUSH_BLEND_SMOOTH_BOX:
+        brushApplySmoothBoxToPreview(arena, tile, previewRect, params->smoothRadius);
+        break;
+    }
+}
+
+void brushCompositeTileRegions(MemoryArena *arena,
+    BrushTileBuffers *tile,
+    BrushTileUpdate *update,
+    BrushParameters *params,
+    BrushSegment *segments,
+    uint32 segmentCount,
+    BrushSegment *previewSegment,
+    glm::vec2 offset)
+{
+    brushCompositeWorkingRegion(arena, tile, update, params, segments, segmentCount, offset);
+    brushCompositePreviewRegion(arena, tile, update, params, previewSegment, offset);
+}
+
+// composites a tile on its own, tiles with neighbours must composite every working region before any preview
+BrushTileUpdate brushCompositeTile(MemoryArena *arena,
+    BrushTileBuffers *tile,
+    BrushTileState *state,
+    BrushParameters *params,
+    bool isNewStroke,
+    BrushSegment *segments,
+    uint32 segmentCount,
+    BrushSegment *previewSegment,
+    glm::vec2 offset)
+{
+    rect2 strokeBounds = brushGetStrokeBounds(segments, segmentCount, previewSegment, params->radius);
+    rect2 tileBounds = rectMinDim(offset, (float)tile->dim);
+    if (!brushIsTileAffected(state, isNewStroke, strokeBounds, tileBounds))
+    {
+        return {};
+    }
+
+    BrushTileUpdate update = brushUpdateTileRegions(
+        state, tile->dim, params, isNewStroke, segments, segmentCount, previewSegment, offset);
+    brushCompositeTileRegions(arena, tile, &update, params, segments, segmentCount, previewSegment, offset);
+
+    return update;
+}
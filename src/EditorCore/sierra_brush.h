@@ -0,0 +1,113 @@
+#ifndef SIERRA_BRUSH_H
+#define SIERRA_BRUSH_H
+
+/*
+ * CPU implementation of the brush compositing pipeline. It operates on R16 (uint16) tile buffers
+ * and mirrors the quad_brush_* shaders, so strokes can be composited without a GL context. The box
+ * smooth has no shader equivalent, its cost per texel is constant regardless of the kernel radius.
+ */
+
+enum BrushMaskBlendMode
+{
+    BRUSH_MASK_BLEND_ADDITIVE,
+    BRUSH_MASK_BLEND_MAX
+};
+enum BrushBlendOperation
+{
+    BRUSH_BLEND_ADD_SUB,
+    BRUSH_BLEND_FLATTEN,
+    BRUSH_BLEND_SMOOTH,
+    BRUSH_BLEND_SMOOTH_BOX
+};
+
+struct BrushParameters
+{
+    BrushBlendOperation blendOperation;
+    float blendSign;
+    float flattenHeight;
+
+    // half-width (in texels) of the box filter used by the box smooth
+    uint32 smoothRadius;
+
+    BrushMaskBlendMode maskBlendMode;
+    float radius;
+    float falloff;
+
+    // for additive masks, the influence accumulated per brush radius travelled along the stroke
+    float strength;
+    float dabStrength;
+};
+
+struct BrushSegment
+{
+    // heightmap-space endpoints, the brush is swept between them
+    glm::vec2 start;
+    glm::vec2 end;
+
+    // dabs are single brush applications (the start of a stroke and the cursor preview)
+    bool isDab;
+};
+
+// the furthest texel (in either direction) read by the smooth blur
+#define BRUSH_SMOOTH_MAX_TAP_TEXELS 40
+
+struct BrushTileState
+{
+    // texel regions outside of which the influence masks are known to be zero
+    rect2 workingMaskRect;
+    rect2 previewMaskRect;
+
+    // texel region outside of which the working heightmap matches the committed heightmap
+    rect2 uncommittedRect;
+};
+struct BrushTileUpdate
+{
+    // texel regions that need to be redrawn when compositing the next frame of a stroke
+    rect2 workingMaskClearRect;
+    rect2 workingHeightmapRect;
+    rect2 previewMaskClearRect;
+    rect2 previewHeightmapRect;
+};
+
+struct BrushSummedAreaTable
+{
+    // covers a rectangle of texels, sums[(y * stride) + x] is the sum of the texels above and to the
+    // left of (x, y) relative to the rectangle's minimum corner, so row and column 0 are always zero
+    uint64 *sums;
+    uint32 stride;
+    uint32 minX;
+    uint32 minY;
+    uint32 width;
+    uint32 height;
+};
+
+struct BrushSummedAreaNeighbourhood
+{
+    // the tables of a tile (at [1][1]) and of the tiles around it, null where there is no table
+    BrushSummedAreaTable *tables[3][3];
+
+    uint32 dim;
+    uint32 tileSpacing;
+};
+
+struct BrushTileBuffers
+{
+    uint32 dim;
+
+    /*
+     * The tiles around this one (with the tile itself at [1][1]), null where there are none. Adjacent tiles
+     * overlap and tileSpacing is the distance in texels between their minimum corners, so the texels past
+     * the edges of this tile can be read from its neighbours.
+     */
+    BrushTileBuffers *neighbours[3][3];
+    uint32 tileSpacing;
+
+    uint16 *committedHeightmap;
+    BrushSummedAreaTable committedSums;
+    uint16 *workingInfluenceMask;
+    uint16 *workingHeightmap;
+    uint16 *previewInfluenceMask;
+    uint16 *previewHeightmap;
+};
+
+#endif
@@ -0,0 +1,606 @@
+#include "sierra_bvh.h"
+
+// cost of visiting a node relative to the cost of testing a primitive
+#define BVH_SAH_TRAVERSAL_COST 1.0f
+
+void bvhInitialize(Bvh *bvh, MemoryArena *arena, uint32 maxPrimitiveCount)
+{
+    // every node of the collapsed tree replaces at least one interior node of the binary tree
+    bvh->maxNodeCount = maxPrimitiveCount;
+    bvh->nodes = pushArray(arena, BvhNode, bvh->maxNodeCount);
+    bvh->nodeCount = 0;
+    bvh->primitiveIndices = pushArray(arena, uint32, maxPrimitiveCount);
+    bvh->primitiveCount = 0;
+    bvh->maxPrimitiveCount = maxPrimitiveCount;
+}
+
+inline float getHalfSurfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    glm::vec3 extent = boundsMax - boundsMin;
+    if (extent.x < 0 || extent.y < 0 || extent.z < 0)
+    {
+        return 0;
+    }
+    return (extent.x * extent.y) + (extent.y * extent.z) + (extent.z * extent.x);
+}
+
+inline uint32 getSahBinIndex(float centroid, float centroidMin, float binScale)
+{
+    uint32 binIndex = (uint32)((centroid - centroidMin) * binScale);
+    return binIndex < BVH_SAH_BIN_COUNT ? binIndex : BVH_SAH_BIN_COUNT - 1;
+}
+
+void buildBvhBinaryNode(Bvh *bvh,
+    BvhBuildNode *buildNodes,
+    uint32 *buildNodeCount,
+    uint32 nodeIndex,
+    glm::vec3 *primitiveMins,
+    glm::vec3 *primitiveMaxs)
+{
+    BvhBuildNode *node = &buildNodes[nodeIndex];
+    uint32 *indices = &bvh->primitiveIndices[node->firstIndex];
+    uint32 count = node->primitiveCount;
+
+    node->boundsMin = glm::vec3(FLT_MAX);
+    node->boundsMax = glm::vec3(-FLT_MAX);
+    glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+    glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint32 primitiveIndex = indices[i];
+        node->boundsMin = glm::min(node->boundsMin, primitiveMins[primitiveIndex]);
+        node->boundsMax = glm::max(node->boundsMax, primitiveMaxs[primitiveIndex]);
+
+        glm::vec3 centroid = (primitiveMins[primitiveIndex] + primitiveMaxs[primitiveIndex]) * 0.5f;
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+    if (count == 1)
+    {
+        return;
+    }
+
+    glm::vec3 centroidExtent = centroidMax - centroidMin;
+    uint32 axis = 0;
+    if (centroidExtent.y > centroidExtent[axis])
+    {
+        axis = 1;
+    }
+    if (centroidExtent.z > centroidExtent[axis])
+    {
+        axis = 2;
+    }
+
+    uint32 leftCount;
+    if (centroidExtent[axis] > 0)
+    {
+        // bin the primitives by their centroids along the longest axis
+        uint32 binCounts[BVH_SAH_BIN_COUNT] = {};
+        glm::vec3 binMins[BVH_SAH_BIN_COUNT];
+        glm::vec3 binMaxs[BVH_SAH_BIN_COUNT];
+        for (uint32 i = 0; i < BVH_SAH_BIN_COUNT; i++)
+        {
+            binMins[i] = glm::vec3(FLT_MAX);
+            binMaxs[i] = glm::vec3(-FLT_MAX);
+        }
+
+        float binScale = BVH_SAH_BIN_COUNT / centroidExtent[axis];
+        for (uint32 i = 0; i < count; i++)
+        {
+            uint32 primitiveIndex = indices[i];
+            float centroid = (primitiveMins[primitiveIndex][axis] + primitiveMaxs[primitiveIndex][axis]) * 0.5f;
+            uint32 binIndex = getSahBinIndex(centroid, centroidMin[axis], binScale);
+            binCounts[binIndex]++;
+            binMins[binIndex] = glm::min(binMins[binIndex], primitiveMins[primitiveIndex]);
+            binMaxs[binIndex] = glm::max(binMaxs[binIndex], primitiveMaxs[primitiveIndex]);
+        }
+
+        // sweep from the right to find the cost of everything after each split plane
+        float rightCosts[BVH_SAH_BIN_COUNT];
+        glm::vec3 rightMin = glm::vec3(FLT_MAX);
+        glm::vec3 rightMax = glm::vec3(-FLT_MAX);
+        uint32 rightCount = 0;
+        for (uint32 i = BVH_SAH_BIN_COUNT - 1; i > 0; i--)
+        {
+            rightMin = glm::min(rightMin, binMins[i]);
+            rightMax = glm::max(rightMax, binMaxs[i]);
+            rightCount += binCounts[i];
+            rightCosts[i] = rightCount * getHalfSurfaceArea(rightMin, rightMax);
+        }
+
+        // then sweep from the left to find the cheapest split plane with primitives on both sides
+        uint32 bestSplit = 0;
+        float bestCost = FLT_MAX;
+        glm::vec3 leftMin = glm::vec3(FLT_MAX);
+        glm::vec3 leftMax = glm::vec3(-FLT_MAX);
+        uint32 binLeftCount = 0;
+        for (uint32 i = 0; i < BVH_SAH_BIN_COUNT - 1; i++)
+        {
+            leftMin = glm::min(leftMin, binMins[i]);
+            leftMax = glm::max(leftMax, binMaxs[i]);
+            binLeftCount += binCounts[i];
+            if (binLeftCount == 0 || binLeftCount == count)
+            {
+                continue;
+            }
+
+            float cost = (binLeftCount * getHalfSurfaceArea(leftMin, leftMax)) + rightCosts[i + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        // the first and last bins are never empty so there is always a split plane to choose from
+        assert(bestCost < FLT_MAX);
+        float nodeArea = getHalfSurfaceArea(node->boundsMin, node->boundsMax);
+        float splitCost = (BVH_SAH_TRAVERSAL_COST * nodeArea) + bestCost;
+        float leafCost = count * nodeArea;
+        if (count <= BVH_MAX_LEAF_PRIMITIVES && leafCost <= splitCost)
+        {
+            return;
+        }
+
+        leftCount = 0;
+        for (uint32 i = 0; i < count; i++)
+        {
+            uint32 primitiveIndex = indices[i];
+            float centroid = (primitiveMins[primitiveIndex][axis] + primitiveMaxs[primitiveIndex][axis]) * 0.5f;
+            if (getSahBinIndex(centroid, centroidMin[axis], binScale) <= bestSplit)
+            {
+                indices[i] = indices[leftCount];
+                indices[leftCount++] = primitiveIndex;
+            }
+        }
+    }
+    else
+    {
+        // the centroids are coincident so split the primitives evenly if they don't fit in a leaf
+        if (count <= BVH_MAX_LEAF_PRIMITIVES)
+        {
+            return;
+        }
+        leftCount = count / 2;
+    }
+    assert(leftCount > 0 && leftCount < count);
+
+    uint32 firstChildIndex = *buildNodeCount;
+    *buildNodeCount += 2;
+
+    BvhBuildNode *leftChild = &buildNodes[firstChildIndex];
+    leftChild->firstIndex = node->firstIndex;
+    leftChild->primitiveCount = leftCount;
+
+    BvhBuildNode *rightChild = &buildNodes[firstChildIndex + 1];
+    rightChild->firstIndex = node->firstIndex + leftCount;
+    rightChild->primitiveCount = count - leftCount;
+
+    node->firstIndex = firstChildIndex;
+    node->primitiveCount = 0;
+
+    buildBvhBinaryNode(bvh, buildNodes, buildNodeCount, firstChildIndex, primitiveMins, primitiveMaxs);
+    buildBvhBinaryNode(bvh, buildNodes, buildNodeCount, firstChildIndex + 1, primitiveMins, primitiveMaxs);
+}
+
+uint32 collapseBvhNode(Bvh *bvh, BvhBuildNode *buildNodes, uint32 *children, uint32 childCount)
+{
+    // pull up the grandchildren of the largest interior children until the node is full
+    while (childCount < BVH_WIDTH)
+    {
+        uint32 largestChild = BVH_WIDTH;
+        float largestArea = -1;
+        for (uint32 i = 0; i < childCount; i++)
+        {
+            BvhBuildNode *child = &buildNodes[children[i]];
+            float area = getHalfSurfaceArea(child->boundsMin, child->boundsMax);
+            if (child->primitiveCount == 0 && area > largestArea)
+            {
+                largestChild = i;
+                largestArea = area;
+            }
+        }
+        if (largestChild == BVH_WIDTH)
+        {
+            break;
+        }
+
+        uint32 firstGrandchild = buildNodes[children[largestChild]].firstIndex;
+        children[largestChild] = firstGrandchild;
+        children[childCount++] = firstGrandchild + 1;
+    }
+
+    assert(bvh->nodeCount < bvh->maxNodeCount);
+    uint32 nodeIndex = bvh->nodeCount++;
+    BvhNode *node = &bvh->nodes[nodeIndex];
+    *node = {};
+    node->childCount = childCount;
+    for (uint32 i = 0; i < childCount; i++)
+    {
+        BvhBuildNode *child = &buildNodes[children[i]];
+        node->childMinX[i] = child->boundsMin.x;
+        node->childMinY[i] = child->boundsMin.y;
+        node->childMinZ[i] = child->boundsMin.z;
+        node->childMaxX[i] = child->boundsMax.x;
+        node->childMaxY[i] = child->boundsMax.y;
+        node->childMaxZ[i] = child->boundsMax.z;
+        node->childPrimitiveCounts[i] = child->primitiveCount;
+        if (child->primitiveCount > 0)
+        {
+            node->childIndices[i] = child->firstIndex;
+        }
+        else
+        {
+            uint32 grandchildren[BVH_WIDTH] = {child->firstIndex, child->firstIndex + 1};
+            node->childIndices[i] = collapseBvhNode(bvh, buildNodes, grandchildren, 2);
+        }
+    }
+
+    return nodeIndex;
+}
+
+void bvhBuild(
+    Bvh *bvh, MemoryArena *arena, glm::vec3 *primitiveMins, glm::vec3 *primitiveMaxs, uint32 primitiveCount)
+{
+    assert(primitiveCount <= bvh->maxPrimitiveCount);
+
+    bvh->primitiveCount = primitiveCount;
+    for (uint32 i = 0; i < primitiveCount; i++)
+    {
+        bvh->primitiveIndices[i] = i;
+    }
+
+    bvh->nodeCount = 0;
+    bvh->boundsMin = glm::vec3(0);
+    bvh->boundsMax = glm::vec3(0);
+    if (primitiveCount == 0)
+    {
+        return;
+    }
+
+    TemporaryMemory buildMemory = beginTemporaryMemory(arena);
+
+    BvhBuildNode *buildNodes = pushArray(arena, BvhBuildNode, (2 * primitiveCount) - 1);
+    uint32 buildNodeCount = 1;
+    buildNodes[0].firstIndex = 0;
+    buildNodes[0].primitiveCount = primitiveCount;
+    buildBvhBinaryNode(bvh, buildNodes, &buildNodeCount, 0, primitiveMins, primitiveMaxs);
+
+    bvh->boundsMin = buildNodes[0].boundsMin;
+    bvh->boundsMax = buildNodes[0].boundsMax;
+
+    // a root that is a leaf becomes the only child of the collapsed root
+    uint32 rootChildren[BVH_WIDTH] = {buildNodes[0].firstIndex, buildNodes[0].firstIndex + 1};
+    uint32 rootChildCount = 2;
+    if (buildNodes[0].primitiveCount > 0)
+    {
+        rootChildren[0] = 0;
+        rootChildCount = 1;
+    }
+    collapseBvhNode(bvh, buildNodes, rootChildren, rootChildCount);
+
+    endTemporaryMemory(&buildMemory);
+}
+
+inline glm::vec3 getBvhChildMin(BvhNode *node, uint32 childIndex)
+{
+    return glm::vec3(node->childMinX[childIndex], node->childMinY[childIndex], node->childMinZ[childIndex]);
+}
+inline glm::vec3 getBvhChildMax(BvhNode *node, uint32 childIndex)
+{
+    return glm::vec3(node->childMaxX[childIndex], node->childMaxY[childIndex], node->childMaxZ[childIndex]);
+}
+
+/*
+ * Updates the bounds of every node from new primitive bounds while keeping the hierarchy's structure,
+ * which is much cheaper than rebuilding it but degrades its quality the further the primitives move.
+ */
+void bvhRefit(Bvh *bvh, glm::vec3 *primitiveMins, glm::vec3 *primitiveMaxs)
+{
+    // nodes are always stored after their parent so visiting them in reverse visits children first
+    for (uint32 n = bvh->nodeCount; n > 0; n--)
+    {
+        BvhNode *node = &bvh->nodes[n - 1];
+        for (uint32 i = 0; i < node->childCount; i++)
+        {
+            glm::vec3 childMin = glm::vec3(FLT_MAX);
+            glm::vec3 childMax = glm::vec3(-FLT_MAX);
+            if (node->childPrimitiveCounts[i] > 0)
+            {
+                uint32 first = node->childIndices[i];
+                for (uint32 p = first; p < first + node->childPrimitiveCounts[i]; p++)
+                {
+                    uint32 primitiveIndex = bvh->primitiveIndices[p];
+                    childMin = glm::min(childMin, primitiveMins[primitiveIndex]);
+                    childMax = glm::max(childMax, primitiveMaxs[primitiveIndex]);
+                }
+            }
+            else
+            {
+                BvhNode *child = &bvh->nodes[node->childIndices[i]];
+                for (uint32 c = 0; c < child->childCount; c++)
+                {
+                    childMin = glm::min(childMin, getBvhChildMin(child, c));
+                    childMax = glm::max(childMax, getBvhChildMax(child, c));
+                }
+            }
+            node->childMinX[i] = childMin.x;
+            node->childMinY[i] = childMin.y;
+            node->childMinZ[i] = childMin.z;
+            node->childMaxX[i] = childMax.x;
+            node->childMaxY[i] = childMax.y;
+            node->childMaxZ[i] = childMax.z;
+        }
+    }
+
+    if (bvh->nodeCount > 0)
+    {
+        BvhNode *root = &bvh->nodes[0];
+        bvh->boundsMin = glm::vec3(FLT_MAX);
+        bvh->boundsMax = glm::vec3(-FLT_MAX);
+        for (uint32 i = 0; i < root->childCount; i++)
+        {
+            bvh->boundsMin = glm::min(bvh->boundsMin, getBvhChildMin(root, i));
+            bvh->boundsMax = glm::max(bvh->boundsMax, getBvhChildMax(root, i));
+        }
+    }
+}
+
+/*
+ * Tests a ray against the bounds of each of a node's children. Returns a mask with bit i set if the
+ * ray enters child i before maxDistance, in which case outEnterDistances[i] is where it enters.
+ */
+uint32 intersectRayBvhChildrenScalar(
+    glm::vec3 rayOrigin, glm::vec3 rayInvDir, BvhNode *node, float maxDistance, float *outEnterDistances)
+{
+    uint32 hitMask = 0;
+    for (uint32 i = 0; i < node->childCount; i++)
+    {
+        float tx0 = (node->childMinX[i] - rayOrigin.x) * rayInvDir.x;
+        float tx1 = (node->childMaxX[i] - rayOrigin.x) * rayInvDir.x;
+        float ty0 = (node->childMinY[i] - rayOrigin.y) * rayInvDir.y;
+        float ty1 = (node->childMaxY[i] - rayOrigin.y) * rayInvDir.y;
+        float tz0 = (node->childMinZ[i] - rayOrigin.z) * rayInvDir.z;
+        float tz1 = (node->childMaxZ[i] - rayOrigin.z) * rayInvDir.z;
+
+        float tEnter = fmaxf(fmaxf(fmaxf(fminf(tx0, tx1), fminf(ty0, ty1)), fminf(tz0, tz1)), 0);
+        float tExit = fminf(fminf(fminf(fmaxf(tx0, tx1), fmaxf(ty0, ty1)), fmaxf(tz0, tz1)), maxDistance);
+        if (tEnter <= tExit)
+        {
+            hitMask |= 1 << i;
+        }
+        outEnterDistances[i] = tEnter;
+    }
+    return hitMask;
+}
+uint32 intersectRayBvhChildren4(
+    glm::vec3 rayOrigin, glm::vec3 rayInvDir, BvhNode *node, float maxDistance, float *outEnterDistances)
+{
+    __m128 originX = _mm_set1_ps(rayOrigin.x);
+    __m128 originY = _mm_set1_ps(rayOrigin.y);
+    __m128 originZ = _mm_set1_ps(rayOrigin.z);
+    __m128 invDirX = _mm_set1_ps(rayInvDir.x);
+    __m128 invDirY = _mm_set1_ps(rayInvDir.y);
+    __m128 invDirZ = _mm_set1_ps(rayInvDir.z);
+
+    __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->childMinX), originX), invDirX);
+    __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->childMaxX), originX), invDirX);
+    __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->childMinY), originY), invDirY);
+    __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->childMaxY), originY), invDirY);
+    __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->childMinZ), originZ), invDirZ);
+    __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->childMaxZ), originZ), invDirZ);
+
+    __m128 tEnter = _mm_max_ps(
+        _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1)),
+        _mm_setzero_ps());
+    __m128 tExit = _mm_min_ps(
+        _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_max_ps(tz0, tz1)),
+        _mm_set1_ps(maxDistance));
+    _mm_storeu_ps(outEnterDistances, tEnter);
+
+    uint32 childMask = (1 << node->childCount) - 1;
+    return _mm_movemask_ps(_mm_cmple_ps(tEnter, tExit)) & childMask;
+}
+
+/*
+ * Finds the closest primitive hit by a ray within maxDistance (or any primitive, depending on the
+ * mode) by visiting the nodes the ray passes through front to back.
+ */
+bool bvhRaycast(Bvh *bvh,
+    glm::vec3 rayOrigin,
+    glm::vec3 rayDir,
+    float maxDistance,
+    BvhRaycastMode mode,
+    BvhRaycastLeaf *raycastLeaf,
+    void *context,
+    BvhRaycastHit *outHit)
+{
+    if (bvh->nodeCount == 0)
+    {
+        return false;
+    }
+
+    // rays parallel to a slab have infinite distances to it rather than NaNs
+    glm::vec3 rayInvDir;
+    for (uint32 axis = 0; axis < 3; axis++)
+    {
+        rayInvDir[axis] = rayDir[axis] != 0 ? 1.0f / rayDir[axis] : FLT_MAX;
+    }
+    bool useSse = getSimdLevel() != SIMD_LEVEL_SCALAR;
+
+    BvhRaycastHit closestHit;
+    closestHit.primitiveIndex = 0;
+    closestHit.distance = maxDistance;
+    bool wasHit = false;
+
+    struct StackEntry
+    {
+        uint32 index;
+        uint32 primitiveCount;
+        float enterDistance;
+    };
+    StackEntry stack[BVH_TRAVERSAL_STACK_SIZE];
+    uint32 stackSize = 0;
+    stack[stackSize++] = {0, 0, 0};
+    while (stackSize > 0)
+    {
+        StackEntry entry = stack[--stackSize];
+        if (entry.enterDistance > closestHit.distance)
+        {
+            continue;
+        }
+
+        if (entry.primitiveCount > 0)
+        {
+            if (raycastLeaf(context, bvh, entry.index, entry.primitiveCount, rayOrigin, rayDir, &closestHit))
+            {
+                wasHit = true;
+                if (mode == BVH_RAYCAST_ANY_HIT)
+                {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        BvhNode *node = &bvh->nodes[entry.index];
+        float enterDistances[BVH_WIDTH];
+        uint32 hitMask = useSse
+            ? intersectRayBvhChildren4(rayOrigin, rayInvDir, node, closestHit.distance, enterDistances)
+            : intersectRayBvhChildrenScalar(rayOrigin, rayInvDir, node, closestHit.distance, enterDistances);
+
+        // push the children furthest first so the nearest child is visited next
+        StackEntry hitChildren[BVH_WIDTH];
+        uint32 hitChildCount = 0;
+        for (uint32 i = 0; i < node->childCount; i++)
+        {
+            if (!(hitMask & (1 << i)))
+            {
+                continue;
+            }
+
+            StackEntry child = {node->childIndices[i], node->childPrimitiveCounts[i], enterDistances[i]};
+            uint32 insertIndex = hitChildCount++;
+            while (insertIndex > 0 && hitChildren[insertIndex - 1].enterDistance < child.enterDistance)
+            {
+                hitChildren[insertIndex] = hitChildren[insertIndex - 1];
+                insertIndex--;
+            }
+            hitChildren[insertIndex] = child;
+        }
+
+        assert(stackSize + hitChildCount <= BVH_TRAVERSAL_STACK_SIZE);
+        for (uint32 i = 0; i < hitChildCount; i++)
+        {
+            stack[stackSize++] = hitChildren[i];
+        }
+    }
+
+    if (wasHit)
+    {
+        *outHit = closestHit;
+    }
+    return wasHit;
+}
+
+void bvhTransformBounds(
+    glm::mat4 transform, glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3 *outMin, glm::vec3 *outMax)
+{
+    // each axis of the transformed box extends along each transformed basis vector in both directions
+    glm::vec3 center = glm::vec3(transform * glm::vec4((boundsMin + boundsMax) * 0.5f, 1));
+    glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+    glm::vec3 transformedHalfExtent = glm::vec3(0);
+    for (uint32 i = 0; i < 3; i++)
+    {
+        transformedHalfExtent += glm::abs(glm::vec3(transform[i]) * halfExtent[i]);
+    }
+    *outMin = center - transformedHalfExtent;
+    *outMax = center + transformedHalfExtent;
+}
+
+void meshBvhBuild(MeshBvh *meshBvh, MemoryArena *arena, float *vertices, uint32 *indices, uint32 elementCount)
+{
+    uint32 triangleCount = elementCount / 3;
+    bvhInitialize(&meshBvh->bvh, arena, triangleCount);
+    meshBvh->triangleVertices = pushArray(arena, glm::vec3, triangleCount * 3);
+
+    TemporaryMemory buildMemory = beginTemporaryMemory(arena);
+
+    // vertices are interleaved positions and normals
+    glm::vec3 *triangleMins = pushArray(arena, glm::vec3, triangleCount);
+    glm::vec3 *triangleMaxs = pushArray(arena, glm::vec3, triangleCount);
+    for (uint32 i = 0; i < triangleCount; i++)
+    {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+        for (uint32 j = 0; j < 3; j++)
+        {
+            float *position = &vertices[indices[(i * 3) + j] * 6];
+            glm::vec3 vertex = glm::vec3(position[0], position[1], position[2]);
+            min = glm::min(min, vertex);
+            max = glm::max(max, vertex);
+        }
+        triangleMins[i] = min;
+        triangleMaxs[i] = max;
+    }
+
+    bvhBuild(&meshBvh->bvh, arena, triangleMins, triangleMaxs, triangleCount);
+
+    endTemporaryMemory(&buildMemory);
+
+    glm::vec3 *dstVertex = meshBvh->triangleVertices;
+    for (uint32 i = 0; i < triangleCount; i++)
+    {
+        uint32 triangleIndex = meshBvh->bvh.primitiveIndices[i];
+        for (uint32 j = 0; j < 3; j++)
+        {
+            float *position = &vertices[indices[(triangleIndex * 3) + j] * 6];
+            *dstVertex++ = glm::vec3(position[0], position[1], position[2]);
+        }
+    }
+}
+
+BVH_RAYCAST_LEAF(raycastMeshBvhLeaf)
+{
+    MeshBvh *meshBvh = (MeshBvh *)context;
+    assert(count <= RAY_TRIANGLE_BATCH_SIZE);
+
+    RayTriangleBatch batch;
+    batch.count = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        glm::vec3 *triangle = &meshBvh->triangleVertices[(first + i) * 3];
+        rayTriangleBatchPush(&batch, triangle[0], triangle[1], triangle[2]);
+    }
+
+    float distances[RAY_TRIANGLE_BATCH_SIZE];
+    uint32 hitMask = intersectRayTriangleBatch(rayOrigin, rayDir, &batch, distances);
+
+    bool wasUpdated = false;
+    for (uint32 i = 0; i < count; i++)
+    {
+        if ((hitMask & (1 << i)) && distances[i] < closestHit->distance)
+        {
+            glm::vec3 edge1 = glm::vec3(batch.edge1x[i], batch.edge1y[i], batch.edge1z[i]);
+            glm::vec3 edge2 = glm::vec3(batch.edge2x[i], batch.edge2y[i], batch.edge2z[i]);
+            closestHit->primitiveIndex = bvh->primitiveIndices[first + i];
+            closestHit->distance = distances[i];
+            closestHit->normal = glm::cross(edge1, edge2);
+            wasUpdated = true;
+        }
+    }
+    return wasUpdated;
+}
+
+bool meshBvhRaycast(
+    MeshBvh *meshBvh, glm::vec3 rayOrigin, glm::vec3 rayDir, float maxDistance, BvhRaycastHit *outHit)
+{
+    return bvhRaycast(&meshBvh->bvh, rayOrigin, rayDir, maxDistance, BVH_RAYCAST_CLOSEST_HIT, raycastMeshBvhLeaf,
+        meshBvh, outHit);
+}
+bool meshBvhIsRayOccluded(MeshBvh *meshBvh, glm::vec3 rayOrigin, glm::vec3 rayDir, float maxDistance)
+{
+    BvhRaycastHit hit;
+    return bvhRaycast(
+        &meshBvh->bvh, rayOrigin, rayDir, maxDistance, BVH_RAYCAST_ANY_HIT, raycastMeshBvhLeaf, meshBvh, &hit);
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef SIERRA_BVH_H
+#define SIERRA_BVH_H
+
+/*
+ * Bounding volume hierarchies over the axis-aligned bounds of a set of primitives, used to raycast
+ * object instances and the triangles of their meshes on the CPU. The hierarchy only stores indices
+ * so the caller decides how the primitives in each leaf are tested against a ray.
+ *
+ * Hierarchies are built as binary trees using the surface area heuristic and then collapsed into
+ * 4-wide trees, so a ray can be tested against all of a node's children at once.
+ */
+
+// a mesh leaf's triangles fit in a single ray/triangle batch
+#define BVH_MAX_LEAF_PRIMITIVES RAY_TRIANGLE_BATCH_SIZE
+#define BVH_WIDTH 4
+#define BVH_SAH_BIN_COUNT 12
+#define BVH_TRAVERSAL_STACK_SIZE 128
+
+struct BvhNode
+{
+    // bounds of the node's children in structure-of-arrays layout
+    float childMinX[BVH_WIDTH];
+    float childMinY[BVH_WIDTH];
+    float childMinZ[BVH_WIDTH];
+    float childMaxX[BVH_WIDTH];
+    float childMaxY[BVH_WIDTH];
+    float childMaxZ[BVH_WIDTH];
+
+    /*
+     * Children with no primitives are interior nodes at nodes[childIndices[i]], the others are leaves
+     * referencing childPrimitiveCounts[i] primitive indices starting at childIndices[i].
+     */
+    uint32 childIndices[BVH_WIDTH];
+    uint32 childPrimitiveCounts[BVH_WIDTH];
+    uint32 childCount;
+};
+
+// binary tree node used while building a hierarchy, before it is collapsed
+struct BvhBuildNode
+{
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+
+    // leaves reference primitive indices, interior nodes reference their first child (the second follows it)
+    uint32 firstIndex;
+    uint32 primitiveCount;
+};
+
+struct Bvh
+{
+    // the root is the first node, there are no nodes if there are no primitives
+    BvhNode *nodes;
+    uint32 nodeCount;
+    uint32 maxNodeCount;
+
+    // indices of the original primitives, ordered so that each leaf's primitives are contiguous
+    uint32 *primitiveIndices;
+    uint32 primitiveCount;
+    uint32 maxPrimitiveCount;
+
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+struct MeshBvh
+{
+    Bvh bvh;
+
+    // three vertices per triangle, in the same order as the BVH's primitive indices
+    glm::vec3 *triangleVertices;
+};
+
+enum BvhRaycastMode
+{
+    // find the closest primitive along the ray
+    BVH_RAYCAST_CLOSEST_HIT,
+
+    // stop at the first primitive found along the ray, for occlusion tests
+    BVH_RAYCAST_ANY_HIT
+};
+
+struct BvhRaycastHit
+{
+    // index of the original primitive that was hit
+    uint32 primitiveIndex;
+
+    // distance along the ray in multiples of the ray direction's length
+    float distance;
+
+    // geometric normal of the primitive that was hit, not normalized
+    glm::vec3 normal;
+};
+
+/*
+ * Tests a ray against the primitives of a leaf (primitiveIndices[first] onwards) and updates the
+ * closest hit if any of them are hit before it. Returns whether the closest hit was updated.
+ */
+#define BVH_RAYCAST_LEAF(name)                                                                                    \
+    bool name(void *context, Bvh *bvh, uint32 first, uint32 count, glm::vec3 rayOrigin, glm::vec3 rayDir,         \
+        BvhRaycastHit *closestHit)
+typedef BVH_RAYCAST_LEAF(BvhRaycastLeaf);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,457 @@
+#include "sierra_geometry.h"
+
+bool isRayIntersectingTriangleEdges(glm::vec3 rayOrigin,
+    glm::vec3 rayVector,
+    glm::vec3 v1,
+    glm::vec3 edge1,
+    glm::vec3 edge2,
+    float *out_intersectionDistance)
+{
+    // Moller-Trumbore intersection algorithm
+    // https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
+
+    glm::vec3 h, s, q;
+    float a, f, u, v;
+    h = glm::cross(rayVector, edge2);
+    a = glm::dot(edge1, h);
+    if (a > -RAY_TRIANGLE_EPSILON && a < RAY_TRIANGLE_EPSILON)
+        return false; // ray is parallel to this triangle
+
+    f = 1.0f / a;
+    s = rayOrigin - v1;
+    u = f * glm::dot(s, h);
+    if (u < 0.0f || u > 1.0f)
+        return false;
+    q = glm::cross(s, edge1);
+    v = f * glm::dot(rayVector, q);
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    // compute t to find out where the intersection point is on the line
+    float t = f * glm::dot(edge2, q);
+    if (t <= RAY_TRIANGLE_EPSILON)
+        return false; // there is a line intersection but not a ray intersection
+
+    *out_intersectionDistance = t;
+    return true;
+}
+bool isRayIntersectingTriangle(glm::vec3 rayOrigin,
+    glm::vec3 rayVector,
+    glm::vec3 v1,
+    glm::vec3 v2,
+    glm::vec3 v3,
+    float *out_intersectionDistance)
+{
+    return isRayIntersectingTriangleEdges(rayOrigin, rayVector, v1, v2 - v1, v3 - v1, out_intersectionDistance);
+}
+
+bool isRayIntersectingBox(
+    glm::vec3 rayOrigin, glm::vec3 rayDir, glm::vec3 boxMin, glm::vec3 boxMax, float *outEnterDistance)
+{
+    // slab test, a ray starting inside the box enters it at a distance of zero
+    float tMin = 0;
+    float tMax = FLT_MAX;
+    for (uint32 axis = 0; axis < 3; axis++)
+    {
+        if (rayDir[axis] == 0)
+        {
+            if (rayOrigin[axis] < boxMin[axis] || rayOrigin[axis] > boxMax[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float invDir = 1.0f / rayDir[axis];
+        float tNear = (boxMin[axis] - rayOrigin[axis]) * invDir;
+        float tFar = (boxMax[axis] - rayOrigin[axis]) * invDir;
+        if (tNear > tFar)
+        {
+            float temp = tNear;
+            tNear = tFar;
+            tFar = temp;
+        }
+        tMin = fmaxf(tMin, tNear);
+        tMax = fminf(tMax, tFar);
+        if (tMin > tMax)
+        {
+            return false;
+        }
+    }
+
+    *outEnterDistance = tMin;
+    return true;
+}
+
+void rayTriangleBatchPush(RayTriangleBatch *batch, glm::vec3 v1, glm::vec3 v2, glm::vec3 v3)
+{
+    assert(batch->count < RAY_TRIANGLE_BATCH_SIZE);
+
+    glm::vec3 edge1 = v2 - v1;
+    glm::vec3 edge2 = v3 - v1;
+    uint32 i = batch->count++;
+    batch->v1x[i] = v1.x;
+    batch->v1y[i] = v1.y;
+    batch->v1z[i] = v1.z;
+    batch->edge1x[i] = edge1.x;
+    batch->edge1y[i] = edge1.y;
+    batch->edge1z[i] = edge1.z;
+    batch->edge2x[i] = edge2.x;
+    batch->edge2y[i] = edge2.y;
+    batch->edge2z[i] = edge2.z;
+}
+
+/*
+ * The batch kernels perform the same floating-point operations as isRayIntersectingTriangleEdges
+ * (in the same order and without fused multiply-adds) so every version reports the same hits.
+ */
+
+uint32 intersectRayTrianglesScalar(
+    glm::vec3 rayOrigin, glm::vec3 rayDir, RayTriangleBatch *batch, float *outDistances)
+{
+    uint32 hitMask = 0;
+    for (uint32 i = 0; i < batch->count; i++)
+    {
+        glm::vec3 v1 = glm::vec3(batch->v1x[i], batch->v1y[i], batch->v1z[i]);
+        glm::vec3 edge1 = glm::vec3(batch->edge1x[i], batch->edge1y[i], batch->edge1z[i]);
+        glm::vec3 edge2 = glm::vec3(batch->edge2x[i], batch->edge2y[i], batch->edge2z[i]);
+        if (isRayIntersectingTriangleEdges(rayOrigin, rayDir, v1, edge1, edge2, &outDistances[i]))
+        {
+            hitMask |= 1 << i;
+        }
+    }
+    return hitMask;
+}
+
+struct RayPacket4
+{
+    __m128 originX, originY, originZ;
+    __m128 dirX, dirY, dirZ;
+};
+inline __m128 dot4(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+inline __m128 crossComponent4(__m128 a1, __m128 b2, __m128 b1, __m128 a2)
+{
+    // one component of a cross product, a1 * b2 - b1 * a2
+    return _mm_sub_ps(_mm_mul_ps(a1, b2), _mm_mul_ps(b1, a2));
+}
+uint32 intersectRayTriangles4(RayPacket4 *ray, RayTriangleBatch *batch, uint32 first, float *outDistances)
+{
+    __m128 epsilon = _mm_set1_ps(RAY_TRIANGLE_EPSILON);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 v1x = _mm_loadu_ps(&batch->v1x[first]);
+    __m128 v1y = _mm_loadu_ps(&batch->v1y[first]);
+    __m128 v1z = _mm_loadu_ps(&batch->v1z[first]);
+    __m128 e1x = _mm_loadu_ps(&batch->edge1x[first]);
+    __m128 e1y = _mm_loadu_ps(&batch->edge1y[first]);
+    __m128 e1z = _mm_loadu_ps(&batch->edge1z[first]);
+    __m128 e2x = _mm_loadu_ps(&batch->edge2x[first]);
+    __m128 e2y = _mm_loadu_ps(&batch->edge2y[first]);
+    __m128 e2z = _mm_loadu_ps(&batch->edge2z[first]);
+
+    __m128 hx = crossComponent4(ray->dirY, e2z, e2y, ray->dirZ);
+    __m128 hy = crossComponent4(ray->dirZ, e2x, e2z, ray->dirX);
+    __m128 hz = crossComponent4(ray->dirX, e2y, e2x, ray->dirY);
+    __m128 a = dot4(e1x, e1y, e1z, hx, hy, hz);
+    __m128 isParallel = _mm_and_ps(_mm_cmpgt_ps(a, _mm_sub_ps(zero, epsilon)), _mm_cmplt_ps(a, epsilon));
+
+    __m128 f = _mm_div_ps(one, a);
+    __m128 sx = _mm_sub_ps(ray->originX, v1x);
+    __m128 sy = _mm_sub_ps(ray->originY, v1y);
+    __m128 sz = _mm_sub_ps(ray->originZ, v1z);
+    __m128 u = _mm_mul_ps(f, dot4(sx, sy, sz, hx, hy, hz));
+    __m128 isOutsideU = _mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmpgt_ps(u, one));
+
+    __m128 qx = crossComponent4(sy, e1z, e1y, sz);
+    __m128 qy = crossComponent4(sz, e1x, e1z, sx);
+    __m128 qz = crossComponent4(sx, e1y, e1x, sy);
+    __m128 v = _mm_mul_ps(f, dot4(ray->dirX, ray->dirY, ray->dirZ, qx, qy, qz));
+    __m128 isOutsideV = _mm_or_ps(_mm_cmplt_ps(v, zero), _mm_cmpgt_ps(_mm_add_ps(u, v), one));
+
+    __m128 t = _mm_mul_ps(f, dot4(e2x, e2y, e2z, qx, qy, qz));
+    __m128 isBehind = _mm_cmple_ps(t, epsilon);
+
+    __m128 isMiss = _mm_or_ps(_mm_or_ps(isParallel, isOutsideU), _mm_or_ps(isOutsideV, isBehind));
+    _mm_storeu_ps(&outDistances[first], t);
+    return (~_mm_movemask_ps(isMiss) & 0xF) << first;
+}
+
+struct RayPacket8
+{
+    __m256 originX, originY, originZ;
+    __m256 dirX, dirY, dirZ;
+};
+inline __m256 dot8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+inline __m256 crossComponent8(__m256 a1, __m256 b2, __m256 b1, __m256 a2)
+{
+    return _mm256_sub_ps(_mm256_mul_ps(a1, b2), _mm256_mul_ps(b1, a2));
+}
+uint32 intersectRayTriangles8(RayPacket8 *ray, RayTriangleBatch *batch, float *outDistances)
+{
+    __m256 epsilon = _mm256_set1_ps(RAY_TRIANGLE_EPSILON);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 v1x = _mm256_loadu_ps(batch->v1x);
+    __m256 v1y = _mm256_loadu_ps(batch->v1y);
+    __m256 v1z = _mm256_loadu_ps(batch->v1z);
+    __m256 e1x = _mm256_loadu_ps(batch->edge1x);
+    __m256 e1y = _mm256_loadu_ps(batch->edge1y);
+    __m256 e1z = _mm256_loadu_ps(batch->edge1z);
+    __m256 e2x = _mm256_loadu_ps(batch->edge2x);
+    __m256 e2y = _mm256_loadu_ps(batch->edge2y);
+    __m256 e2z = _mm256_loadu_ps(batch->edge2z);
+
+    __m256 hx = crossComponent8(ray->dirY, e2z, e2y, ray->dirZ);
+    __m256 hy = crossComponent8(ray->dirZ, e2x, e2z, ray->dirX);
+    __m256 hz = crossComponent8(ray->dirX, e2y, e2x, ray->dirY);
+    __m256 a = dot8(e1x, e1y, e1z, hx, hy, hz);
+    __m256 isParallel = _mm256_and_ps(_mm256_cmp_ps(a, _mm256_sub_ps(zero, epsilon), _CMP_GT_OQ),
+        _mm256_cmp_ps(a, epsilon, _CMP_LT_OQ));
+
+    __m256 f = _mm256_div_ps(one, a);
+    __m256 sx = _mm256_sub_ps(ray->originX, v1x);
+    __m256 sy = _mm256_sub_ps(ray->originY, v1y);
+    __m256 sz = _mm256_sub_ps(ray->originZ, v1z);
+    __m256 u = _mm256_mul_ps(f, dot8(sx, sy, sz, hx, hy, hz));
+    __m256 isOutsideU = _mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ), _mm256_cmp_ps(u, one, _CMP_GT_OQ));
+
+    __m256 qx = crossComponent8(sy, e1z, e1y, sz);
+    __m256 qy = crossComponent8(sz, e1x, e1z, sx);
+    __m256 qz = crossComponent8(sx, e1y, e1x, sy);
+    __m256 v = _mm256_mul_ps(f, dot8(ray->dirX, ray->dirY, ray->dirZ, qx, qy, qz));
+    __m256 isOutsideV =
+        _mm256_or_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_GT_OQ));
+
+    __m256 t = _mm256_mul_ps(f, dot8(e2x, e2y, e2z, qx, qy, qz));
+    __m256 isBehind = _mm256_cmp_ps(t, epsilon, _CMP_LE_OQ);
+
+    __m256 isMiss = _mm256_or_ps(_mm256_or_ps(isParallel, isOutsideU), _mm256_or_ps(isOutsideV, isBehind));
+    _mm256_storeu_ps(outDistances, t);
+    return ~_mm256_movemask_ps(isMiss) & 0xFF;
+}
+
+/*
+ * Tests a ray against every triangle in the batch. Returns a mask with bit i set if triangle i was
+ * hit, in which case outDistances[i] is the distance to the hit in multiples of the ray direction.
+ */
+uint32 intersectRayTriangleBatch(
+    glm::vec3 rayOrigin, glm::vec3 rayDir, RayTriangleBatch *batch, float *outDistances)
+{
+    uint32 laneMask = (1 << batch->count) - 1;
+    switch (getSimdLevel())
+    {
+    case SIMD_LEVEL_AVX2:
+    {
+        RayPacket8 ray;
+        ray.originX = _mm256_set1_ps(rayOrigin.x);
+        ray.originY = _mm256_set1_ps(rayOrigin.y);
+        ray.originZ = _mm256_set1_ps(rayOrigin.z);
+        ray.dirX = _mm256_set1_ps(rayDir.x);
+        ray.dirY = _mm256_set1_ps(rayDir.y);
+        ray.dirZ = _mm256_set1_ps(rayDir.z);
+        return intersectRayTriangles8(&ray, batch, outDistances) & laneMask;
+    }
+    case SIMD_LEVEL_SSE4:
+    {
+        RayPacket4 ray;
+        ray.originX = _mm_set1_ps(rayOrigin.x);
+        ray.originY = _mm_set1_ps(rayOrigin.y);
+        ray.originZ = _mm_set1_ps(rayOrigin.z);
+        ray.dirX = _mm_set1_ps(rayDir.x);
+        ray.dirY = _mm_set1_ps(rayDir.y);
+        ray.dirZ = _mm_set1_ps(rayDir.z);
+        uint32 hitMask = intersectRayTriangles4(&ray, batch, 0, outDistances);
+        if (batch->count > 4)
+        {
+            hitMask |= intersectRayTriangles4(&ray, batch, 4, outDistances);
+        }
+        return hitMask & laneMask;
+    }
+    default:
+        return intersectRayTrianglesScalar(rayOrigin, rayDir, batch, outDistances);
+    }
+}
+
+/*
+ * Builds the frustum covering a rectangle of normalized device coordinates from a view-projection
+ * transform. Each plane is a combination of the transform's rows, so the planes are in world space.
+ */
+Frustum getFrustum(glm::mat4 transform, glm::vec2 ndcMin, glm::vec2 ndcMax)
+{
+    glm::vec4 rowX = glm::vec4(transform[0][0], transform[1][0], transform[2][0], transform[3][0]);
+    glm::vec4 rowY = glm::vec4(transform[0][1], transform[1][1], transform[2][1], transform[3][1]);
+    glm::vec4 rowZ = glm::vec4(transform[0][2], transform[1][2], transform[2][2], transform[3][2]);
+    glm::vec4 rowW = glm::vec4(transform[0][3], transform[1][3], transform[2][3], transform[3][3]);
+
+    Frustum result;
+    result.planes[0] = rowX - (rowW * ndcMin.x);
+    result.planes[1] = (rowW * ndcMax.x) - rowX;
+    result.planes[2] = rowY - (rowW * ndcMin.y);
+    result.planes[3] = (rowW * ndcMax.y) - rowY;
+    result.planes[4] = rowW + rowZ;
+    result.planes[5] = rowW - rowZ;
+    return result;
+}
+
+struct FrustumBoxPlane
+{
+    // the coordinates of each box's corner that is furthest along the plane's normal
+    float *cornerX;
+    float *cornerY;
+    float *cornerZ;
+    glm::vec4 plane;
+};
+
+/*
+ * A box is outside the frustum if its furthest corner along any plane's normal is behind that plane.
+ * This is conservative, boxes near the frustum's edges can be reported as inside when they are not.
+ * Every version performs the same floating-point operations in the same order so they agree.
+ */
+
+uint32 getBoxesInFrustumScalar(FrustumBoxPlane *planes, uint32 first, uint32 last, uint32 *outIndices)
+{
+    uint32 resultCount = 0;
+    for (uint32 i = first; i < last; i++)
+    {
+        bool isOutside = false;
+        for (uint32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            FrustumBoxPlane *plane = &planes[p];
+            float distance = (plane->plane.x * plane->cornerX[i]) + (plane->plane.y * plane->cornerY[i]);
+            distance = (distance + (plane->plane.z * plane->cornerZ[i])) + plane->plane.w;
+            if (distance < 0)
+            {
+                isOutside = true;
+            }
+        }
+        if (!isOutside)
+        {
+            outIndices[resultCount++] = i;
+        }
+    }
+    return resultCount;
+}
+uint32 getBoxesInFrustum4(FrustumBoxPlane *planes, uint32 first, uint32 last, uint32 *outIndices)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 planeX[FRUSTUM_PLANE_COUNT];
+    __m128 planeY[FRUSTUM_PLANE_COUNT];
+    __m128 planeZ[FRUSTUM_PLANE_COUNT];
+    __m128 planeW[FRUSTUM_PLANE_COUNT];
+    for (uint32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].plane.x);
+        planeY[p] = _mm_set1_ps(planes[p].plane.y);
+        planeZ[p] = _mm_set1_ps(planes[p].plane.z);
+        planeW[p] = _mm_set1_ps(planes[p].plane.w);
+    }
+
+    uint32 resultCount = 0;
+    for (uint32 i = first; i + 4 <= last; i += 4)
+    {
+        __m128 isOutside = zero;
+        for (uint32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            __m128 x = _mm_loadu_ps(&planes[p].cornerX[i]);
+            __m128 y = _mm_loadu_ps(&planes[p].cornerY[i]);
+            __m128 z = _mm_loadu_ps(&planes[p].cornerZ[i]);
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y));
+            distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(planeZ[p], z)), planeW[p]);
+            isOutside = _mm_or_ps(isOutside, _mm_cmplt_ps(distance, zero));
+        }
+
+        uint32 insideMask = ~_mm_movemask_ps(isOutside) & 0xF;
+        for (uint32 lane = 0; lane < 4; lane++)
+        {
+            if (insideMask & (1 << lane))
+            {
+                outIndices[resultCount++] = i + lane;
+            }
+        }
+    }
+    return resultCount;
+}
+uint32 getBoxesInFrustum8(FrustumBoxPlane *planes, uint32 first, uint32 last, uint32 *outIndices)
+{
+    __m256 zero = _mm256_setzero_ps();
+    __m256 planeX[FRUSTUM_PLANE_COUNT];
+    __m256 planeY[FRUSTUM_PLANE_COUNT];
+    __m256 planeZ[FRUSTUM_PLANE_COUNT];
+    __m256 planeW[FRUSTUM_PLANE_COUNT];
+    for (uint32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+    {
+        planeX[p] = _mm256_set1_ps(planes[p].plane.x);
+        planeY[p] = _mm256_set1_ps(planes[p].plane.y);
+        planeZ[p] = _mm256_set1_ps(planes[p].plane.z);
+        planeW[p] = _mm256_set1_ps(planes[p].plane.w);
+    }
+
+    uint32 resultCount = 0;
+    for (uint32 i = first; i + 8 <= last; i += 8)
+    {
+        __m256 isOutside = zero;
+        for (uint32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            __m256 x = _mm256_loadu_ps(&planes[p].cornerX[i]);
+            __m256 y = _mm256_loadu_ps(&planes[p].cornerY[i]);
+            __m256 z = _mm256_loadu_ps(&planes[p].cornerZ[i]);
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y));
+            distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(planeZ[p], z)), planeW[p]);
+            isOutside = _mm256_or_ps(isOutside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+        }
+
+        uint32 insideMask = ~_mm256_movemask_ps(isOutside) & 0xFF;
+        for (uint32 lane = 0; lane < 8; lane++)
+        {
+            if (insideMask & (1 << lane))
+            {
+                outIndices[resultCount++] = i + lane;
+            }
+        }
+    }
+    return resultCount;
+}
+
+/*
+ * Writes the indices of the boxes that intersect the frustum to outIndices, which must have room for
+ * an index per box. Returns the number of indices written.
+ */
+uint32 getBoxesInFrustum(Frustum *frustum, BoundingBoxArray *boxes, uint32 *outIndices)
+{
+    // the furthest corner along a plane's normal is the same for every box, so select it up front
+    FrustumBoxPlane planes[FRUSTUM_PLANE_COUNT];
+    for (uint32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+    {
+        glm::vec4 plane = frustum->planes[p];
+        planes[p].cornerX = plane.x >= 0 ? boxes->maxX : boxes->minX;
+        planes[p].cornerY = plane.y >= 0 ? boxes->maxY : boxes->minY;
+        planes[p].cornerZ = plane.z >= 0 ? boxes->maxZ : boxes->minZ;
+        planes[p].plane = plane;
+    }
+
+    uint32 resultCount = 0;
+    uint32 vectorizedCount = 0;
+    switch (getSimdLevel())
+    {
+    case SIMD_LEVEL_AVX2:
+        vectorizedCount = boxes->count & ~7;
+        resultCount = getBoxesInFrustum8(planes, 0, vectorizedCount, outIndices);
+        break;
+    case SIMD_LEVEL_SSE4:
+        vectorizedCount = boxes->count & ~3;
+        resultCount = getBoxesInFrustum4(planes, 0, vectorizedCount, outIndices);
+        break;
+    default:
+        break;
+    }
+    resultCount +=
+        getBoxesInFrustumScalar(planes, vectorizedCount, boxes->count, &outIndices[resultCount]);
+
+    return resultCount;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef SIERRA_GEOMETRY_H
+#define SIERRA_GEOMETRY_H
+
+#define RAY_TRIANGLE_EPSILON 0.0000001f
+#define RAY_TRIANGLE_BATCH_SIZE 8
+
+struct RayTriangleBatch
+{
+    // triangles in structure-of-arrays layout, as their first vertex and the edges to the other two
+    float v1x[RAY_TRIANGLE_BATCH_SIZE];
+    float v1y[RAY_TRIANGLE_BATCH_SIZE];
+    float v1z[RAY_TRIANGLE_BATCH_SIZE];
+    float edge1x[RAY_TRIANGLE_BATCH_SIZE];
+    float edge1y[RAY_TRIANGLE_BATCH_SIZE];
+    float edge1z[RAY_TRIANGLE_BATCH_SIZE];
+    float edge2x[RAY_TRIANGLE_BATCH_SIZE];
+    float edge2y[RAY_TRIANGLE_BATCH_SIZE];
+    float edge2z[RAY_TRIANGLE_BATCH_SIZE];
+    uint32 count;
+};
+
+#define FRUSTUM_PLANE_COUNT 6
+
+struct Frustum
+{
+    // planes as (normal, distance) with inward-facing normals, p is inside if dot(normal, p) + distance >= 0
+    glm::vec4 planes[FRUSTUM_PLANE_COUNT];
+};
+
+struct BoundingBoxArray
+{
+    // axis-aligned boxes in structure-of-arrays layout
+    float *minX;
+    float *minY;
+    float *minZ;
+    float *maxX;
+    float *maxY;
+    float *maxZ;
+    uint32 count;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,581 @@
+#include "sierra_heightfield.h"
+
+void heightfieldInitialize(Heightfield *heightfield,
+    MemoryArena *arena,
+    uint32 samplesPerEdge,
+    float lengthInWorldUnits,
+    uint32 heightmapDim,
+    float heightmapOverlapInTexels)
+{
+    uint32 heightmapLengthWithoutOverlap = heightmapDim - (uint32)(2 * heightmapOverlapInTexels);
+    assert(samplesPerEdge >= 2);
+    assert(samplesPerEdge <= heightmapLengthWithoutOverlap + 1);
+
+    uint32 sampleCount = samplesPerEdge * samplesPerEdge;
+    heightfield->samplesPerEdge = samplesPerEdge;
+    heightfield->spacing = lengthInWorldUnits / (samplesPerEdge - 1);
+    heightfield->heights = pushArray(arena, float, sampleCount);
+    heightfield->sampleTexels = pushArray(arena, uint32, samplesPerEdge);
+    heightfield->sampleLerps = pushArray(arena, float, samplesPerEdge);
+    memset(heightfield->heights, 0, sampleCount * sizeof(float));
+
+    float texelsPerSample = (float)heightmapLengthWithoutOverlap / (samplesPerEdge - 1);
+    for (uint32 i = 0; i < samplesPerEdge; i++)
+    {
+        float t = heightmapOverlapInTexels + (i * texelsPerSample);
+        uint32 texel = (uint32)floor(t);
+        assert(texel + 1 < heightmapDim);
+
+        heightfield->sampleTexels[i] = texel;
+        heightfield->sampleLerps[i] = t - (float)texel;
+    }
+
+    // the heights start out as zero so every level of the pyramid does too
+    uint32 cellsPerEdge = samplesPerEdge - 1;
+    heightfield->levelCount = 0;
+    while (true)
+    {
+        assert(heightfield->levelCount < HEIGHTFIELD_MAX_PYRAMID_LEVELS);
+        HeightfieldPyramidLevel *level = &heightfield->levels[heightfield->levelCount++];
+
+        uint32 cellCount = cellsPerEdge * cellsPerEdge;
+        level->cellsPerEdge = cellsPerEdge;
+        level->minHeights = pushArray(arena, float, cellCount);
+        level->maxHeights = pushArray(arena, float, cellCount);
+        memset(level->minHeights, 0, cellCount * sizeof(float));
+        memset(level->maxHeights, 0, cellCount * sizeof(float));
+
+        if (cellsPerEdge == 1)
+        {
+            break;
+        }
+        cellsPerEdge = (cellsPerEdge + 1) / 2;
+    }
+}
+
+/*
+ * The row kernels perform the same floating-point operations as lerp (in the same order and
+ * without fused multiply-adds), so the vector versions produce identical heights.
+ */
+
+inline uint32 loadTexelPair(uint16 *texel)
+{
+    uint32 result;
+    memcpy(&result, texel, sizeof(result));
+    return result;
+}
+
+void downsampleRowScalar(float *dst,
+    uint16 *topRow,
+    uint16 *bottomRow,
+    uint32 *texels,
+    float *lerps,
+    uint32 count,
+    float yLerp,
+    float heightScalar)
+{
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint16 *topLeft = &topRow[texels[i]];
+        uint16 *bottomLeft = &bottomRow[texels[i]];
+        float top = lerp(topLeft[0], topLeft[1], lerps[i]);
+        float bottom = lerp(bottomLeft[0], bottomLeft[1], lerps[i]);
+        dst[i] = lerp(top, bottom, yLerp) * heightScalar;
+    }
+}
+inline __m128 lerp4(__m128 a, __m128 b, __m128 t)
+{
+    __m128 oneMinusT = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+    return _mm_add_ps(_mm_mul_ps(oneMinusT, a), _mm_mul_ps(t, b));
+}
+inline __m128 lerpTexelPairs4(__m128i pairs, __m128 t)
+{
+    // each pair holds a texel in its low 16 bits and the texel to its right in its high 16 bits
+    __m128 left = _mm_cvtepi32_ps(_mm_and_si128(pairs, _mm_set1_epi32(0xFFFF)));
+    __m128 right = _mm_cvtepi32_ps(_mm_srli_epi32(pairs, 16));
+    return lerp4(left, right, t);
+}
+void downsampleRowSse4(float *dst,
+    uint16 *topRow,
+    uint16 *bottomRow,
+    uint32 *texels,
+    float *lerps,
+    uint32 count,
+    float yLerp,
+    float heightScalar)
+{
+    __m128 yLerp4 = _mm_set1_ps(yLerp);
+    __m128 heightScalar4 = _mm_set1_ps(heightScalar);
+
+    uint32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32 *t = &texels[i];
+        __m128i topPairs = _mm_setr_epi32(loadTexelPair(&topRow[t[0]]), loadTexelPair(&topRow[t[1]]),
+            loadTexelPair(&topRow[t[2]]), loadTexelPair(&topRow[t[3]]));
+        __m128i bottomPairs = _mm_setr_epi32(loadTexelPair(&bottomRow[t[0]]), loadTexelPair(&bottomRow[t[1]]),
+            loadTexelPair(&bottomRow[t[2]]), loadTexelPair(&bottomRow[t[3]]));
+
+        __m128 xLerp = _mm_loadu_ps(&lerps[i]);
+        __m128 top = lerpTexelPairs4(topPairs, xLerp);
+        __m128 bottom = lerpTexelPairs4(bottomPairs, xLerp);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(lerp4(top, bottom, yLerp4), heightScalar4));
+    }
+    downsampleRowScalar(
+        &dst[i], topRow, bottomRow, &texels[i], &lerps[i], count - i, yLerp, heightScalar);
+}
+inline __m256 lerp8(__m256 a, __m256 b, __m256 t)
+{
+    __m256 oneMinusT = _mm256_sub_ps(_mm256_set1_ps(1.0f), t);
+    return _mm256_add_ps(_mm256_mul_ps(oneMinusT, a), _mm256_mul_ps(t, b));
+}
+inline __m256 lerpTexelPairs8(__m256i pairs, __m256 t)
+{
+    __m256 left = _mm256_cvtepi32_ps(_mm256_and_si256(pairs, _mm256_set1_epi32(0xFFFF)));
+    __m256 right = _mm256_cvtepi32_ps(_mm256_srli_epi32(pairs, 16));
+    return lerp8(left, right, t);
+}
+void downsampleRowAvx2(float *dst,
+    uint16 *topRow,
+    uint16 *bottomRow,
+    uint32 *texels,
+    float *lerps,
+    uint32 count,
+    float yLerp,
+    float heightScalar)
+{
+    __m256 yLerp8 = _mm256_set1_ps(yLerp);
+    __m256 heightScalar8 = _mm256_set1_ps(heightScalar);
+
+    uint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // gathering 32 bits at each texel's offset loads the texel and its right neighbour together
+        __m256i offsets = _mm256_loadu_si256((__m256i *)&texels[i]);
+        __m256i topPairs = _mm256_i32gather_epi32((int32 *)topRow, offsets, sizeof(uint16));
+        __m256i bottomPairs = _mm256_i32gather_epi32((int32 *)bottomRow, offsets, sizeof(uint16));
+
+        __m256 xLerp = _mm256_loadu_ps(&lerps[i]);
+        __m256 top = lerpTexelPairs8(topPairs, xLerp);
+        __m256 bottom = lerpTexelPairs8(bottomPairs, xLerp);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(lerp8(top, bottom, yLerp8), heightScalar8));
+    }
+    downsampleRowScalar(
+        &dst[i], topRow, bottomRow, &texels[i], &lerps[i], count - i, yLerp, heightScalar);
+}
+
+void getSamplesAffectedByTexels(
+    Heightfield *heightfield, uint32 minTexel, uint32 maxTexel, uint32 *outFirstSample, uint32 *outEndSample)
+{
+    // a sample reads its texel and the texel after it, the texel range excludes maxTexel
+    uint32 first = 0;
+    while (first < heightfield->samplesPerEdge && heightfield->sampleTexels[first] + 1 < minTexel)
+    {
+        first++;
+    }
+    uint32 end = first;
+    while (end < heightfield->samplesPerEdge && heightfield->sampleTexels[end] < maxTexel)
+    {
+        end++;
+    }
+
+    *outFirstSample = first;
+    *outEndSample = end;
+}
+
+void updatePyramid(Heightfield *heightfield, uint32 firstX, uint32 endX, uint32 firstY, uint32 endY)
+{
+    // cells are bounded by the samples on both sides of them
+    HeightfieldPyramidLevel *leaves = &heightfield->levels[0];
+    uint32 samplesPerEdge = heightfield->samplesPerEdge;
+    firstX = firstX > 0 ? firstX - 1 : 0;
+    firstY = firstY > 0 ? firstY - 1 : 0;
+    endX = min(endX, leaves->cellsPerEdge);
+    endY = min(endY, leaves->cellsPerEdge);
+    for (uint32 y = firstY; y < endY; y++)
+    {
+        float *top = &heightfield->heights[y * samplesPerEdge];
+        float *bottom = top + samplesPerEdge;
+        for (uint32 x = firstX; x < endX; x++)
+        {
+            uint32 cellIndex = (y * leaves->cellsPerEdge) + x;
+            leaves->minHeights[cellIndex] = fminf(fminf(top[x], top[x + 1]), fminf(bottom[x], bottom[x + 1]));
+            leaves->maxHeights[cellIndex] = fmaxf(fmaxf(top[x], top[x + 1]), fmaxf(bottom[x], bottom[x + 1]));
+        }
+    }
+
+    for (uint32 levelIndex = 1; levelIndex < heightfield->levelCount; levelIndex++)
+    {
+        HeightfieldPyramidLevel *level = &heightfield->levels[levelIndex];
+        HeightfieldPyramidLevel *below = &heightfield->levels[levelIndex - 1];
+        firstX /= 2;
+        firstY /= 2;
+        endX = (endX + 1) / 2;
+        endY = (endY + 1) / 2;
+        for (uint32 y = firstY; y < endY; y++)
+        {
+            uint32 belowY0 = y * 2;
+            uint32 belowY1 = min(belowY0 + 1, below->cellsPerEdge - 1);
+            for (uint32 x = firstX; x < endX; x++)
+            {
+                uint32 belowX0 = x * 2;
+                uint32 belowX1 = min(belowX0 + 1, below->cellsPerEdge - 1);
+                uint32 topLeft = (belowY0 * below->cellsPerEdge) + belowX0;
+                uint32 topRight = (belowY0 * below->cellsPerEdge) + belowX1;
+                uint32 bottomLeft = (belowY1 * below->cellsPerEdge) + belowX0;
+                uint32 bottomRight = (belowY1 * below->cellsPerEdge) + belowX1;
+
+                uint32 cellIndex = (y * level->cellsPerEdge) + x;
+                level->minHeights[cellIndex] =
+                    fminf(fminf(below->minHeights[topLeft], below->minHeights[topRight]),
+                        fminf(below->minHeights[bottomLeft], below->minHeights[bottomRight]));
+                level->maxHeights[cellIndex] =
+                    fmaxf(fmaxf(below->maxHeights[topLeft], below->maxHeights[topRight]),
+                        fmaxf(below->maxHeights[bottomLeft], below->maxHeights[bottomRight]));
+            }
+        }
+    }
+}
+
+void heightfieldUpdate(
+    Heightfield *heightfield, uint16 *pixels, uint32 heightmapDim, rect2 dirtyRect, float maxHeight)
+{
+    if (isRectEmpty(dirtyRect))
+    {
+        return;
+    }
+
+    // only the samples interpolated from texels inside the dirty region need to be rebuilt
+    uint32 firstX, endX, firstY, endY;
+    getSamplesAffectedByTexels(
+        heightfield, (uint32)dirtyRect.x, (uint32)(dirtyRect.x + dirtyRect.width), &firstX, &endX);
+    getSamplesAffectedByTexels(
+        heightfield, (uint32)dirtyRect.y, (uint32)(dirtyRect.y + dirtyRect.height), &firstY, &endY);
+    if (firstX >= endX || firstY >= endY)
+    {
+        return;
+    }
+
+    SimdLevel simdLevel = getSimdLevel();
+    uint32 count = endX - firstX;
+    uint32 *texels = &heightfield->sampleTexels[firstX];
+    float *lerps = &heightfield->sampleLerps[firstX];
+    float heightScalar = maxHeight / (float)UINT16_MAX;
+    for (uint32 y = firstY; y < endY; y++)
+    {
+        float *dst = &heightfield->heights[(y * heightfield->samplesPerEdge) + firstX];
+        uint16 *topRow = &pixels[heightfield->sampleTexels[y] * heightmapDim];
+        uint16 *bottomRow = topRow + heightmapDim;
+        float yLerp = heightfield->sampleLerps[y];
+        switch (simdLevel)
+        {
+        case SIMD_LEVEL_AVX2:
+            downsampleRowAvx2(dst, topRow, bottomRow, texels, lerps, count, yLerp, heightScalar);
+            break;
+        case SIMD_LEVEL_SSE4:
+            downsampleRowSse4(dst, topRow, bottomRow, texels, lerps, count, yLerp, heightScalar);
+            break;
+        default:
+            downsampleRowScalar(dst, topRow, bottomRow, texels, lerps, count, yLerp, heightScalar);
+            break;
+        }
+    }
+
+    updatePyramid(heightfield, firstX, endX, firstY, endY);
+}
+
+// raycasting
+
+void pushRaycastVisCell(RenderQueue *rq, glm::vec3 *corners)
+{
+    glm::vec3 color = glm::vec3(1, 0, 0.5);
+    rendererBeginLine(rq, corners[0], color);
+    rendererExtendLine(rq, corners[1]);
+    rendererExtendLine(rq, corners[2]);
+    rendererEndLineLoop(rq);
+    rendererBeginLine(rq, corners[0], color);
+    rendererExtendLine(rq, corners[2]);
+    rendererExtendLine(rq, corners[3]);
+    rendererEndLineLoop(rq);
+}
+
+struct HeightfieldNode
+{
+    uint32 level;
+    uint32 x;
+    uint32 y;
+
+    // the part of the ray that lies within the node's cells (when projected onto the XZ plane)
+    float tEnter;
+    float tExit;
+};
+
+// the extent of a pyramid cell in world units, relative to the heightfield's minimum corner
+rect2 getNodeBounds(Heightfield *heightfield, uint32 level, uint32 x, uint32 y)
+{
+    uint32 leafCellsPerEdge = heightfield->levels[0].cellsPerEdge;
+    uint32 span = 1 << level;
+    float minX = (float)(x * span);
+    float minY = (float)(y * span);
+    float maxX = (float)min((x + 1) * span, leafCellsPerEdge);
+    float maxY = (float)min((y + 1) * span, leafCellsPerEdge);
+    return rectMinMax(glm::vec2(minX, minY) * heightfield->spacing, glm::vec2(maxX, maxY) * heightfield->spacing);
+}
+
+bool clipRayToRect(glm::vec2 origin, glm::vec2 dir, rect2 rect, float *tMin, float *tMax)
+{
+    glm::vec2 rectMin = getMin(rect);
+    glm::vec2 rectMax = getMax(rect);
+    for (uint32 axis = 0; axis < 2; axis++)
+    {
+        if (dir[axis] == 0)
+        {
+            if (origin[axis] < rectMin[axis] || origin[axis] > rectMax[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float invDir = 1.0f / dir[axis];
+        float tNear = (rectMin[axis] - origin[axis]) * invDir;
+        float tFar = (rectMax[axis] - origin[axis]) * invDir;
+        if (tNear > tFar)
+        {
+            float temp = tNear;
+            tNear = tFar;
+            tFar = temp;
+        }
+        *tMin = fmaxf(*tMin, tNear);
+        *tMax = fminf(*tMax, tFar);
+    }
+    return *tMin <= *tMax;
+}
+
+bool heightfieldRaycast(Heightfield *heightfield,
+    glm::vec2 minCorner,
+    glm::vec3 rayOrigin,
+    glm::vec3 rayDir,
+    RenderQueue *visRq,
+    HeightfieldRaycastHit *outHit)
+{
+    /*
+     * Descend the min/max pyramid, skipping cells that the ray passes entirely above or below. The
+     * children of a cell are visited in the order the ray enters them, so the first cell with a hit
+     * contains the closest hit. Cells on level 1 cover up to 2x2 leaf cells, whose 8 triangles are
+     * tested as a single batch.
+     */
+    glm::vec2 origin = glm::vec2(rayOrigin.x, rayOrigin.z) - minCorner;
+    glm::vec2 dir = glm::vec2(rayDir.x, rayDir.z);
+
+    HeightfieldNode stack[4 * HEIGHTFIELD_MAX_PYRAMID_LEVELS];
+    uint32 stackCount = 0;
+
+    HeightfieldNode *root = &stack[stackCount++];
+    root->level = heightfield->levelCount - 1;
+    root->x = 0;
+    root->y = 0;
+    root->tEnter = 0;
+    root->tExit = FLT_MAX;
+    if (!clipRayToRect(origin, dir, getNodeBounds(heightfield, root->level, 0, 0), &root->tEnter, &root->tExit))
+    {
+        return false;
+    }
+
+    uint32 samplesPerEdge = heightfield->samplesPerEdge;
+    float spacing = heightfield->spacing;
+    while (stackCount > 0)
+    {
+        HeightfieldNode node = stack[--stackCount];
+        HeightfieldPyramidLevel *level = &heightfield->levels[node.level];
+        uint32 cellIndex = (node.y * level->cellsPerEdge) + node.x;
+
+        float rayEnterHeight = rayOrigin.y + (rayDir.y * node.tEnter);
+        float rayExitHeight = rayOrigin.y + (rayDir.y * node.tExit);
+        if (fminf(rayEnterHeight, rayExitHeight) > level->maxHeights[cellIndex]
+            || fmaxf(rayEnterHeight, rayExitHeight) < level->minHeights[cellIndex])
+        {
+            continue;
+        }
+
+        if (node.level > 1)
+        {
+            HeightfieldNode children[4];
+            uint32 childCount = 0;
+            HeightfieldPyramidLevel *childLevel = &heightfield->levels[node.level - 1];
+            for (uint32 i = 0; i < 4; i++)
+            {
+                HeightfieldNode child;
+                child.level = node.level - 1;
+                child.x = (node.x * 2) + (i & 1);
+                child.y = (node.y * 2) + (i >> 1);
+                child.tEnter = node.tEnter;
+                child.tExit = node.tExit;
+                if (child.x >= childLevel->cellsPerEdge || child.y >= childLevel->cellsPerEdge
+                    || !clipRayToRect(origin, dir, getNodeBounds(heightfield, child.level, child.x, child.y),
+                        &child.tEnter, &child.tExit))
+                {
+                    continue;
+                }
+
+                // insertion sort so the child the ray enters last is pushed first
+                uint32 insertIndex = childCount++;
+                while (insertIndex > 0 && children[insertIndex - 1].tEnter < child.tEnter)
+                {
+                    children[insertIndex] = children[insertIndex - 1];
+                    insertIndex--;
+                }
+                children[insertIndex] = child;
+            }
+
+            assert(stackCount + childCount <= arrayCount(stack));
+            for (uint32 i = 0; i < childCount; i++)
+            {
+                stack[stackCount++] = children[i];
+            }
+            continue;
+        }
+
+        // the leaf cells covered by this cell
+        uint32 leafFirstX = node.x << node.level;
+        uint32 leafFirstY = node.y << node.level;
+        uint32 leafEndX = min(leafFirstX + (1 << node.level), heightfield->levels[0].cellsPerEdge);
+        uint32 leafEndY = min(leafFirstY + (1 << node.level), heightfield->levels[0].cellsPerEdge);
+
+        RayTriangleBatch batch;
+        batch.count = 0;
+        glm::vec3 triangles[RAY_TRIANGLE_BATCH_SIZE][3];
+        for (uint32 leafY = leafFirstY; leafY < leafEndY; leafY++)
+        {
+            for (uint32 leafX = leafFirstX; leafX < leafEndX; leafX++)
+            {
+                float *topLeftSample = heightfield->heights + (leafY * samplesPerEdge) + leafX;
+                glm::vec2 start = minCorner + (glm::vec2(leafX, leafY) * spacing);
+                glm::vec3 corners[4] = {
+                    glm::vec3(start.x, topLeftSample[0], start.y),
+                    glm::vec3(start.x + spacing, topLeftSample[1], start.y),
+                    glm::vec3(start.x + spacing, topLeftSample[samplesPerEdge + 1], start.y + spacing),
+                    glm::vec3(start.x, topLeftSample[samplesPerEdge], start.y + spacing),
+                };
+                if (visRq)
+                {
+                    pushRaycastVisCell(visRq, corners);
+                }
+
+                glm::vec3 *triangle = triangles[batch.count];
+                triangle[0] = corners[0];
+                triangle[1] = corners[1];
+                triangle[2] = corners[2];
+                rayTriangleBatchPush(&batch, triangle[0], triangle[1], triangle[2]);
+
+                triangle = triangles[batch.count];
+                triangle[0] = corners[0];
+                triangle[1] = corners[3];
+                triangle[2] = corners[2];
+                rayTriangleBatchPush(&batch, triangle[0], triangle[1], triangle[2]);
+            }
+        }
+
+        float hitDistances[RAY_TRIANGLE_BATCH_SIZE];
+        uint32 hitMask = intersectRayTriangleBatch(rayOrigin, rayDir, &batch, hitDistances);
+        if (hitMask)
+        {
+            float closestHitDist = FLT_MAX;
+            for (uint32 i = 0; i < batch.count; i++)
+            {
+                if ((hitMask & (1 << i)) && hitDistances[i] < closestHitDist)
+                {
+                    closestHitDist = hitDistances[i];
+                    outHit->triangle[0] = triangles[i][0];
+                    outHit->triangle[1] = triangles[i][1];
+                    outHit->triangle[2] = triangles[i][2];
+                }
+            }
+            outHit->distance = closestHitDist;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void heightfieldGetHeightRange(Heightfield *heightfield, float *outMinHeight, float *outMaxHeight)
+{
+    // the last level of the pyramid has a single cell covering the whole heightfield
+    HeightfieldPyramidLevel *root = &heightfield->levels[heightfield->levelCount - 1];
+    *outMinHeight = root->minHeights[0];
+    *outMaxHeight = root->maxHeights[0];
+}
+
+bool heightfieldGetHeightRangeInRect(
+    Heightfield *heightfield, rect2 rect, float *outMinHeight, float *outMaxHeight)
+{
+    /*
+     * The rect is in world units relative to the heightfield's minimum corner. Cells entirely
+     * inside the rect are used as is, only cells straddling its edges are descended into.
+     */
+    HeightfieldPyramidLevel *leaves = &heightfield->levels[0];
+    glm::vec2 minCell = glm::floor(getMin(rect) / heightfield->spacing);
+    glm::vec2 maxCell = glm::ceil(getMax(rect) / heightfield->spacing);
+    uint32 firstX = (uint32)glm::clamp(minCell.x, 0.0f, (float)leaves->cellsPerEdge);
+    uint32 firstY = (uint32)glm::clamp(minCell.y, 0.0f, (float)leaves->cellsPerEdge);
+    uint32 endX = (uint32)glm::clamp(maxCell.x, 0.0f, (float)leaves->cellsPerEdge);
+    uint32 endY = (uint32)glm::clamp(maxCell.y, 0.0f, (float)leaves->cellsPerEdge);
+    if (firstX >= endX || firstY >= endY)
+    {
+        return false;
+    }
+
+    struct StackEntry
+    {
+        uint32 level;
+        uint32 x;
+        uint32 y;
+    };
+    StackEntry stack[4 * HEIGHTFIELD_MAX_PYRAMID_LEVELS];
+    uint32 stackCount = 0;
+    stack[stackCount++] = {heightfield->levelCount - 1, 0, 0};
+
+    float minHeight = FLT_MAX;
+    float maxHeight = -FLT_MAX;
+    while (stackCount > 0)
+    {
+        StackEntry entry = stack[--stackCount];
+        HeightfieldPyramidLevel *level = &heightfield->levels[entry.level];
+
+        uint32 span = 1 << entry.level;
+        uint32 cellFirstX = entry.x * span;
+        uint32 cellFirstY = entry.y * span;
+        uint32 cellEndX = min(cellFirstX + span, leaves->cellsPerEdge);
+        uint32 cellEndY = min(cellFirstY + span, leaves->cellsPerEdge);
+        if (cellEndX <= firstX || cellFirstX >= endX || cellEndY <= firstY || cellFirstY >= endY)
+        {
+            continue;
+        }
+
+        if (entry.level == 0
+            || (cellFirstX >= firstX && cellEndX <= endX && cellFirstY >= firstY && cellEndY <= endY))
+        {
+            uint32 cellIndex = (entry.y * level->cellsPerEdge) + entry.x;
+            minHeight = fminf(minHeight, level->minHeights[cellIndex]);
+            maxHeight = fmaxf(maxHeight, level->maxHeights[cellIndex]);
+            continue;
+        }
+
+        HeightfieldPyramidLevel *childLevel = &heightfield->levels[entry.level - 1];
+        for (uint32 i = 0; i < 4; i++)
+        {
+            uint32 childX = (entry.x * 2) + (i & 1);
+            uint32 childY = (entry.y * 2) + (i >> 1);
+            if (childX < childLevel->cellsPerEdge && childY < childLevel->cellsPerEdge)
+            {
+                assert(stackCount < arrayCount(stack));
+                stack[stackCount++] = {entry.level - 1, childX, childY};
+            }
+        }
+    }
+
+    *outMinHeight = minHeight;
+    *outMaxHeight = maxHeight;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef SIERRA_HEIGHTFIELD_H
+#define SIERRA_HEIGHTFIELD_H
+
+/*
+ * CPU heightfields are grids of world-space heights sampled from a tile's heightmap, used for
+ * raycasting against the terrain. The samples cover the tile's extent (excluding the overlapping
+ * borders of the heightmap) and can be as dense as one sample per heightmap texel.
+ */
+
+// enough levels for one sample per texel of a 2048x2048 heightmap
+#define HEIGHTFIELD_MAX_PYRAMID_LEVELS 12
+
+struct HeightfieldPyramidLevel
+{
+    uint32 cellsPerEdge;
+    float *minHeights;
+    float *maxHeights;
+};
+
+struct Heightfield
+{
+    uint32 samplesPerEdge;
+    float spacing;
+    float *heights;
+
+    /*
+     * Every row and column of samples is at the same position along its axis, so each sample is
+     * interpolated between texel sampleTexels[i] and the texel after it by sampleLerps[i].
+     */
+    uint32 *sampleTexels;
+    float *sampleLerps;
+
+    /*
+     * Min/max pyramid over the cells between samples. Each cell of level 0 is bounded by the four
+     * samples at its corners and each cell of the levels above covers up to 2x2 cells of the level
+     * below, so the last level has a single cell covering the whole heightfield.
+     */
+    HeightfieldPyramidLevel levels[HEIGHTFIELD_MAX_PYRAMID_LEVELS];
+    uint32 levelCount;
+};
+
+struct HeightfieldRaycastHit
+{
+    // distance along the ray in multiples of the ray direction's length
+    float distance;
+    glm::vec3 triangle[3];
+};
+
+#endif
\ No newline at end of file
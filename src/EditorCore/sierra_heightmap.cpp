@@ -1,60 +1,422 @@
 #include "sierra_heightmap.h"
 
+// the dirty regions computed by brushUpdateTileRegions only account for a single blur pass
 #define SMOOTH_EFFECT_ITERATIONS 1
 
-void drawFullSizeQuadToTarget(RenderContext *rctx, MemoryArena *arena, RenderEffect *effect, RenderTarget *target)
+/*
+ * Additive brush strength is the influence accumulated per brush radius travelled along the stroke.
+ * The scale was chosen to match the feel of the previous stamp-based brush at the default brush
+ * size. Dabs apply the influence of BRUSH_DAB_LENGTH world units of stroke.
+ */
+#define BRUSH_STROKE_STRENGTH_SCALE 0.9568f
+#define BRUSH_DAB_LENGTH 0.64f
+
+void brushStrokeInitialize(BrushStroke *stroke, MemoryArena *arena, float startingHeight)
+{
+    *stroke = {};
+    stroke->arena = arena;
+    stroke->startingHeight = startingHeight;
+}
+void brushStrokeRetireChunks(BrushStroke *stroke)
+{
+    if (stroke->lastChunk)
+    {
+        stroke->lastChunk->next = stroke->firstFreeChunk;
+        stroke->firstFreeChunk = stroke->firstChunk;
+        stroke->firstChunk = 0;
+        stroke->lastChunk = 0;
+    }
+}
+void brushStrokeReset(BrushStroke *stroke)
 {
+    brushStrokeRetireChunks(stroke);
+    stroke->vertexCount = 0;
+    stroke->renderedVertexCount = 0;
+}
+void brushStrokeAddVertex(BrushStroke *stroke, glm::vec2 vertex)
+{
+    BrushStrokeChunk *chunk = stroke->lastChunk;
+    if (!chunk || chunk->vertexCount == BRUSH_STROKE_CHUNK_VERTEX_COUNT)
+    {
+        chunk = stroke->firstFreeChunk;
+        if (chunk)
+        {
+            stroke->firstFreeChunk = chunk->next;
+        }
+        else
+        {
+            chunk = pushStruct(stroke->arena, BrushStrokeChunk);
+        }
+        chunk->vertexCount = 0;
+        chunk->next = 0;
+
+        if (stroke->lastChunk)
+        {
+            stroke->lastChunk->next = chunk;
+        }
+        else
+        {
+            stroke->firstChunk = chunk;
+        }
+        stroke->lastChunk = chunk;
+    }
+
+    chunk->vertices[chunk->vertexCount++] = vertex;
+    stroke->vertexCount++;
+    stroke->lastVertex = vertex;
+}
+
+void drawFullSizeQuadToTarget(
+    RenderContext *rctx, MemoryArena *arena, RenderEffect *effect, RenderTarget *target, rect2 clipRect)
+{
+    if (isRectEmpty(clipRect))
+    {
+        return;
+    }
+
     RenderQueue *rq = rendererCreateQueue(rctx, arena, getRenderOutput(target));
     rendererSetCameraOrtho(rq);
+    rendererSetClipRect(rq, clipRect);
     rendererClear(rq, 0, 0, 0, 1);
     rendererPushQuad(rq, getBounds(target), effect);
     rendererDraw(rq);
 }
-void blitToTarget(RenderContext *rctx,
+void uploadHeightmapRegion(RenderTarget *target, uint16 *pixels, rect2 region)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    uint32 x = (uint32)region.x;
+    uint32 y = (uint32)region.y;
+    rendererUpdateTextureRegion(target->textureHandle, x, y, (uint32)region.width, (uint32)region.height,
+        target->width, &pixels[(y * target->width) + x]);
+}
+void applyOldestHeightmapReadback(SceneState *sceneState, HeightmapReadbackRing *ring)
+{
+    assert(ring->entryCount > 0);
+    HeightmapReadback *readback = &ring->entries[ring->firstEntry];
+    TerrainTile *tile = &sceneState->terrainTiles[readback->tileIndex];
+
+    uint32 x = (uint32)readback->region.x;
+    uint32 y = (uint32)readback->region.y;
+    uint32 width = (uint32)readback->region.width;
+    uint32 height = (uint32)readback->region.height;
+    GetPixelsResult result = rendererBeginReadPixels(&readback->request);
+    assert(result.count == width * height);
+
+    uint16 *src = (uint16 *)result.pixels;
+    uint16 *dst = tile->brushBuffers.workingHeightmap;
+    for (uint32 row = 0; row < height; row++)
+    {
+        memcpy(&dst[((y + row) * HEIGHTMAP_DIM) + x], &src[row * width], width * sizeof(uint16));
+    }
+    rendererEndReadPixels(&readback->request);
+    tile->heightfieldDirtyRect = rectUnion(tile->heightfieldDirtyRect, readback->region);
+
+    ring->firstEntry = (ring->firstEntry + 1) % HEIGHTMAP_READBACK_RING_SIZE;
+    ring->entryCount--;
+}
+void updateHeightmapReadbackStats(HeightmapReadbackRing *ring)
+{
+    HeightmapReadbackStats *stats = &ring->stats;
+    stats->pendingCount = ring->entryCount;
+    stats->framesBehind = 0;
+    if (ring->entryCount > 0)
+    {
+        stats->framesBehind = (uint32)(ring->currentFrame - ring->entries[ring->firstEntry].frameQueued);
+    }
+    stats->maxFramesBehind = max(stats->maxFramesBehind, stats->framesBehind);
+}
+void queueHeightmapReadback(EditorState *state, uint32 tileIndex, rect2 region)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    HeightmapReadbackRing *ring = &state->heightmapReadbacks;
+    if (ring->entryCount == HEIGHTMAP_READBACK_RING_SIZE)
+    {
+        TIMED_BLOCK("Wait For Heightmap Readback");
+
+        ring->stats.blockingCount++;
+        applyOldestHeightmapReadback(&state->sceneState, ring);
+    }
+
+    uint32 entryIndex = (ring->firstEntry + ring->entryCount) % HEIGHTMAP_READBACK_RING_SIZE;
+    HeightmapReadback *readback = &ring->entries[entryIndex];
+    readback->request = rendererQueueGetPixelsInRegion(state->renderCtx,
+        state->sceneState.terrainTiles[tileIndex].workingHeightmap->textureHandle, (uint32)region.x,
+        (uint32)region.y, (uint32)region.width, (uint32)region.height);
+    readback->tileIndex = tileIndex;
+    readback->region = region;
+    readback->frameQueued = ring->currentFrame;
+    ring->entryCount++;
+
+    updateHeightmapReadbackStats(ring);
+}
+bool applyHeightmapReadbacks(EditorState *state, bool waitForAll)
+{
+    TIMED_BLOCK("Apply Heightmap Readbacks");
+
+    /*
+     * Readbacks that the GPU hasn't finished are left for a later frame instead of stalling on
+     * them, unless the CPU copies of the working heightmaps need to be up to date right now.
+     */
+    HeightmapReadbackRing *ring = &state->heightmapReadbacks;
+    bool wasAnyApplied = false;
+    while (ring->entryCount > 0)
+    {
+        if (!rendererIsReadPixelsComplete(&ring->entries[ring->firstEntry].request))
+        {
+            if (!waitForAll)
+            {
+                break;
+            }
+            ring->stats.blockingCount++;
+        }
+
+        applyOldestHeightmapReadback(&state->sceneState, ring);
+        wasAnyApplied = true;
+    }
+
+    updateHeightmapReadbackStats(ring);
+    return wasAnyApplied;
+}
+void pushSeamCopies(TileSeamCopy *copies,
+    uint32 *copyCount,
+    SceneState *sceneState,
+    TerrainTile *tile,
+    TerrainTile *neighbour,
+    rect2 tileRect,
+    rect2 neighbourRect,
+    glm::vec2 tileToNeighbourOffset)
+{
+    uint32 tileIndex = (uint32)(tile - sceneState->terrainTiles);
+    uint32 neighbourIndex = (uint32)(neighbour - sceneState->terrainTiles);
+
+    TileSeamCopy *copy = &copies[(*copyCount)++];
+    copy->srcTileIndex = tileIndex;
+    copy->dstTileIndex = neighbourIndex;
+    copy->srcRect = tileRect;
+    copy->dstOffset = tileToNeighbourOffset;
+
+    copy = &copies[(*copyCount)++];
+    copy->srcTileIndex = neighbourIndex;
+    copy->dstTileIndex = tileIndex;
+    copy->srcRect = neighbourRect;
+    copy->dstOffset = -tileToNeighbourOffset;
+}
+uint32 getSeamCopies(SceneState *sceneState, TileSeamCopy *copies)
+{
+    // w is the full width of a tile, o is the width of the overlap and e is the width excluding overlap
+    float w = HEIGHTMAP_DIM;
+    float o = HEIGHTMAP_OVERLAP_IN_TEXELS;
+    float e = w - (2 * o);
+
+    uint32 copyCount = 0;
+    for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
+    {
+        TerrainTile *tile = &sceneState->terrainTiles[i];
+        TerrainTile *tileToRight = tile->tileToRight;
+        TerrainTile *tileBelow = tile->tileBelow;
+
+        if (tileToRight)
+        {
+            pushSeamCopies(copies, &copyCount, sceneState, tile, tileToRight, rectMinDim(e, o, o, e),
+                rectMinDim(o, o, o, e), glm::vec2(-e, 0));
+        }
+        if (tileBelow)
+        {
+            pushSeamCopies(copies, &copyCount, sceneState, tile, tileBelow, rectMinDim(o, e, e, o),
+                rectMinDim(o, o, e, o), glm::vec2(0, -e));
+
+            TerrainTile *tileBelowToLeft = tileBelow->tileToLeft;
+            if (tileBelowToLeft)
+            {
+                pushSeamCopies(copies, &copyCount, sceneState, tile, tileBelowToLeft, rectMinDim(o, e, o, o),
+                    rectMinDim(e, o, o, o), glm::vec2(e, -e));
+            }
+
+            TerrainTile *tileBelowToRight = tileBelow->tileToRight;
+            if (tileBelowToRight)
+            {
+                pushSeamCopies(copies, &copyCount, sceneState, tile, tileBelowToRight, rectMinDim(e, e, o, o),
+                    rectMinDim(o, o, o, o), glm::vec2(-e, -e));
+            }
+        }
+    }
+    assert(copyCount <= sceneState->terrainTileCount * MAX_SEAM_COPIES_PER_TILE);
+
+    return copyCount;
+}
+
+rect2 getSeamCopyDstRect(TileSeamCopy *copy, rect2 srcRect)
+{
+    return rectMinDim(getMin(srcRect) + copy->dstOffset, glm::vec2(srcRect.width, srcRect.height));
+}
+void drawSeamCopies(RenderContext *rctx,
     MemoryArena *arena,
-    TextureHandle srcTexture,
-    rect2 srcUvRect,
-    RenderTarget *target,
-    rect2 dstQuad)
+    SceneState *sceneState,
+    TileSeamCopy *copies,
+    uint32 copyCount,
+    uint32 dstTileIndex,
+    bool isPreview)
 {
-    RenderQueue *rq = rendererCreateQueue(rctx, arena, getRenderOutput(target));
-    rendererSetCameraOrtho(rq);
-    rendererPushTexturedQuadRegion(rq, dstQuad, srcTexture, true, srcUvRect);
-    rendererDraw(rq);
+    // all copies into the same render target are batched into a single render queue
+    RenderQueue *rq = 0;
+    for (uint32 i = 0; i < copyCount; i++)
+    {
+        TileSeamCopy *copy = &copies[i];
+        rect2 srcRect = isPreview ? copy->previewRect : copy->workingRect;
+        if (copy->dstTileIndex != dstTileIndex || isRectEmpty(srcRect))
+        {
+            continue;
+        }
+
+        if (!rq)
+        {
+            TerrainTile *dstTile = &sceneState->terrainTiles[dstTileIndex];
+            RenderTarget *target = isPreview ? dstTile->previewHeightmap : dstTile->workingHeightmap;
+            rq = rendererCreateQueue(rctx, arena, getRenderOutput(target));
+            rendererSetCameraOrtho(rq);
+        }
+
+        TerrainTile *srcTile = &sceneState->terrainTiles[copy->srcTileIndex];
+        RenderTarget *source = isPreview ? srcTile->previewHeightmap : srcTile->workingHeightmap;
+        float texelToUvSpace = 1.0f / HEIGHTMAP_DIM;
+        rect2 srcUvRect = rectMinDim(getMin(srcRect) * texelToUvSpace,
+            glm::vec2(srcRect.width, srcRect.height) * texelToUvSpace);
+        rendererPushTexturedQuadRegion(
+            rq, getSeamCopyDstRect(copy, srcRect), source->textureHandle, true, srcUvRect);
+    }
+    if (rq)
+    {
+        rendererDraw(rq);
+    }
 }
-void blitTileRegion(RenderContext *rctx,
+
+void resolveTileSeams(EditorState *state,
     MemoryArena *arena,
-    TerrainTile *srcTile,
-    rect2 srcUvRect,
-    TerrainTile *dstTile,
-    rect2 dstQuad)
+    bool isCompositedOnCpu,
+    rect2 *workingChangedRects,
+    rect2 *previewChangedRects)
 {
-    blitToTarget(
-        rctx, arena, srcTile->previewHeightmap->textureHandle, srcUvRect, dstTile->previewHeightmap, dstQuad);
-    blitToTarget(
-        rctx, arena, srcTile->workingHeightmap->textureHandle, srcUvRect, dstTile->workingHeightmap, dstQuad);
+    TIMED_BLOCK("Resolve Tile Seams");
+
+    SceneState *sceneState = &state->sceneState;
+    TemporaryMemory seamMemory = beginTemporaryMemory(arena);
+
+    /*
+     * Each tile's border overlaps the neighbouring tiles, but brushes that read neighbouring texels
+     * can't see past the edge of the tile, so the borders are overwritten with the texels from the
+     * tile they overlap. Only the parts of each border that changed this frame need to be copied.
+     */
+    TileSeamCopy *copies =
+        pushArray(arena, TileSeamCopy, sceneState->terrainTileCount * MAX_SEAM_COPIES_PER_TILE);
+    uint32 copyCount = getSeamCopies(sceneState, copies);
+    for (uint32 i = 0; i < copyCount; i++)
+    {
+        TileSeamCopy *copy = &copies[i];
+        copy->workingRect = rectIntersection(copy->srcRect, workingChangedRects[copy->srcTileIndex]);
+        copy->previewRect = rectIntersection(copy->srcRect, previewChangedRects[copy->srcTileIndex]);
+    }
+
+    for (uint32 i = 0; i < copyCount; i++)
+    {
+        TileSeamCopy *copy = &copies[i];
+        TerrainTile *dstTile = &sceneState->terrainTiles[copy->dstTileIndex];
+        rect2 workingDstRect = getSeamCopyDstRect(copy, copy->workingRect);
+        rect2 previewDstRect = getSeamCopyDstRect(copy, copy->previewRect);
+
+#if FEATURE_CPU_SMOOTH_BRUSH
+        if (isCompositedOnCpu)
+        {
+            BrushTileBuffers *src = &sceneState->terrainTiles[copy->srcTileIndex].brushBuffers;
+            BrushTileBuffers *dst = &dstTile->brushBuffers;
+            brushCopyRegion(dst->workingHeightmap, src->workingHeightmap, HEIGHTMAP_DIM, copy->workingRect,
+                (uint32)workingDstRect.x, (uint32)workingDstRect.y);
+            brushCopyRegion(dst->previewHeightmap, src->previewHeightmap, HEIGHTMAP_DIM, copy->previewRect,
+                (uint32)previewDstRect.x, (uint32)previewDstRect.y);
+        }
+#endif
+
+        uint32 dstIndex = copy->dstTileIndex;
+        workingChangedRects[dstIndex] = rectUnion(workingChangedRects[dstIndex], workingDstRect);
+        previewChangedRects[dstIndex] = rectUnion(previewChangedRects[dstIndex], previewDstRect);
+
+        BrushTileState *dstState = &dstTile->brushState;
+        dstState->uncommittedRect = rectUnion(dstState->uncommittedRect, workingDstRect);
+    }
+
+    if (!isCompositedOnCpu)
+    {
+        for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
+        {
+            drawSeamCopies(state->renderCtx, arena, sceneState, copies, copyCount, i, false);
+            drawSeamCopies(state->renderCtx, arena, sceneState, copies, copyCount, i, true);
+        }
+    }
+
+    endTemporaryMemory(&seamMemory);
+}
+
+RenderEffect *createInfluenceMaskEffect(MemoryArena *arena,
+    EditorAssets *assets,
+    BrushSegment *segment,
+    rect2 quad,
+    BrushParameters *brushParams)
+{
+    RenderEffectBlendMode blendMode =
+        brushParams->maskBlendMode == BRUSH_MASK_BLEND_MAX ? EFFECT_BLEND_MAX : EFFECT_BLEND_ADDITIVE;
+    bool isIntegrated = !segment->isDab && brushParams->maskBlendMode == BRUSH_MASK_BLEND_ADDITIVE;
+    float strength = segment->isDab ? brushParams->dabStrength : brushParams->strength;
+
+    // the shader works in units of the brush radius, relative to the quad
+    float invRadius = 1.0f / brushParams->radius;
+    glm::vec2 quadMin = getMin(quad);
+
+    RenderEffect *effect = rendererCreateEffect(arena, assets->quadShaderBrushMask, blendMode);
+    rendererSetEffectVec2(effect, "segmentStart", (segment->start - quadMin) * invRadius);
+    rendererSetEffectVec2(effect, "segmentEnd", (segment->end - quadMin) * invRadius);
+    rendererSetEffectVec2(effect, "quadSize", glm::vec2(quad.width, quad.height) * invRadius);
+    rendererSetEffectFloat(effect, "brushFalloff", brushParams->falloff);
+    rendererSetEffectFloat(effect, "brushStrength", strength);
+    rendererSetEffectInt(effect, "isIntegrated", isIntegrated ? 1 : 0);
+    return effect;
 }
 
 void drawInfluenceMask(RenderContext *rctx,
     MemoryArena *arena,
-    TextureHandle baseTexture,
+    rect2 clearRect,
     rect2 *quads,
+    RenderEffect **effects,
     uint32 quadCount,
     glm::vec2 offset,
-    RenderEffect *effect,
     RenderTarget *target)
 {
+    bool hasQuads = quadCount > 0;
+    if (isRectEmpty(clearRect) && !hasQuads)
+    {
+        return;
+    }
+
     RenderQueue *rq = rendererCreateQueue(rctx, arena, getRenderOutput(target));
-    rendererClear(rq, 0, 0, 0, 1);
-    if (baseTexture.ptr)
+    if (!isRectEmpty(clearRect))
     {
-        rendererSetCameraOrtho(rq);
-        rendererPushTexturedQuad(rq, getBounds(target), baseTexture, true);
+        rendererSetClipRect(rq, clearRect);
+        rendererClear(rq, 0, 0, 0, 1);
+        rendererClearClipRect(rq);
     }
-    if (quads)
+    if (hasQuads)
     {
         rendererSetCameraOrthoOffset(rq, offset);
-        rendererPushQuads(rq, quads, quadCount, effect);
+        for (uint32 i = 0; i < quadCount; i++)
+        {
+            rendererPushQuad(rq, quads[i], effects[i]);
+        }
     }
     rendererDraw(rq);
 }
@@ -109,23 +471,142 @@ void applySmoothEffectToTarget(MemoryArena *arena,
     RenderTarget *inputTarget,
     RenderTarget *maskTarget,
     RenderTarget *tempTarget,
-    RenderTarget *outputTarget)
+    RenderTarget *outputTarget,
+    rect2 outputRect)
 {
+    rect2 horizontalPassRect = brushGetSmoothHorizontalPassRect(outputRect, HEIGHTMAP_DIM);
+
     RenderTarget *iterationInputTarget = inputTarget;
     for (uint32 i = 0; i < SMOOTH_EFFECT_ITERATIONS; i++)
     {
         RenderEffect *horizontalEffect = createSmoothEffect(
             arena, assets, iterationInputTarget->textureHandle, maskTarget->textureHandle, i, glm::vec2(1, 0));
-        drawFullSizeQuadToTarget(rctx, arena, horizontalEffect, tempTarget);
+        drawFullSizeQuadToTarget(rctx, arena, horizontalEffect, tempTarget, horizontalPassRect);
 
         RenderEffect *verticalEffect = createSmoothEffect(
             arena, assets, tempTarget->textureHandle, maskTarget->textureHandle, i, glm::vec2(0, 1));
-        drawFullSizeQuadToTarget(rctx, arena, verticalEffect, outputTarget);
+        drawFullSizeQuadToTarget(rctx, arena, verticalEffect, outputTarget, outputRect);
 
         iterationInputTarget = outputTarget;
     }
 }
 
+#if DEBUG_VERIFY_CPU_BRUSH
+void compareHeightmapRegion(
+    EditorState *state, MemoryArena *arena, RenderTarget *target, uint16 *pixels, rect2 region)
+{
+    if (isRectEmpty(region))
+    {
+        return;
+    }
+
+    TemporaryMemory compareMemory = beginTemporaryMemory(arena);
+
+    uint32 x = (uint32)region.x;
+    uint32 y = (uint32)region.y;
+    uint32 width = (uint32)region.width;
+    uint32 height = (uint32)region.height;
+    GetPixelsResult result = rendererGetPixelsInRegion(arena, target->textureHandle, x, y, width, height);
+    assert(result.count == width * height);
+
+    BrushVerificationStats *stats = &state->brushVerificationStats;
+    uint64 previousMismatchCount = stats->mismatchCount;
+    uint16 *gpuPixels = (uint16 *)result.pixels;
+    for (uint32 row = 0; row < height; row++)
+    {
+        uint16 *cpuRow = &pixels[((y + row) * target->width) + x];
+        uint16 *gpuRow = &gpuPixels[row * width];
+        for (uint32 i = 0; i < width; i++)
+        {
+            uint32 difference = cpuRow[i] > gpuRow[i] ? cpuRow[i] - gpuRow[i] : gpuRow[i] - cpuRow[i];
+            if (difference > 0)
+            {
+                stats->mismatchCount++;
+                stats->maxDifference = max(stats->maxDifference, difference);
+            }
+        }
+    }
+    stats->comparedCount += width * height;
+    if (stats->mismatchCount != previousMismatchCount)
+    {
+        Platform.logMessage("The CPU brush engine's output doesn't match the brush shaders");
+    }
+
+    endTemporaryMemory(&compareMemory);
+}
+
+/*
+ * Composites a tile's changed regions with the CPU brush engine after the brush shaders have rendered
+ * them, and compares the two. Reading the render targets back stalls until the GPU has caught up, so
+ * this is only done when debugging the CPU engine.
+ */
+void verifyCpuBrushComposite(EditorState *state,
+    MemoryArena *arena,
+    TerrainTile *tile,
+    BrushTileUpdate *update,
+    BrushParameters *params,
+    BrushSegment *segments,
+    uint32 segmentCount,
+    BrushSegment *previewSegment,
+    glm::vec2 offset)
+{
+    TIMED_BLOCK("Verify CPU Brush");
+
+    BrushTileBuffers *buffers = &tile->brushBuffers;
+    brushCompositeTileRegions(arena, buffers, update, params, segments, segmentCount, previewSegment, offset);
+    compareHeightmapRegion(
+        state, arena, tile->workingHeightmap, buffers->workingHeightmap, update->workingHeightmapRect);
+    compareHeightmapRegion(
+        state, arena, tile->previewHeightmap, buffers->previewHeightmap, update->previewHeightmapRect);
+}
+#endif
+
+BrushParameters getBrushParameters(EditorUiState *uiState, float startingHeight, float worldToHeightmapSpace)
+{
+    // the brush 'radius' in the UI is actually the width of the brush
+    float radiusInWorldUnits = uiState->terrainBrushRadius * 0.5f;
+
+    BrushParameters result = {};
+    result.blendOperation = BRUSH_BLEND_ADD_SUB;
+    result.blendSign = 1;
+    result.flattenHeight = startingHeight;
+    result.maskBlendMode = BRUSH_MASK_BLEND_MAX;
+    result.smoothRadius = (uint32)((uiState->terrainBrushSmoothRadius * worldToHeightmapSpace) + 0.5f);
+    result.radius = radiusInWorldUnits * worldToHeightmapSpace;
+    result.falloff = uiState->terrainBrushFalloff;
+    result.strength = 1;
+    result.dabStrength = 1;
+
+    TerrainBrushTool tool = uiState->terrainBrushTool;
+    if (tool != TERRAIN_BRUSH_TOOL_FLATTEN)
+    {
+        result.strength = BRUSH_STROKE_STRENGTH_SCALE * (0.01f + (0.01875f * uiState->terrainBrushStrength));
+        result.dabStrength = result.strength * (BRUSH_DAB_LENGTH / radiusInWorldUnits);
+        result.maskBlendMode = BRUSH_MASK_BLEND_ADDITIVE;
+    }
+
+    switch (tool)
+    {
+    case TERRAIN_BRUSH_TOOL_LOWER:
+        result.blendSign = -1;
+        break;
+    case TERRAIN_BRUSH_TOOL_FLATTEN:
+        result.blendOperation = BRUSH_BLEND_FLATTEN;
+        break;
+    case TERRAIN_BRUSH_TOOL_SMOOTH:
+#if FEATURE_CPU_SMOOTH_BRUSH
+        result.blendOperation = BRUSH_BLEND_SMOOTH_BOX;
+#else
+        result.blendOperation = BRUSH_BLEND_SMOOTH;
+#endif
+        result.strength *= 4;
+        result.dabStrength *= 4;
+        break;
+    }
+
+    return result;
+}
+
 void compositeHeightmaps(EditorMemory *memory, BrushStroke *activeBrushStroke, glm::vec2 *brushCursorPos)
 {
     TIMED_BLOCK("Composite Heightmaps");
@@ -133,78 +614,156 @@ void compositeHeightmaps(EditorMemory *memory, BrushStroke *activeBrushStroke, g
     EditorState *state = (EditorState *)memory->arena.baseAddress;
     SceneState *sceneState = &state->sceneState;
 
-    // update brush quad instances
     float heightmapDimWithoutOverlap = HEIGHTMAP_DIM - (2 * HEIGHTMAP_OVERLAP_IN_TEXELS);
     float worldToHeightmapSpace = heightmapDimWithoutOverlap / TERRAIN_TILE_LENGTH_IN_WORLD_UNITS;
     float extendedTileDim = TERRAIN_TILE_LENGTH_IN_WORLD_UNITS * (HEIGHTMAP_DIM / heightmapDimWithoutOverlap);
-    float brushStrokeQuadDim = state->uiState.terrainBrushRadius * worldToHeightmapSpace;
-    uint32 instancesToRender = activeBrushStroke->totalInstanceCount - activeBrushStroke->renderedInstanceCount;
-    rect2 *activeBrushStrokeQuads = pushArray(&memory->arena, rect2, instancesToRender);
-    glm::vec2 *instancePos = &activeBrushStroke->positions[activeBrushStroke->renderedInstanceCount];
-    for (uint32 i = 0; i < instancesToRender; i++)
+    BrushParameters brushParams =
+        getBrushParameters(&state->uiState, activeBrushStroke->startingHeight, worldToHeightmapSpace);
+    TerrainBrushTool tool = state->uiState.terrainBrushTool;
+    bool isNewStroke = activeBrushStroke->renderedVertexCount == 0;
+
+    TemporaryMemory renderMemory = beginTemporaryMemory(&memory->arena);
+
+    // each stroke vertex that hasn't been rendered yet adds a segment ending at that vertex
+    uint32 segmentCount = activeBrushStroke->vertexCount - activeBrushStroke->renderedVertexCount;
+    BrushSegment *segments = pushArray(&memory->arena, BrushSegment, segmentCount);
+    BrushSegment *segment = segments;
+    bool isFirstVertex = activeBrushStroke->renderedVertexCount == 0;
+    glm::vec2 prevVertex = activeBrushStroke->lastRenderedVertex * worldToHeightmapSpace;
+    for (BrushStrokeChunk *chunk = activeBrushStroke->firstChunk; chunk; chunk = chunk->next)
     {
-        glm::vec2 posHeightmapSpace = *instancePos++ * worldToHeightmapSpace;
-        activeBrushStrokeQuads[i] = rectCenterDim(posHeightmapSpace, brushStrokeQuadDim);
+        for (uint32 i = 0; i < chunk->vertexCount; i++)
+        {
+            glm::vec2 vertex = chunk->vertices[i] * worldToHeightmapSpace;
+            segment->start = isFirstVertex ? vertex : prevVertex;
+            segment->end = vertex;
+            segment->isDab = isFirstVertex;
+            segment++;
+
+            isFirstVertex = false;
+            prevVertex = vertex;
+        }
     }
-    rect2 previewBrushStrokeQuad;
-    rect2 *previewBrushStrokeQuadPtr = 0;
+    assert(segment == segments + segmentCount);
+    BrushSegment previewSegment;
+    BrushSegment *previewSegmentPtr = 0;
     if (brushCursorPos)
     {
-        glm::vec2 brushCursorPosInHeightmapSpace = *brushCursorPos * worldToHeightmapSpace;
-        previewBrushStrokeQuad = rectCenterDim(brushCursorPosInHeightmapSpace, brushStrokeQuadDim);
-        previewBrushStrokeQuadPtr = &previewBrushStrokeQuad;
+        previewSegment.start = *brushCursorPos * worldToHeightmapSpace;
+        previewSegment.end = previewSegment.start;
+        previewSegment.isDab = true;
+        previewSegmentPtr = &previewSegment;
     }
 
-    // set up influence mask effect
-    float brushFalloff = state->uiState.terrainBrushFalloff;
-    float brushStrength = 1;
-    RenderEffectBlendMode maskBlendMode = EFFECT_BLEND_MAX;
-    TerrainBrushTool tool = state->uiState.terrainBrushTool;
-    if (tool != TERRAIN_BRUSH_TOOL_FLATTEN)
+    // set up influence mask effects
+    rect2 *segmentQuads = pushArray(&memory->arena, rect2, segmentCount);
+    RenderEffect **segmentEffects = pushArray(&memory->arena, RenderEffect *, segmentCount);
+    for (uint32 i = 0; i < segmentCount; i++)
     {
-        /*
-         * Because the spacing between brush instances is constant, higher radius brushes will
-         * result in more brush instances being drawn, meaning the terrain will be influenced
-         * more. As a result, we should decrease the brush strength as the brush radius
-         * increases to ensure the perceived brush strength remains constant.
-         */
-        brushStrength = 0.01f + (0.01875f * state->uiState.terrainBrushStrength);
-        brushStrength /= 4.0f * pow(state->uiState.terrainBrushRadius, 0.5f);
-        maskBlendMode = EFFECT_BLEND_ADDITIVE;
+        segmentQuads[i] = brushGetSegmentQuad(&segments[i], brushParams.radius);
+        segmentEffects[i] = createInfluenceMaskEffect(
+            &memory->arena, &state->editorAssets, &segments[i], segmentQuads[i], &brushParams);
     }
-    if (tool == TERRAIN_BRUSH_TOOL_SMOOTH)
+    rect2 previewQuad = {};
+    RenderEffect *previewEffect = 0;
+    uint32 previewQuadCount = 0;
+    if (previewSegmentPtr)
     {
-        brushStrength *= 4;
+        previewQuad = brushGetSegmentQuad(previewSegmentPtr, brushParams.radius);
+        previewEffect = createInfluenceMaskEffect(
+            &memory->arena, &state->editorAssets, previewSegmentPtr, previewQuad, &brushParams);
+        previewQuadCount = 1;
     }
 
-    TemporaryMemory renderMemory = beginTemporaryMemory(&memory->arena);
-
-    RenderEffect *influenceMaskEffect =
-        rendererCreateEffect(&memory->arena, state->editorAssets.quadShaderBrushMask, maskBlendMode);
-    rendererSetEffectFloat(influenceMaskEffect, "brushFalloff", brushFalloff);
-    rendererSetEffectFloat(influenceMaskEffect, "brushStrength", brushStrength);
-
+    rect2 strokeBounds = brushGetStrokeBounds(segments, segmentCount, previewSegmentPtr, brushParams.radius);
+    bool isCompositedOnCpu = brushParams.blendOperation == BRUSH_BLEND_SMOOTH_BOX;
+    if (isCompositedOnCpu && !sceneState->terrainTiles[0].isBrushCompositedOnCpu
+        && (!isNewStroke || state->heightmapReadbacks.entryCount > 0))
+    {
+        /*
+         * The CPU buffers are about to become the source of truth, so switching to them has to wait
+         * until stale readbacks can no longer overwrite them. Rather than stalling on the GPU, the
+         * shaders' smooth is used until the readbacks have been applied. Switching mid-stroke would
+         * lose the stroke so far, so a stroke started on the GPU also stays there.
+         */
+        brushParams.blendOperation = BRUSH_BLEND_SMOOTH;
+        isCompositedOnCpu = false;
+    }
+#if DEBUG_VERIFY_CPU_BRUSH
+    // the CPU engine composites the preview on top of the CPU copy of the working heightmap
+    applyHeightmapReadbacks(state, true);
+#endif
+    rect2 *workingChangedRects = pushArray(&memory->arena, rect2, sceneState->terrainTileCount);
+    rect2 *previewChangedRects = pushArray(&memory->arena, rect2, sceneState->terrainTileCount);
+    memset(workingChangedRects, 0, sceneState->terrainTileCount * sizeof(rect2));
+    memset(previewChangedRects, 0, sceneState->terrainTileCount * sizeof(rect2));
+#if FEATURE_CPU_SMOOTH_BRUSH
+    BrushTileUpdate *cpuTileUpdates = pushArray(&memory->arena, BrushTileUpdate, sceneState->terrainTileCount);
+    bool *isCpuTileComposited = pushArray(&memory->arena, bool, sceneState->terrainTileCount);
+    memset(isCpuTileComposited, 0, sceneState->terrainTileCount * sizeof(bool));
+#endif
     for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
     {
         TerrainTile *tile = &sceneState->terrainTiles[i];
         glm::vec2 minCornerWorldSpace = tile->center - (extendedTileDim * 0.5f);
         glm::vec2 offset = minCornerWorldSpace * worldToHeightmapSpace;
 
+        /*
+         * The CPU buffers and the render targets aren't kept in sync, so when a tile switches between
+         * them the masks need to be erased and the heightmaps redrawn in full.
+         */
+        bool isTileNewStroke = isNewStroke;
+        if (tile->isBrushCompositedOnCpu != isCompositedOnCpu)
+        {
+            rect2 heightmapBounds = rectMinDim(0, 0, HEIGHTMAP_DIM, HEIGHTMAP_DIM);
+            tile->brushState.workingMaskRect = heightmapBounds;
+            tile->brushState.previewMaskRect = heightmapBounds;
+            tile->isBrushCompositedOnCpu = isCompositedOnCpu;
+            isTileNewStroke = true;
+        }
+
+        // skip tiles that are too far away from the stroke to be influenced by it
+        rect2 tileBounds = rectMinDim(offset, HEIGHTMAP_DIM);
+        if (!brushIsTileAffected(&tile->brushState, isTileNewStroke, strokeBounds, tileBounds))
+        {
+            continue;
+        }
+
+        /*
+         * Only redraw the regions of each render target that have changed since the last
+         * composite. The influence masks are accumulated in place instead of being redrawn.
+         */
+        BrushTileUpdate update = brushUpdateTileRegions(&tile->brushState, HEIGHTMAP_DIM, &brushParams,
+            isTileNewStroke, segments, segmentCount, previewSegmentPtr, offset);
+        rect2 workingRect = update.workingHeightmapRect;
+        rect2 previewRect = update.previewHeightmapRect;
+        workingChangedRects[i] = workingRect;
+        previewChangedRects[i] = previewRect;
+
+#if FEATURE_CPU_SMOOTH_BRUSH
+        if (isCompositedOnCpu)
+        {
+            TIMED_BLOCK("Apply Smooth Effect");
+
+            // the previews read the working heightmaps of neighbouring tiles so are composited afterwards
+            brushCompositeWorkingRegion(
+                &memory->arena, &tile->brushBuffers, &update, &brushParams, segments, segmentCount, offset);
+            cpuTileUpdates[i] = update;
+            isCpuTileComposited[i] = true;
+            continue;
+        }
+#endif
+
         TemporaryMemory tileRenderMemory = beginTemporaryMemory(&memory->arena);
 
         // render brush influence mask
         {
             TIMED_BLOCK("Draw Influence Masks");
 
-            TextureHandle baseInfluenceTexture = {0};
-            if (activeBrushStroke->renderedInstanceCount > 0)
-            {
-                baseInfluenceTexture = tile->workingPrevBrushInfluenceMask->textureHandle;
-            }
-            drawInfluenceMask(state->renderCtx, &memory->arena, baseInfluenceTexture, activeBrushStrokeQuads,
-                instancesToRender, offset, influenceMaskEffect, tile->workingBrushInfluenceMask);
-            drawInfluenceMask(state->renderCtx, &memory->arena, {0}, previewBrushStrokeQuadPtr, 1, offset,
-                influenceMaskEffect, tile->previewBrushInfluenceMask);
+            drawInfluenceMask(state->renderCtx, &memory->arena, update.workingMaskClearRect, segmentQuads,
+                segmentEffects, segmentCount, offset, tile->workingBrushInfluenceMask);
+            drawInfluenceMask(state->renderCtx, &memory->arena, update.previewMaskClearRect, &previewQuad,
+                &previewEffect, previewQuadCount, offset, tile->previewBrushInfluenceMask);
         }
 
         // render heightmap
@@ -216,11 +775,13 @@ void compositeHeightmaps(EditorMemory *memory, BrushStroke *activeBrushStroke, g
 
             RenderEffect *workingEffect = createAddSubEffect(&memory->arena, &state->editorAssets,
                 tile->committedHeightmap->textureHandle, tile->workingBrushInfluenceMask->textureHandle, 1);
-            drawFullSizeQuadToTarget(state->renderCtx, &memory->arena, workingEffect, tile->workingHeightmap);
+            drawFullSizeQuadToTarget(
+                state->renderCtx, &memory->arena, workingEffect, tile->workingHeightmap, workingRect);
 
             RenderEffect *previewEffect = createAddSubEffect(&memory->arena, &state->editorAssets,
                 tile->workingHeightmap->textureHandle, tile->previewBrushInfluenceMask->textureHandle, 1);
-            drawFullSizeQuadToTarget(state->renderCtx, &memory->arena, previewEffect, tile->previewHeightmap);
+            drawFullSizeQuadToTarget(
+                state->renderCtx, &memory->arena, previewEffect, tile->previewHeightmap, previewRect);
         }
         break;
         case TERRAIN_BRUSH_TOOL_LOWER:
@@ -229,11 +790,13 @@ void compositeHeightmaps(EditorMemory *memory, BrushStroke *activeBrushStroke, g
 
             RenderEffect *workingEffect = createAddSubEffect(&memory->arena, &state->editorAssets,
                 tile->committedHeightmap->textureHandle, tile->workingBrushInfluenceMask->textureHandle, -1);
-            drawFullSizeQuadToTarget(state->renderCtx, &memory->arena, workingEffect, tile->workingHeightmap);
+            drawFullSizeQuadToTarget(
+                state->renderCtx, &memory->arena, workingEffect, tile->workingHeightmap, workingRect);
 
             RenderEffect *previewEffect = createAddSubEffect(&memory->arena, &state->editorAssets,
                 tile->workingHeightmap->textureHandle, tile->previewBrushInfluenceMask->textureHandle, -1);
-            drawFullSizeQuadToTarget(state->renderCtx, &memory->arena, previewEffect, tile->previewHeightmap);
+            drawFullSizeQuadToTarget(
+                state->renderCtx, &memory->arena, previewEffect, tile->previewHeightmap, previewRect);
         }
         break;
         case TERRAIN_BRUSH_TOOL_FLATTEN:
@@ -243,12 +806,14 @@ void compositeHeightmaps(EditorMemory *memory, BrushStroke *activeBrushStroke, g
             RenderEffect *workingEffect =
                 createFlattenEffect(&memory->arena, &state->editorAssets, tile->committedHeightmap->textureHandle,
                     tile->workingBrushInfluenceMask->textureHandle, activeBrushStroke->startingHeight);
-            drawFullSizeQuadToTarget(state->renderCtx, &memory->arena, workingEffect, tile->workingHeightmap);
+            drawFullSizeQuadToTarget(
+                state->renderCtx, &memory->arena, workingEffect, tile->workingHeightmap, workingRect);
 
             RenderEffect *previewEffect =
                 createFlattenEffect(&memory->arena, &state->editorAssets, tile->workingHeightmap->textureHandle,
                     tile->previewBrushInfluenceMask->textureHandle, activeBrushStroke->startingHeight);
-            drawFullSizeQuadToTarget(state->renderCtx, &memory->arena, previewEffect, tile->previewHeightmap);
+            drawFullSizeQuadToTarget(
+                state->renderCtx, &memory->arena, previewEffect, tile->previewHeightmap, previewRect);
         }
         break;
         case TERRAIN_BRUSH_TOOL_SMOOTH:
@@ -257,82 +822,71 @@ void compositeHeightmaps(EditorMemory *memory, BrushStroke *activeBrushStroke, g
 
             applySmoothEffectToTarget(&memory->arena, state->renderCtx, &state->editorAssets,
                 tile->committedHeightmap, tile->workingBrushInfluenceMask, state->temporaryHeightmap,
-                tile->workingHeightmap);
+                tile->workingHeightmap, workingRect);
             applySmoothEffectToTarget(&memory->arena, state->renderCtx, &state->editorAssets,
                 tile->workingHeightmap, tile->previewBrushInfluenceMask, state->temporaryHeightmap,
-                tile->previewHeightmap);
+                tile->previewHeightmap, previewRect);
         }
         break;
         }
 
-        endTemporaryMemory(&tileRenderMemory);
+#if DEBUG_VERIFY_CPU_BRUSH
+        verifyCpuBrushComposite(state, &memory->arena, tile, &update, &brushParams, segments, segmentCount,
+            previewSegmentPtr, offset);
+#endif
 
-        RenderTarget *swapTarget = tile->workingPrevBrushInfluenceMask;
-        tile->workingPrevBrushInfluenceMask = tile->workingBrushInfluenceMask;
-        tile->workingBrushInfluenceMask = swapTarget;
+        endTemporaryMemory(&tileRenderMemory);
     }
 
-    if (tool == TERRAIN_BRUSH_TOOL_SMOOTH)
+#if FEATURE_CPU_SMOOTH_BRUSH
+    for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
     {
-        TIMED_BLOCK("Smooth Tool Fix-up");
+        if (isCpuTileComposited[i])
+        {
+            TIMED_BLOCK("Apply Smooth Effect");
 
-        float overlapInTexels = HEIGHTMAP_OVERLAP_IN_TEXELS;
-        float overlapInUvSpace = overlapInTexels / HEIGHTMAP_DIM;
-        float heightmapDimWithoutOverlapInUvSpace = heightmapDimWithoutOverlap / HEIGHTMAP_DIM;
+            TerrainTile *tile = &sceneState->terrainTiles[i];
+            glm::vec2 offset = (tile->center - (extendedTileDim * 0.5f)) * worldToHeightmapSpace;
+            brushCompositePreviewRegion(
+                &memory->arena, &tile->brushBuffers, &cpuTileUpdates[i], &brushParams, previewSegmentPtr, offset);
+        }
+    }
+#endif
 
-        float wT = HEIGHTMAP_DIM;
-        float wU = 1;
-        float oT = HEIGHTMAP_OVERLAP_IN_TEXELS;
-        float oU = oT / wT;
-        float eT = heightmapDimWithoutOverlap;
-        float eU = eT / wT;
+    // smoothing reads texels from across the tile's edges so the overlapping borders will no longer match
+    if (brushParams.blendOperation == BRUSH_BLEND_SMOOTH || brushParams.blendOperation == BRUSH_BLEND_SMOOTH_BOX)
+    {
+        resolveTileSeams(state, &memory->arena, isCompositedOnCpu, workingChangedRects, previewChangedRects);
+    }
 
+    {
+        TIMED_BLOCK("Sync Heightmaps");
+
+        /*
+         * Brushes composited on the CPU need their output uploaded. Otherwise, the CPU copy of the
+         * working heightmap is used for raycasting so the changed regions need to be read back. The
+         * readbacks complete asynchronously and are applied once the GPU has caught up.
+         */
         for (uint32 i = 0; i < sceneState->terrainTileCount; i++)
         {
             TerrainTile *tile = &sceneState->terrainTiles[i];
-            TerrainTile *tileToRight = tile->tileToRight;
-            TerrainTile *tileBelow = tile->tileBelow;
-
-            TemporaryMemory tileRenderMemory = beginTemporaryMemory(&memory->arena);
-
-            if (tileToRight)
+            BrushTileBuffers *buffers = &tile->brushBuffers;
+            if (isCompositedOnCpu)
             {
-                blitTileRegion(state->renderCtx, &memory->arena, tile, rectMinDim(eU, oU, oU, eU), tileToRight,
-                    rectMinDim(0, oT, oT, eT));
-                blitTileRegion(state->renderCtx, &memory->arena, tileToRight, rectMinDim(oU, oU, oU, eU), tile,
-                    rectMinDim(wT - oT, oT, oT, eT));
+                uploadHeightmapRegion(tile->workingHeightmap, buffers->workingHeightmap, workingChangedRects[i]);
+                uploadHeightmapRegion(tile->previewHeightmap, buffers->previewHeightmap, previewChangedRects[i]);
+                tile->heightfieldDirtyRect = rectUnion(tile->heightfieldDirtyRect, workingChangedRects[i]);
             }
-            if (tileBelow)
+            else
             {
-                blitTileRegion(state->renderCtx, &memory->arena, tile, rectMinDim(oU, eU, eU, oU), tileBelow,
-                    rectMinDim(oT, 0, eT, oT));
-                blitTileRegion(state->renderCtx, &memory->arena, tileBelow, rectMinDim(oU, oU, eU, oU), tile,
-                    rectMinDim(oT, wT - oT, eT, oT));
-
-                TerrainTile *tileBelowToLeft = tileBelow->tileToLeft;
-                if (tileBelowToLeft)
-                {
-                    blitTileRegion(state->renderCtx, &memory->arena, tile, rectMinDim(oU, eU, oU, oU),
-                        tileBelowToLeft, rectMinDim(wT - oT, 0, oT, oT));
-                    blitTileRegion(state->renderCtx, &memory->arena, tileBelowToLeft, rectMinDim(eU, oU, oU, oU),
-                        tile, rectMinDim(0, wT - oT, oT, oT));
-                }
-
-                TerrainTile *tileBelowToRight = tileBelow->tileToRight;
-                if (tileBelowToRight)
-                {
-                    blitTileRegion(state->renderCtx, &memory->arena, tile, rectMinDim(eU, eU, oU, oU),
-                        tileBelowToRight, rectMinDim(0, 0, oT, oT));
-                    blitTileRegion(state->renderCtx, &memory->arena, tileBelowToRight, rectMinDim(oU, oU, oU, oU),
-                        tile, rectMinDim(wT - oT, wT - oT, oT, oT));
-                }
+                queueHeightmapReadback(state, i, workingChangedRects[i]);
             }
-
-            endTemporaryMemory(&tileRenderMemory);
         }
     }
 
     endTemporaryMemory(&renderMemory);
 
-    activeBrushStroke->renderedInstanceCount = activeBrushStroke->totalInstanceCount;
+    activeBrushStroke->renderedVertexCount = activeBrushStroke->vertexCount;
+    activeBrushStroke->lastRenderedVertex = activeBrushStroke->lastVertex;
+    brushStrokeRetireChunks(activeBrushStroke);
 }
\ No newline at end of file
@@ -1,14 +1,98 @@
 #ifndef SIERRA_HEIGHTMAP_H
 #define SIERRA_HEIGHTMAP_H
 
-#define MAX_BRUSH_QUADS 2048
+#define BRUSH_STROKE_CHUNK_VERTEX_COUNT 256
+
+struct BrushStrokeChunk
+{
+    glm::vec2 vertices[BRUSH_STROKE_CHUNK_VERTEX_COUNT];
+    uint32 vertexCount;
+    BrushStrokeChunk *next;
+};
 
 struct BrushStroke
 {
-    glm::vec2 positions[MAX_BRUSH_QUADS];
-    uint32 totalInstanceCount;
-    uint32 renderedInstanceCount;
+    MemoryArena *arena;
+
+    /*
+     * Only vertices that haven't been rendered into the influence masks yet are stored. Chunks are
+     * recycled once their vertices have been rendered, so memory usage doesn't grow with the
+     * length of the stroke.
+     */
+    BrushStrokeChunk *firstChunk;
+    BrushStrokeChunk *lastChunk;
+    BrushStrokeChunk *firstFreeChunk;
+
+    uint32 vertexCount;
+    uint32 renderedVertexCount;
+
+    // the most recently added vertex and the last vertex that was rendered
+    glm::vec2 lastVertex;
+    glm::vec2 lastRenderedVertex;
+
     float startingHeight;
 };
 
+struct BrushVerificationStats
+{
+    // heightmap texels composited by the brush shaders that were compared with the CPU brush engine's output
+    uint64 comparedCount;
+    uint64 mismatchCount;
+    uint32 maxDifference;
+};
+
+// the maximum number of seam copies per tile (two for each of the four neighbours it shares a seam with)
+#define MAX_SEAM_COPIES_PER_TILE 8
+
+struct TileSeamCopy
+{
+    // copies a strip inside the source tile to the overlapping border of a neighbouring tile
+    uint32 srcTileIndex;
+    uint32 dstTileIndex;
+    rect2 srcRect;
+    glm::vec2 dstOffset;
+
+    // the parts of the strip that changed in each heightmap
+    rect2 workingRect;
+    rect2 previewRect;
+};
+
+// the maximum number of heightmap readbacks that can be in flight before the oldest one is waited on
+#define HEIGHTMAP_READBACK_RING_SIZE 32
+
+struct HeightmapReadback
+{
+    GetPixelsRequest request;
+    uint32 tileIndex;
+    rect2 region;
+    uint64 frameQueued;
+};
+
+struct HeightmapReadbackStats
+{
+    // readbacks that have been queued but not yet applied to the CPU copies of the working heightmaps
+    uint32 pendingCount;
+
+    // how many frames the CPU copies of the working heightmaps lag behind the render targets
+    uint32 framesBehind;
+    uint32 maxFramesBehind;
+
+    // readbacks that were waited on because the ring was full or the CPU copies needed to be up to date
+    uint32 blockingCount;
+};
+
+struct HeightmapReadbackRing
+{
+    /*
+     * Readbacks are applied in the order they were queued, so a region that changed in consecutive
+     * frames always ends up with the newest pixels.
+     */
+    HeightmapReadback entries[HEIGHTMAP_READBACK_RING_SIZE];
+    uint32 firstEntry;
+    uint32 entryCount;
+
+    uint64 currentFrame;
+    HeightmapReadbackStats stats;
+};
+
 #endif
\ No newline at end of file
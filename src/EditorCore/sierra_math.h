@@ -11,6 +11,14 @@ inline uint32 max(uint32 a, uint32 b)
 {
     return a > b ? a : b;
 }
+inline int32 min(int32 a, int32 b)
+{
+    return a > b ? b : a;
+}
+inline int32 max(int32 a, int32 b)
+{
+    return a > b ? a : b;
+}
 inline float lerp(float a, float b, float t)
 {
     return ((1 - t) * a) + (t * b);
@@ -71,5 +79,50 @@ inline glm::vec2 getMax(rect2 rect)
 {
     return glm::vec2(rect.x + rect.width, rect.y + rect.height);
 }
+inline bool isRectEmpty(rect2 rect)
+{
+    return rect.width <= 0 || rect.height <= 0;
+}
+inline bool isPointInRect(rect2 rect, glm::vec2 point)
+{
+    return point.x >= rect.x && point.x < rect.x + rect.width && point.y >= rect.y
+        && point.y < rect.y + rect.height;
+}
+inline rect2 rectUnion(rect2 a, rect2 b)
+{
+    if (isRectEmpty(a))
+    {
+        return b;
+    }
+    if (isRectEmpty(b))
+    {
+        return a;
+    }
+    return rectMinMax(glm::min(getMin(a), getMin(b)), glm::max(getMax(a), getMax(b)));
+}
+inline rect2 rectIntersection(rect2 a, rect2 b)
+{
+    glm::vec2 min = glm::max(getMin(a), getMin(b));
+    glm::vec2 max = glm::max(glm::min(getMax(a), getMax(b)), min);
+    return rectMinMax(min, max);
+}
+inline bool rectsIntersect(rect2 a, rect2 b)
+{
+    return !isRectEmpty(rectIntersection(a, b));
+}
+inline rect2 rectExpand(rect2 rect, float x, float y)
+{
+    if (isRectEmpty(rect))
+    {
+        return rect;
+    }
+    return rectMinDim(rect.x - x, rect.y - y, rect.width + (2 * x), rect.height + (2 * y));
+}
+inline rect2 rectRoundOutward(rect2 rect)
+{
+    glm::vec2 min = glm::floor(getMin(rect));
+    glm::vec2 max = glm::ceil(getMax(rect));
+    return rectMinMax(min, max);
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,695 @@
+// returns a chunk directory with room for one more chunk, replacing it with one twice the size if it is full
+void **reserveObjectChunkSlot(MemoryArena *arena, void **chunks, uint32 chunkCount, uint32 *maxChunkCount)
+{
+    if (chunkCount < *maxChunkCount)
+    {
+        return chunks;
+    }
+
+    uint32 newMaxChunkCount = *maxChunkCount ? *maxChunkCount * 2 : 16;
+    void **newChunks = pushArray(arena, void *, newMaxChunkCount);
+    if (chunkCount)
+    {
+        memcpy(newChunks, chunks, sizeof(void *) * chunkCount);
+    }
+    *maxChunkCount = newMaxChunkCount;
+
+    return newChunks;
+}
+
+// object stores
+
+#define OBJECT_ID_MAP_MIN_SLOT_COUNT (OBJECT_CHUNK_CAPACITY * 2)
+
+void objectStoreInitialize(ObjectStore *store, MemoryArena *arena)
+{
+    *store = {};
+    store->arena = arena;
+}
+
+inline uint32 getObjectIdMapHomeSlot(ObjectStore *store, uint32 id)
+{
+    // Fibonacci hashing, the top bits of the product are the best mixed so those are used as the slot
+    return (id * 2654435769u) >> store->idMapHashShift;
+}
+
+// returns the slot containing the given ID, or the empty slot where it would be inserted
+inline uint32 findObjectIdMapSlot(ObjectStore *store, uint32 id)
+{
+    uint32 mask = store->idMapSlotCount - 1;
+    uint32 slot = getObjectIdMapHomeSlot(store, id);
+    while (store->idMapSlots[slot].id && store->idMapSlots[slot].id != id)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void allocateObjectIdMap(ObjectStore *store, uint32 slotCount)
+{
+    store->idMapSlots = pushArray(store->arena, ObjectIdMapSlot, slotCount);
+    store->idMapSlotCount = slotCount;
+
+    uint32 bitCount = 0;
+    while ((1u << bitCount) < slotCount)
+    {
+        bitCount++;
+    }
+    store->idMapHashShift = 32 - bitCount;
+}
+
+// makes sure the ID map has room for the given number of objects, rebuilding it from the chunks if needed
+void objectStoreReserveIdMap(ObjectStore *store, uint32 count)
+{
+    if (store->idMapSlotCount && count * 2 <= store->idMapSlotCount)
+    {
+        return;
+    }
+
+    uint32 slotCount = store->idMapSlotCount ? store->idMapSlotCount : OBJECT_ID_MAP_MIN_SLOT_COUNT;
+    while (count * 2 > slotCount)
+    {
+        slotCount *= 2;
+    }
+    allocateObjectIdMap(store, slotCount);
+    memset(store->idMapSlots, 0, sizeof(ObjectIdMapSlot) * slotCount);
+
+    for (uint32 c = 0; c < getObjectChunkCount(store->count); c++)
+    {
+        ObjectChunk *chunk = store->chunks[c];
+        uint32 countInChunk = getObjectCountInChunk(store->count, c);
+        for (uint32 i = 0; i < countInChunk; i++)
+        {
+            ObjectIdMapSlot *slot = &store->idMapSlots[findObjectIdMapSlot(store, chunk->ids[i])];
+            slot->id = chunk->ids[i];
+            slot->index = (c * OBJECT_CHUNK_CAPACITY) + i;
+        }
+    }
+}
+
+// removes an ID from the map, shifting back any entries that were displaced past its slot
+void removeObjectId(ObjectStore *store, uint32 id)
+{
+    uint32 mask = store->idMapSlotCount - 1;
+    uint32 emptySlot = findObjectIdMapSlot(store, id);
+    assert(store->idMapSlots[emptySlot].id == id);
+
+    uint32 slot = emptySlot;
+    while (true)
+    {
+        slot = (slot + 1) & mask;
+        ObjectIdMapSlot *entry = &store->idMapSlots[slot];
+        if (!entry->id)
+        {
+            break;
+        }
+
+        // an entry can fill the empty slot if the empty slot is between the entry's home slot and its slot
+        uint32 homeSlot = getObjectIdMapHomeSlot(store, entry->id);
+        uint32 distanceFromHome = (slot - homeSlot) & mask;
+        uint32 distanceFromEmpty = (slot - emptySlot) & mask;
+        if (distanceFromHome >= distanceFromEmpty)
+        {
+            store->idMapSlots[emptySlot] = *entry;
+            emptySlot = slot;
+        }
+    }
+    store->idMapSlots[emptySlot] = {};
+}
+
+inline ObjectChunk *objectStoreGetChunk(ObjectStore *store, uint32 index, uint32 *outSlot)
+{
+    assert(index < store->count);
+    *outSlot = index % OBJECT_CHUNK_CAPACITY;
+    return store->chunks[index / OBJECT_CHUNK_CAPACITY];
+}
+
+// makes sure the dirty list has room for the given number of IDs
+void objectStoreReserveDirtyIds(ObjectStore *store, uint32 count)
+{
+    if (count <= store->maxDirtyIdCount)
+    {
+        return;
+    }
+
+    uint32 newMaxDirtyIdCount = store->maxDirtyIdCount ? store->maxDirtyIdCount * 2 : OBJECT_CHUNK_CAPACITY;
+    while (newMaxDirtyIdCount < count)
+    {
+        newMaxDirtyIdCount *= 2;
+    }
+    uint32 *newDirtyIds = pushArray(store->arena, uint32, newMaxDirtyIdCount);
+    if (store->dirtyIdCount)
+    {
+        memcpy(newDirtyIds, store->dirtyIds, sizeof(uint32) * store->dirtyIdCount);
+    }
+    store->dirtyIds = newDirtyIds;
+    store->maxDirtyIdCount = newMaxDirtyIdCount;
+}
+
+void pushDirtyObjectId(ObjectStore *store, uint32 id)
+{
+    objectStoreReserveDirtyIds(store, store->dirtyIdCount + 1);
+    store->dirtyIds[store->dirtyIdCount++] = id;
+}
+
+void objectStoreMarkDirty(ObjectStore *store, uint32 index)
+{
+    uint32 slot;
+    ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+    if (!chunk->isDirty[slot])
+    {
+        pushDirtyObjectId(store, chunk->ids[slot]);
+        chunk->isDirty[slot] = true;
+    }
+}
+
+// makes sure there are enough chunks for the given number of objects
+void objectStoreReserve(ObjectStore *store, uint32 count)
+{
+    while (store->chunkCount < getObjectChunkCount(count))
+    {
+        store->chunks = (ObjectChunk **)reserveObjectChunkSlot(
+            store->arena, (void **)store->chunks, store->chunkCount, &store->maxChunkCount);
+        store->chunks[store->chunkCount++] =
+            pushStructAligned(store->arena, ObjectChunk, OBJECT_CHUNK_ALIGNMENT);
+    }
+}
+
+// adds an object with an identity transform and returns its index
+uint32 objectStoreAdd(ObjectStore *store, uint32 id)
+{
+    assert(id);
+    objectStoreReserve(store, store->count + 1);
+    objectStoreReserveIdMap(store, store->count + 1);
+    uint32 index = store->count++;
+
+    ObjectIdMapSlot *mapSlot = &store->idMapSlots[findObjectIdMapSlot(store, id)];
+    assert(!mapSlot->id);
+    mapSlot->id = id;
+    mapSlot->index = index;
+
+    uint32 slot;
+    ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+    chunk->ids[slot] = id;
+    chunk->positionX[slot] = 0;
+    chunk->positionY[slot] = 0;
+    chunk->positionZ[slot] = 0;
+    chunk->rotationX[slot] = 0;
+    chunk->rotationY[slot] = 0;
+    chunk->rotationZ[slot] = 0;
+    chunk->scaleX[slot] = 1;
+    chunk->scaleY[slot] = 1;
+    chunk->scaleZ[slot] = 1;
+    chunk->isDirty[slot] = false;
+    objectStoreMarkDirty(store, index);
+
+    return index;
+}
+
+// removes an object by moving the last object into its place
+void objectStoreRemove(ObjectStore *store, uint32 index)
+{
+    uint32 slot;
+    ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+    removeObjectId(store, chunk->ids[slot]);
+
+    // the removed object stays in the dirty list so anything derived from it can be updated
+    if (!chunk->isDirty[slot])
+    {
+        pushDirtyObjectId(store, chunk->ids[slot]);
+    }
+
+    uint32 lastIndex = store->count - 1;
+    if (index != lastIndex)
+    {
+        uint32 lastSlot;
+        ObjectChunk *lastChunk = objectStoreGetChunk(store, lastIndex, &lastSlot);
+        store->idMapSlots[findObjectIdMapSlot(store, lastChunk->ids[lastSlot])].index = index;
+
+        chunk->ids[slot] = lastChunk->ids[lastSlot];
+        chunk->positionX[slot] = lastChunk->positionX[lastSlot];
+        chunk->positionY[slot] = lastChunk->positionY[lastSlot];
+        chunk->positionZ[slot] = lastChunk->positionZ[lastSlot];
+        chunk->rotationX[slot] = lastChunk->rotationX[lastSlot];
+        chunk->rotationY[slot] = lastChunk->rotationY[lastSlot];
+        chunk->rotationZ[slot] = lastChunk->rotationZ[lastSlot];
+        chunk->scaleX[slot] = lastChunk->scaleX[lastSlot];
+        chunk->scaleY[slot] = lastChunk->scaleY[lastSlot];
+        chunk->scaleZ[slot] = lastChunk->scaleZ[lastSlot];
+        chunk->isDirty[slot] = lastChunk->isDirty[lastSlot];
+    }
+    store->count--;
+
+    if (index != lastIndex)
+    {
+        objectStoreMarkDirty(store, index);
+    }
+}
+
+// returns the index of the object with the given ID, or -1 if there is no such object
+int32 objectStoreFind(ObjectStore *store, uint32 id)
+{
+    if (!store->idMapSlotCount || !id)
+    {
+        return -1;
+    }
+
+    ObjectIdMapSlot *slot = &store->idMapSlots[findObjectIdMapSlot(store, id)];
+    return slot->id ? (int32)slot->index : -1;
+}
+
+void objectStoreClearDirty(ObjectStore *store)
+{
+    for (uint32 i = 0; i < store->dirtyIdCount; i++)
+    {
+        int32 index = objectStoreFind(store, store->dirtyIds[i]);
+        if (index >= 0)
+        {
+            uint32 slot;
+            ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+            chunk->isDirty[slot] = false;
+        }
+    }
+    store->dirtyIdCount = 0;
+}
+
+inline uint32 objectStoreGetId(ObjectStore *store, uint32 index)
+{
+    uint32 slot;
+    ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+    return chunk->ids[slot];
+}
+
+inline glm::vec3 objectStoreGetPosition(ObjectStore *store, uint32 index)
+{
+    uint32 slot;
+    ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+    return glm::vec3(chunk->positionX[slot], chunk->positionY[slot], chunk->positionZ[slot]);
+}
+
+float *objectStoreGetProperty(ObjectStore *store, uint32 index, ObjectProperty property)
+{
+    uint32 slot;
+    ObjectChunk *chunk = objectStoreGetChunk(store, index, &slot);
+    switch (property)
+    {
+    case PROP_OBJ_POSITION_X:
+        return &chunk->positionX[slot];
+    case PROP_OBJ_POSITION_Y:
+        return &chunk->positionY[slot];
+    case PROP_OBJ_POSITION_Z:
+        return &chunk->positionZ[slot];
+    case PROP_OBJ_ROTATION_X:
+        return &chunk->rotationX[slot];
+    case PROP_OBJ_ROTATION_Y:
+        return &chunk->rotationY[slot];
+    case PROP_OBJ_ROTATION_Z:
+        return &chunk->rotationZ[slot];
+    case PROP_OBJ_SCALE_X:
+        return &chunk->scaleX[slot];
+    case PROP_OBJ_SCALE_Y:
+        return &chunk->scaleY[slot];
+    case PROP_OBJ_SCALE_Z:
+        return &chunk->scaleZ[slot];
+    }
+    return 0;
+}
+
+// replaces the objects in one store with the objects in another, only the occupied part of each chunk is copied
+void objectStoreCopy(ObjectStore *dst, ObjectStore *src)
+{
+    objectStoreReserve(dst, src->count);
+    for (uint32 c = 0; c < getObjectChunkCount(src->count); c++)
+    {
+        ObjectChunk *srcChunk = src->chunks[c];
+        ObjectChunk *dstChunk = dst->chunks[c];
+        uint32 size = sizeof(float) * getObjectCountInChunk(src->count, c);
+
+        memcpy(dstChunk->ids, srcChunk->ids, size);
+        memcpy(dstChunk->positionX, srcChunk->positionX, size);
+        memcpy(dstChunk->positionY, srcChunk->positionY, size);
+        memcpy(dstChunk->positionZ, srcChunk->positionZ, size);
+        memcpy(dstChunk->rotationX, srcChunk->rotationX, size);
+        memcpy(dstChunk->rotationY, srcChunk->rotationY, size);
+        memcpy(dstChunk->rotationZ, srcChunk->rotationZ, size);
+        memcpy(dstChunk->scaleX, srcChunk->scaleX, size);
+        memcpy(dstChunk->scaleY, srcChunk->scaleY, size);
+        memcpy(dstChunk->scaleZ, srcChunk->scaleZ, size);
+        memcpy(dstChunk->isDirty, srcChunk->isDirty, sizeof(bool) * getObjectCountInChunk(src->count, c));
+    }
+    dst->count = src->count;
+
+    objectStoreReserveDirtyIds(dst, src->dirtyIdCount);
+    if (src->dirtyIdCount)
+    {
+        memcpy(dst->dirtyIds, src->dirtyIds, sizeof(uint32) * src->dirtyIdCount);
+    }
+    dst->dirtyIdCount = src->dirtyIdCount;
+
+    if (dst->idMapSlotCount != src->idMapSlotCount)
+    {
+        allocateObjectIdMap(dst, src->idMapSlotCount);
+    }
+    memcpy(dst->idMapSlots, src->idMapSlots, sizeof(ObjectIdMapSlot) * src->idMapSlotCount);
+}
+
+// object instance stores
+
+void objectInstanceStoreInitialize(ObjectInstanceStore *store, MemoryArena *arena)
+{
+    *store = {};
+    store->arena = arena;
+}
+
+inline ObjectInstanceChunk *objectInstanceStoreGetChunk(ObjectInstanceStore *store, uint32 index, uint32 *outSlot)
+{
+    assert(index < store->count);
+    *outSlot = index % OBJECT_CHUNK_CAPACITY;
+    return store->chunks[index / OBJECT_CHUNK_CAPACITY];
+}
+
+inline RenderMeshInstance *objectInstanceStoreGetInstance(ObjectInstanceStore *store, uint32 index)
+{
+    uint32 slot;
+    ObjectInstanceChunk *chunk = objectInstanceStoreGetChunk(store, index, &slot);
+    return &chunk->instances[slot];
+}
+
+// sets the number of instances, the new instances are left uninitialized
+void objectInstanceStoreResize(ObjectInstanceStore *store, uint32 count)
+{
+    while (store->chunkCount < getObjectChunkCount(count))
+    {
+        store->chunks = (ObjectInstanceChunk **)reserveObjectChunkSlot(
+            store->arena, (void **)store->chunks, store->chunkCount, &store->maxChunkCount);
+        store->chunks[store->chunkCount++] =
+            pushStructAligned(store->arena, ObjectInstanceChunk, OBJECT_CHUNK_ALIGNMENT);
+    }
+    store->count = count;
+}
+
+// object transforms
+
+#define OBJECT_TRANSFORM_BATCH_SIZE 8
+#define OBJECT_DEGREES_TO_HALF_RADIANS 0.00872664619f
+
+// transform properties of a batch of objects in structure-of-arrays layout, and the instances to write them to
+struct ObjectTransformBatch
+{
+    float positionX[OBJECT_TRANSFORM_BATCH_SIZE];
+    float positionY[OBJECT_TRANSFORM_BATCH_SIZE];
+    float positionZ[OBJECT_TRANSFORM_BATCH_SIZE];
+    float rotationX[OBJECT_TRANSFORM_BATCH_SIZE];
+    float rotationY[OBJECT_TRANSFORM_BATCH_SIZE];
+    float rotationZ[OBJECT_TRANSFORM_BATCH_SIZE];
+    float scaleX[OBJECT_TRANSFORM_BATCH_SIZE];
+    float scaleY[OBJECT_TRANSFORM_BATCH_SIZE];
+    float scaleZ[OBJECT_TRANSFORM_BATCH_SIZE];
+
+    uint32 ids[OBJECT_TRANSFORM_BATCH_SIZE];
+    RenderMeshInstance *instances[OBJECT_TRANSFORM_BATCH_SIZE];
+};
+
+/*
+ * Each object's transform translates, then scales, then rotates by the quaternion for its Euler angles
+ * (in degrees), matching glm::translate, glm::scale and glm::toMat4(glm::quat(glm::radians(rotation))).
+ * Every version performs the same floating-point operations in the same order so they agree.
+ */
+
+void computeObjectTransformsScalar(ObjectTransformBatch *batch, uint32 first, uint32 last)
+{
+    for (uint32 i = first; i < last; i++)
+    {
+        float sx, cx, sy, cy, sz, cz;
+        sinCosApprox(batch->rotationX[i] * OBJECT_DEGREES_TO_HALF_RADIANS, &sx, &cx);
+        sinCosApprox(batch->rotationY[i] * OBJECT_DEGREES_TO_HALF_RADIANS, &sy, &cy);
+        sinCosApprox(batch->rotationZ[i] * OBJECT_DEGREES_TO_HALF_RADIANS, &sz, &cz);
+
+        float cxcy = cx * cy;
+        float sxsy = sx * sy;
+        float sxcy = sx * cy;
+        float cxsy = cx * sy;
+        float qw = (cxcy * cz) + (sxsy * sz);
+        float qx = (sxcy * cz) - (cxsy * sz);
+        float qy = (cxsy * cz) + (sxcy * sz);
+        float qz = (cxcy * sz) - (sxsy * cz);
+
+        float xx = qx * qx;
+        float yy = qy * qy;
+        float zz = qz * qz;
+        float xy = qx * qy;
+        float xz = qx * qz;
+        float yz = qy * qz;
+        float wx = qw * qx;
+        float wy = qw * qy;
+        float wz = qw * qz;
+
+        float scaleX = batch->scaleX[i];
+        float scaleY = batch->scaleY[i];
+        float scaleZ = batch->scaleZ[i];
+        glm::mat4 *transform = &batch->instances[i]->transform;
+        (*transform)[0][0] = (1.0f - (2.0f * (yy + zz))) * scaleX;
+        (*transform)[0][1] = (2.0f * (xy + wz)) * scaleY;
+        (*transform)[0][2] = (2.0f * (xz - wy)) * scaleZ;
+        (*transform)[0][3] = 0;
+        (*transform)[1][0] = (2.0f * (xy - wz)) * scaleX;
+        (*transform)[1][1] = (1.0f - (2.0f * (xx + zz))) * scaleY;
+        (*transform)[1][2] = (2.0f * (yz + wx)) * scaleZ;
+        (*transform)[1][3] = 0;
+        (*transform)[2][0] = (2.0f * (xz + wy)) * scaleX;
+        (*transform)[2][1] = (2.0f * (yz - wx)) * scaleY;
+        (*transform)[2][2] = (1.0f - (2.0f * (xx + yy))) * scaleZ;
+        (*transform)[2][3] = 0;
+        (*transform)[3][0] = batch->positionX[i];
+        (*transform)[3][1] = batch->positionY[i];
+        (*transform)[3][2] = batch->positionZ[i];
+        (*transform)[3][3] = 1;
+        batch->instances[i]->id = batch->ids[i];
+    }
+}
+
+// writes 4 objects' transforms given each matrix element for all 4 objects, in column-major order
+inline void storeObjectTransforms4(RenderMeshInstance **instances, __m128 *elements)
+{
+    // transposing a column's elements gives that column for each object
+    for (uint32 c = 0; c < 4; c++)
+    {
+        __m128 object0 = elements[(c * 4) + 0];
+        __m128 object1 = elements[(c * 4) + 1];
+        __m128 object2 = elements[(c * 4) + 2];
+        __m128 object3 = elements[(c * 4) + 3];
+        _MM_TRANSPOSE4_PS(object0, object1, object2, object3);
+        _mm_storeu_ps(&instances[0]->transform[c][0], object0);
+        _mm_storeu_ps(&instances[1]->transform[c][0], object1);
+        _mm_storeu_ps(&instances[2]->transform[c][0], object2);
+        _mm_storeu_ps(&instances[3]->transform[c][0], object3);
+    }
+}
+void computeObjectTransforms4(ObjectTransformBatch *batch, uint32 first)
+{
+    __m128 degreesToHalfRadians = _mm_set1_ps(OBJECT_DEGREES_TO_HALF_RADIANS);
+    __m128 sx, cx, sy, cy, sz, cz;
+    sinCosApprox4(_mm_mul_ps(_mm_loadu_ps(&batch->rotationX[first]), degreesToHalfRadians), &sx, &cx);
+    sinCosApprox4(_mm_mul_ps(_mm_loadu_ps(&batch->rotationY[first]), degreesToHalfRadians), &sy, &cy);
+    sinCosApprox4(_mm_mul_ps(_mm_loadu_ps(&batch->rotationZ[first]), degreesToHalfRadians), &sz, &cz);
+
+    __m128 cxcy = _mm_mul_ps(cx, cy);
+    __m128 sxsy = _mm_mul_ps(sx, sy);
+    __m128 sxcy = _mm_mul_ps(sx, cy);
+    __m128 cxsy = _mm_mul_ps(cx, sy);
+    __m128 qw = _mm_add_ps(_mm_mul_ps(cxcy, cz), _mm_mul_ps(sxsy, sz));
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sxcy, cz), _mm_mul_ps(cxsy, sz));
+    __m128 qy = _mm_add_ps(_mm_mul_ps(cxsy, cz), _mm_mul_ps(sxcy, sz));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(cxcy, sz), _mm_mul_ps(sxsy, cz));
+
+    __m128 xx = _mm_mul_ps(qx, qx);
+    __m128 yy = _mm_mul_ps(qy, qy);
+    __m128 zz = _mm_mul_ps(qz, qz);
+    __m128 xy = _mm_mul_ps(qx, qy);
+    __m128 xz = _mm_mul_ps(qx, qz);
+    __m128 yz = _mm_mul_ps(qy, qz);
+    __m128 wx = _mm_mul_ps(qw, qx);
+    __m128 wy = _mm_mul_ps(qw, qy);
+    __m128 wz = _mm_mul_ps(qw, qz);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 scaleX = _mm_loadu_ps(&batch->scaleX[first]);
+    __m128 scaleY = _mm_loadu_ps(&batch->scaleY[first]);
+    __m128 scaleZ = _mm_loadu_ps(&batch->scaleZ[first]);
+    __m128 elements[16] = {
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX), //
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleY),                   //
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleZ),                   //
+        zero,                                                                      //
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleX),                   //
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY), //
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleZ),                   //
+        zero,                                                                      //
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleX),                   //
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleY),                   //
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ), //
+        zero,                                                                      //
+        _mm_loadu_ps(&batch->positionX[first]),                                    //
+        _mm_loadu_ps(&batch->positionY[first]),                                    //
+        _mm_loadu_ps(&batch->positionZ[first]),                                    //
+        one                                                                        //
+    };
+    storeObjectTransforms4(&batch->instances[first], elements);
+    for (uint32 i = first; i < first + 4; i++)
+    {
+        batch->instances[i]->id = batch->ids[i];
+    }
+}
+void computeObjectTransforms8(ObjectTransformBatch *batch)
+{
+    __m256 degreesToHalfRadians = _mm256_set1_ps(OBJECT_DEGREES_TO_HALF_RADIANS);
+    __m256 sx, cx, sy, cy, sz, cz;
+    sinCosApprox8(_mm256_mul_ps(_mm256_loadu_ps(batch->rotationX), degreesToHalfRadians), &sx, &cx);
+    sinCosApprox8(_mm256_mul_ps(_mm256_loadu_ps(batch->rotationY), degreesToHalfRadians), &sy, &cy);
+    sinCosApprox8(_mm256_mul_ps(_mm256_loadu_ps(batch->rotationZ), degreesToHalfRadians), &sz, &cz);
+
+    __m256 cxcy = _mm256_mul_ps(cx, cy);
+    __m256 sxsy = _mm256_mul_ps(sx, sy);
+    __m256 sxcy = _mm256_mul_ps(sx, cy);
+    __m256 cxsy = _mm256_mul_ps(cx, sy);
+    __m256 qw = _mm256_add_ps(_mm256_mul_ps(cxcy, cz), _mm256_mul_ps(sxsy, sz));
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sxcy, cz), _mm256_mul_ps(cxsy, sz));
+    __m256 qy = _mm256_add_ps(_mm256_mul_ps(cxsy, cz), _mm256_mul_ps(sxcy, sz));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(cxcy, sz), _mm256_mul_ps(sxsy, cz));
+
+    __m256 xx = _mm256_mul_ps(qx, qx);
+    __m256 yy = _mm256_mul_ps(qy, qy);
+    __m256 zz = _mm256_mul_ps(qz, qz);
+    __m256 xy = _mm256_mul_ps(qx, qy);
+    __m256 xz = _mm256_mul_ps(qx, qz);
+    __m256 yz = _mm256_mul_ps(qy, qz);
+    __m256 wx = _mm256_mul_ps(qw, qx);
+    __m256 wy = _mm256_mul_ps(qw, qy);
+    __m256 wz = _mm256_mul_ps(qw, qz);
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 two = _mm256_set1_ps(2.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 scaleX = _mm256_loadu_ps(batch->scaleX);
+    __m256 scaleY = _mm256_loadu_ps(batch->scaleY);
+    __m256 scaleZ = _mm256_loadu_ps(batch->scaleZ);
+    __m256 elements[16] = {
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), scaleX), //
+        _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), scaleY),                      //
+        _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), scaleZ),                      //
+        zero,                                                                                  //
+        _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), scaleX),                      //
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), scaleY), //
+        _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), scaleZ),                      //
+        zero,                                                                                  //
+        _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), scaleX),                      //
+        _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), scaleY),                      //
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), scaleZ), //
+        zero,                                                                                  //
+        _mm256_loadu_ps(batch->positionX),                                                     //
+        _mm256_loadu_ps(batch->positionY),                                                     //
+        _mm256_loadu_ps(batch->positionZ),                                                     //
+        one                                                                                    //
+    };
+
+    // the low and high halves each hold 4 objects' elements
+    __m128 lowElements[16];
+    __m128 highElements[16];
+    for (uint32 e = 0; e < 16; e++)
+    {
+        lowElements[e] = _mm256_castps256_ps128(elements[e]);
+        highElements[e] = _mm256_extractf128_ps(elements[e], 1);
+    }
+    storeObjectTransforms4(&batch->instances[0], lowElements);
+    storeObjectTransforms4(&batch->instances[4], highElements);
+    for (uint32 i = 0; i < OBJECT_TRANSFORM_BATCH_SIZE; i++)
+    {
+        batch->instances[i]->id = batch->ids[i];
+    }
+}
+
+/*
+ * Computes the world transforms of the objects at the given indices and writes them straight to their
+ * instances, along with their inverses. Objects are processed in batches, with any unused lanes of the
+ * last batch repeating its last object so the full-width kernels can be used.
+ */
+void objectInstanceStoreUpdateTransforms(
+    ObjectInstanceStore *instances, ObjectStore *objects, uint32 *objectIndices, uint32 count)
+{
+    ObjectTransformBatch batch;
+    for (uint32 first = 0; first < count; first += OBJECT_TRANSFORM_BATCH_SIZE)
+    {
+        uint32 batchCount = count - first;
+        if (batchCount > OBJECT_TRANSFORM_BATCH_SIZE)
+        {
+            batchCount = OBJECT_TRANSFORM_BATCH_SIZE;
+        }
+        for (uint32 i = 0; i < OBJECT_TRANSFORM_BATCH_SIZE; i++)
+        {
+            uint32 index = objectIndices[first + (i < batchCount ? i : batchCount - 1)];
+            uint32 slot;
+            ObjectChunk *chunk = objectStoreGetChunk(objects, index, &slot);
+            batch.positionX[i] = chunk->positionX[slot];
+            batch.positionY[i] = chunk->positionY[slot];
+            batch.positionZ[i] = chunk->positionZ[slot];
+            batch.rotationX[i] = chunk->rotationX[slot];
+            batch.rotationY[i] = chunk->rotationY[slot];
+            batch.rotationZ[i] = chunk->rotationZ[slot];
+            batch.scaleX[i] = chunk->scaleX[slot];
+            batch.scaleY[i] = chunk->scaleY[slot];
+            batch.scaleZ[i] = chunk->scaleZ[slot];
+            batch.ids[i] = chunk->ids[slot];
+            batch.instances[i] = objectInstanceStoreGetInstance(instances, index);
+        }
+
+        switch (getSimdLevel())
+        {
+        case SIMD_LEVEL_AVX2:
+            computeObjectTransforms8(&batch);
+            break;
+        case SIMD_LEVEL_SSE4:
+            computeObjectTransforms4(&batch, 0);
+            if (batchCount > 4)
+            {
+                computeObjectTransforms4(&batch, 4);
+            }
+            break;
+        default:
+            computeObjectTransformsScalar(&batch, 0, batchCount);
+            break;
+        }
+
+        for (uint32 i = 0; i < batchCount; i++)
+        {
+            uint32 slot;
+            ObjectInstanceChunk *chunk = objectInstanceStoreGetChunk(instances, objectIndices[first + i], &slot);
+            chunk->invTransforms[slot] = glm::inverse(chunk->instances[slot].transform);
+        }
+    }
+}
+
+// computes the world-space bounds of the instances at the given indices, or the first count instances if null
+void objectInstanceStoreUpdateBounds(ObjectInstanceStore *instances,
+    uint32 *indices,
+    uint32 count,
+    glm::vec3 meshBoundsMin,
+    glm::vec3 meshBoundsMax)
+{
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint32 slot;
+        ObjectInstanceChunk *chunk = objectInstanceStoreGetChunk(instances, indices ? indices[i] : i, &slot);
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        bvhTransformBounds(chunk->instances[slot].transform, meshBoundsMin, meshBoundsMax, &boundsMin, &boundsMax);
+
+        chunk->boundsMinX[slot] = boundsMin.x;
+        chunk->boundsMinY[slot] = boundsMin.y;
+        chunk->boundsMinZ[slot] = boundsMin.z;
+        chunk->boundsMaxX[slot] = boundsMax.x;
+        chunk->boundsMaxY[slot] = boundsMax.y;
+        chunk->boundsMaxZ[slot] = boundsMax.z;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef SIERRA_OBJECTS_H
+#define SIERRA_OBJECTS_H
+
+/*
+ * Objects are stored in fixed-size chunks that are allocated from an arena as the number of objects
+ * grows, so there is no limit on the number of objects and growing never moves existing objects.
+ * Objects are densely packed by index, object i is in slot i % OBJECT_CHUNK_CAPACITY of chunk
+ * i / OBJECT_CHUNK_CAPACITY and removing an object moves the last object into its place.
+ */
+
+// a multiple of the widest SIMD vector, so a chunk's arrays can be processed without a remainder
+#define OBJECT_CHUNK_CAPACITY 1024
+#define OBJECT_CHUNK_ALIGNMENT 32
+
+struct ObjectChunk
+{
+    // properties of each object in structure-of-arrays layout
+    uint32 ids[OBJECT_CHUNK_CAPACITY];
+    float positionX[OBJECT_CHUNK_CAPACITY];
+    float positionY[OBJECT_CHUNK_CAPACITY];
+    float positionZ[OBJECT_CHUNK_CAPACITY];
+    float rotationX[OBJECT_CHUNK_CAPACITY];
+    float rotationY[OBJECT_CHUNK_CAPACITY];
+    float rotationZ[OBJECT_CHUNK_CAPACITY];
+    float scaleX[OBJECT_CHUNK_CAPACITY];
+    float scaleY[OBJECT_CHUNK_CAPACITY];
+    float scaleZ[OBJECT_CHUNK_CAPACITY];
+
+    // whether each object's ID is in the store's dirty list
+    bool isDirty[OBJECT_CHUNK_CAPACITY];
+};
+
+struct ObjectIdMapSlot
+{
+    uint32 id;
+    uint32 index;
+};
+
+struct ObjectStore
+{
+    MemoryArena *arena;
+
+    // chunks are kept when objects are removed so they can be reused
+    ObjectChunk **chunks;
+    uint32 chunkCount;
+    uint32 maxChunkCount;
+
+    uint32 count;
+
+    /*
+     * Open-addressing hash table from object ID to index using linear probing. Object IDs are never 0
+     * so 0 marks an empty slot. The table is kept at most half full and is replaced with one twice the
+     * size when it would become fuller than that.
+     */
+    ObjectIdMapSlot *idMapSlots;
+    uint32 idMapSlotCount;
+    uint32 idMapHashShift;
+
+    /*
+     * IDs of objects whose transform may have changed since the list was last cleared, including
+     * objects that were added, moved to a new index or removed. Each object appears at most once.
+     */
+    uint32 *dirtyIds;
+    uint32 dirtyIdCount;
+    uint32 maxDirtyIdCount;
+};
+
+struct ObjectInstanceChunk
+{
+    // world transforms of each object, in the layout that is uploaded to the GPU
+    RenderMeshInstance instances[OBJECT_CHUNK_CAPACITY];
+    glm::mat4 invTransforms[OBJECT_CHUNK_CAPACITY];
+
+    // world-space bounds of each object in structure-of-arrays layout
+    float boundsMinX[OBJECT_CHUNK_CAPACITY];
+    float boundsMinY[OBJECT_CHUNK_CAPACITY];
+    float boundsMinZ[OBJECT_CHUNK_CAPACITY];
+    float boundsMaxX[OBJECT_CHUNK_CAPACITY];
+    float boundsMaxY[OBJECT_CHUNK_CAPACITY];
+    float boundsMaxZ[OBJECT_CHUNK_CAPACITY];
+};
+
+// the scene's copy of an object store, with the same chunk layout and indices
+struct ObjectInstanceStore
+{
+    MemoryArena *arena;
+
+    ObjectInstanceChunk **chunks;
+    uint32 chunkCount;
+    uint32 maxChunkCount;
+
+    uint32 count;
+};
+
+inline uint32 getObjectChunkCount(uint32 objectCount)
+{
+    return (objectCount + OBJECT_CHUNK_CAPACITY - 1) / OBJECT_CHUNK_CAPACITY;
+}
+inline uint32 getObjectCountInChunk(uint32 objectCount, uint32 chunkIndex)
+{
+    uint32 firstIndex = chunkIndex * OBJECT_CHUNK_CAPACITY;
+    uint32 remainingCount = objectCount - firstIndex;
+    return remainingCount < OBJECT_CHUNK_CAPACITY ? remainingCount : OBJECT_CHUNK_CAPACITY;
+}
+
+#endif
\ No newline at end of file
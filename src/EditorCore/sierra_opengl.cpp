@@ -107,6 +107,10 @@ struct OpenGlRenderContext;
 struct OpenGlPixelBuffer
 {
     uint32 id;
+    uint32 size;
+
+    // signalled once the GPU has finished copying pixels into the buffer
+    GLsync fence;
 
     OpenGlRenderContext *ctx;
     OpenGlPixelBuffer *next;
@@ -598,6 +602,18 @@ void renderBackendUpdateTexture(TextureHandle handle, uint32 width, uint32 heigh
         descriptor.elementType, pixels);
     glGenerateMipmap(GL_TEXTURE_2D);
 }
+void renderBackendUpdateTextureRegion(
+    TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height, uint32 rowLength, void *pixels)
+{
+    uint32 id = getTextureId(handle);
+    TextureFormat format = getTextureFormat(handle);
+    OpenGlTextureDescriptor descriptor = getTextureDescriptor(format);
+
+    // rows of the source pixels are rowLength elements apart
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glTextureSubImage2D(id, 0, x, y, width, height, descriptor.gpuFormat, descriptor.elementType, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
 GetPixelsResult renderBackendGetPixels(MemoryArena *arena, TextureHandle handle, uint32 width, uint32 height)
 {
     GetPixelsResult result;
@@ -632,13 +648,16 @@ GetPixelsResult renderBackendGetPixelsInRegion(
     uint32 bufferSize = result.count * descriptor.elementSize;
     result.pixels = pushSize(arena, bufferSize);
 
+    // rows are tightly packed, the default alignment of 4 would pad the rows of odd-width R16 regions
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
     glGetTextureSubImage(
         id, 0, x, y, 0, width, height, 1, descriptor.gpuFormat, descriptor.elementType, bufferSize, result.pixels);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
     return result;
 }
-GetPixelsRequest renderBackendQueueGetPixels(
-    RenderBackendContext rctx, TextureHandle handle, uint32 width, uint32 height)
+GetPixelsRequest renderBackendQueueGetPixelsInRegion(
+    RenderBackendContext rctx, TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height)
 {
     GetPixelsRequest request = {};
     OpenGlRenderContext *ctx = (OpenGlRenderContext *)rctx.ptr;
@@ -658,6 +677,7 @@ GetPixelsRequest renderBackendQueueGetPixels(
     {
         pbo = pushStruct(ctx->arena, OpenGlPixelBuffer);
         glGenBuffers(1, &pbo->id);
+        pbo->size = 0;
         pbo->ctx = ctx;
         pbo->next = 0;
     }
@@ -665,18 +685,36 @@ GetPixelsRequest renderBackendQueueGetPixels(
     glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo->id);
     request.pixelCount = width * height;
     uint32 bufferSize = request.pixelCount * descriptor.elementSize;
-    glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, 0, GL_STREAM_READ);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, id);
-    glGetTexImage(GL_TEXTURE_2D, 0, descriptor.gpuFormat, descriptor.elementType, 0);
+    if (bufferSize > pbo->size)
+    {
+        // buffers are recycled so only reallocate their storage when a larger region is requested
+        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, 0, GL_STREAM_READ);
+        pbo->size = bufferSize;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureSubImage(
+        id, 0, x, y, 0, width, height, 1, descriptor.gpuFormat, descriptor.elementType, bufferSize, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    pbo->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
     request.handle = pbo;
     return request;
 }
+bool renderBackendIsReadPixelsComplete(GetPixelsRequest *request)
+{
+    OpenGlPixelBuffer *pbo = (OpenGlPixelBuffer *)request->handle;
+
+    // flush so the fence is guaranteed to be signalled eventually, a timeout of zero never blocks
+    GLenum status = glClientWaitSync(pbo->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
 GetPixelsResult renderBackendBeginReadPixels(GetPixelsRequest *request)
 {
     GetPixelsResult result;
 
+    // mapping the buffer blocks until the copy has finished if it hasn't already
     OpenGlPixelBuffer *pbo = (OpenGlPixelBuffer *)request->handle;
     glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo->id);
     {
@@ -690,8 +728,12 @@ GetPixelsResult renderBackendBeginReadPixels(GetPixelsRequest *request)
 void renderBackendEndReadPixels(GetPixelsRequest *request)
 {
     glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
     OpenGlPixelBuffer *pbo = (OpenGlPixelBuffer *)request->handle;
+    glDeleteSync(pbo->fence);
+    pbo->fence = 0;
+
     OpenGlRenderContext *ctx = pbo->ctx;
     if (ctx->firstFreePixelBuffer)
     {
@@ -989,6 +1031,7 @@ bool renderBackendDrawToOutput(DispatchedRenderQueue *rq, RenderOutput *output)
     glEnable(GL_DEPTH_TEST);
     glDepthRange(0, 1);
     glDepthFunc(GL_LESS);
+    glDisable(GL_SCISSOR_TEST);
 
     bool isMissingResources = false;
     RenderQueueCommandHeader *command = rq->firstCommand;
@@ -1032,6 +1075,21 @@ bool renderBackendDrawToOutput(DispatchedRenderQueue *rq, RenderOutput *output)
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
         break;
+        case RENDER_CMD_SetClipRectCommand:
+        {
+            SetClipRectCommand *cmd = (SetClipRectCommand *)commandData;
+            if (cmd->isEnabled)
+            {
+                // clip rects are specified in pixels, with (0, 0) being the first row of the output
+                glEnable(GL_SCISSOR_TEST);
+                glScissor((int32)cmd->rect.x, (int32)cmd->rect.y, (int32)cmd->rect.width, (int32)cmd->rect.height);
+            }
+            else
+            {
+                glDisable(GL_SCISSOR_TEST);
+            }
+        }
+        break;
         case RENDER_CMD_DrawQuadsCommand:
         {
             DrawQuadsCommand *cmd = (DrawQuadsCommand *)commandData;
@@ -1286,6 +1344,7 @@ bool renderBackendDrawToOutput(DispatchedRenderQueue *rq, RenderOutput *output)
 
         command = command->next;
     }
+    glDisable(GL_SCISSOR_TEST);
 
     if (target)
     {
@@ -48,6 +48,16 @@ inline void *pushSize(MemoryArena *arena, uint64 size)
 #define pushStruct(arena, struct) (struct *)pushSize(arena, sizeof(struct))
 #define pushArray(arena, type, count) (type *)pushSize(arena, sizeof(type) * (count))
 
+inline void *pushSizeAligned(MemoryArena *arena, uint64 size, uint64 alignment)
+{
+    uint64 address = (uint64)arena->baseAddress + arena->used;
+    uint64 padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    pushSize(arena, padding);
+
+    return pushSize(arena, size);
+}
+#define pushStructAligned(arena, struct, alignment) (struct *)pushSizeAligned(arena, sizeof(struct), alignment)
+
 inline MemoryArena pushSubArena(MemoryArena *arena, uint64 size)
 {
     MemoryArena result = {};
@@ -103,6 +113,13 @@ typedef PLATFORM_START_PERF_COUNTER(PlatformStartPerfCounter);
 #define PLATFORM_END_PERF_COUNTER(name) void name(const char *counterName)
 typedef PLATFORM_END_PERF_COUNTER(PlatformEndPerfCounter);
 
+#define PLATFORM_JOB(name) void name(void *context, uint32 jobIndex)
+typedef PLATFORM_JOB(PlatformJob);
+
+// runs a job for every index below jobCount across the platform's worker threads and waits for them to finish
+#define PLATFORM_PARALLEL_FOR(name) void name(uint32 jobCount, PlatformJob *job, void *context)
+typedef PLATFORM_PARALLEL_FOR(PlatformParallelFor);
+
 struct EditorPlatformApi
 {
     PlatformLogMessage *logMessage;
@@ -114,6 +131,7 @@ struct EditorPlatformApi
     PlatformPublishTransaction *publishTransaction;
     PlatformStartPerfCounter *startPerfCounter;
     PlatformEndPerfCounter *endPerfCounter;
+    PlatformParallelFor *parallelFor;
 };
 
 #endif
\ No newline at end of file
@@ -61,6 +61,7 @@ enum RenderQueueCommandType
     RENDER_CMD_SetCameraCommand,
     RENDER_CMD_SetLightingCommand,
     RENDER_CMD_ClearCommand,
+    RENDER_CMD_SetClipRectCommand,
     RENDER_CMD_DrawQuadsCommand,
     RENDER_CMD_DrawLineCommand,
     RENDER_CMD_DrawMeshesCommand,
@@ -90,6 +91,11 @@ struct ClearCommand
 {
     glm::vec4 color;
 };
+struct SetClipRectCommand
+{
+    bool isEnabled;
+    rect2 rect;
+};
 struct DrawQuadsCommand
 {
     RenderEffect *effect;
@@ -180,11 +186,14 @@ void renderBackendDestroyMesh(MeshHandle handle);
 uint32 renderBackendGetTextureElementSize(TextureFormat format);
 TextureHandle renderBackendCreateTexture(uint32 width, uint32 height, TextureFormat format);
 void renderBackendUpdateTexture(TextureHandle handle, uint32 width, uint32 height, void *pixels);
+void renderBackendUpdateTextureRegion(
+    TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height, uint32 rowLength, void *pixels);
 GetPixelsResult renderBackendGetPixels(MemoryArena *arena, TextureHandle handle, uint32 width, uint32 height);
 GetPixelsResult renderBackendGetPixelsInRegion(
     MemoryArena *arena, TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height);
-GetPixelsRequest renderBackendQueueGetPixels(
-    RenderBackendContext rctx, TextureHandle handle, uint32 width, uint32 height);
+GetPixelsRequest renderBackendQueueGetPixelsInRegion(
+    RenderBackendContext rctx, TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height);
+bool renderBackendIsReadPixelsComplete(GetPixelsRequest *request);
 GetPixelsResult renderBackendBeginReadPixels(GetPixelsRequest *request);
 void renderBackendEndReadPixels(GetPixelsRequest *request);
 
@@ -65,6 +65,11 @@ void rendererUpdateTexture(TextureHandle handle, uint32 width, uint32 height, vo
 {
     renderBackendUpdateTexture(handle, width, height, pixels);
 }
+void rendererUpdateTextureRegion(
+    TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height, uint32 rowLength, void *pixels)
+{
+    renderBackendUpdateTextureRegion(handle, x, y, width, height, rowLength, pixels);
+}
 GetPixelsResult rendererGetPixels(MemoryArena *arena, TextureHandle handle, uint32 width, uint32 height)
 {
     TIMED_BLOCK("Get Pixels");
@@ -75,9 +80,14 @@ GetPixelsResult rendererGetPixelsInRegion(
 {
     return renderBackendGetPixelsInRegion(arena, handle, x, y, width, height);
 }
-GetPixelsRequest rendererQueueGetPixels(RenderContext *ctx, TextureHandle handle, uint32 width, uint32 height)
+GetPixelsRequest rendererQueueGetPixelsInRegion(
+    RenderContext *ctx, TextureHandle handle, uint32 x, uint32 y, uint32 width, uint32 height)
+{
+    return renderBackendQueueGetPixelsInRegion(ctx->internalCtx, handle, x, y, width, height);
+}
+bool rendererIsReadPixelsComplete(GetPixelsRequest *request)
 {
-    return renderBackendQueueGetPixels(ctx->internalCtx, handle, width, height);
+    return renderBackendIsReadPixelsComplete(request);
 }
 GetPixelsResult rendererBeginReadPixels(GetPixelsRequest *request)
 {
@@ -380,6 +390,19 @@ void rendererClear(RenderQueue *rq, float r, float g, float b, float a)
     cmd->color.a = a;
 }
 
+void rendererSetClipRect(RenderQueue *rq, rect2 rect)
+{
+    SetClipRectCommand *cmd = pushRenderCommand(rq, SetClipRectCommand);
+    cmd->isEnabled = true;
+    cmd->rect = rect;
+}
+
+void rendererClearClipRect(RenderQueue *rq)
+{
+    SetClipRectCommand *cmd = pushRenderCommand(rq, SetClipRectCommand);
+    cmd->isEnabled = false;
+}
+
 void pushQuads(RenderQueue *rq, rect2 *quads, uint32 quadCount, RenderEffect *effect, bool isTopDown)
 {
     if (quadCount > 0)
@@ -515,10 +538,23 @@ void rendererPushQuadOutlineXz(RenderQueue *rq, rect2 quad, glm::vec3 color)
     rendererEndLineLoop(rq);
 }
 
-void rendererPushMeshes(
-    RenderQueue *rq, AssetHandle mesh, RenderMeshInstance *instances, uint32 instanceCount, RenderEffect *effect)
+// pushes a command drawing the given number of instances and returns where they should be written
+RenderMeshInstance *pushDrawMeshesCommand(
+    RenderQueue *rq, AssetHandle mesh, uint32 instanceCount, RenderEffect *effect)
 {
-    assert(rq->meshInstanceCount + instanceCount < rq->maxMeshInstances + 1);
+    // the instances are uploaded as a single buffer, so move them into a larger array once they don't fit
+    if (rq->meshInstanceCount + instanceCount > rq->maxMeshInstances)
+    {
+        uint32 newMaxMeshInstances = rq->maxMeshInstances * 2;
+        while (newMaxMeshInstances < rq->meshInstanceCount + instanceCount)
+        {
+            newMaxMeshInstances *= 2;
+        }
+        RenderMeshInstance *newMeshInstances = pushArray(rq->arena, RenderMeshInstance, newMaxMeshInstances);
+        memcpy(newMeshInstances, rq->meshInstances, sizeof(RenderMeshInstance) * rq->meshInstanceCount);
+        rq->meshInstances = newMeshInstances;
+        rq->maxMeshInstances = newMaxMeshInstances;
+    }
 
     DrawMeshesCommand *cmd = pushRenderCommand(rq, DrawMeshesCommand);
     cmd->effect = effect;
@@ -535,8 +571,28 @@ void rendererPushMeshes(
         }
     }
 
-    memcpy(rq->meshInstances + rq->meshInstanceCount, instances, sizeof(RenderMeshInstance) * instanceCount);
+    RenderMeshInstance *result = rq->meshInstances + rq->meshInstanceCount;
     rq->meshInstanceCount += instanceCount;
+
+    return result;
+}
+
+void rendererPushMeshes(
+    RenderQueue *rq, AssetHandle mesh, RenderMeshInstance *instances, uint32 instanceCount, RenderEffect *effect)
+{
+    RenderMeshInstance *dst = pushDrawMeshesCommand(rq, mesh, instanceCount, effect);
+    memcpy(dst, instances, sizeof(RenderMeshInstance) * instanceCount);
+}
+
+// draws the instances at the given indices, compacting them into the queue's instance buffer
+void rendererPushMeshesIndexed(RenderQueue *rq, AssetHandle mesh, RenderMeshInstance *instances, uint32 *indices,
+    uint32 indexCount, RenderEffect *effect)
+{
+    RenderMeshInstance *dst = pushDrawMeshesCommand(rq, mesh, indexCount, effect);
+    for (uint32 i = 0; i < indexCount; i++)
+    {
+        dst[i] = instances[indices[i]];
+    }
 }
 
 TextureAsset *getTexture(AssetHandle assetHandle)
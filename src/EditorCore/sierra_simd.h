@@ -0,0 +1,262 @@
+#ifndef SIERRA_SIMD_H
+#define SIERRA_SIMD_H
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+enum SimdLevel
+{
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSE4,
+    SIMD_LEVEL_AVX2
+};
+
+inline void readCpuid(int32 *cpuInfo, int32 leaf, int32 subleaf)
+{
+#ifdef _MSC_VER
+    __cpuidex(cpuInfo, leaf, subleaf);
+#else
+    uint32 *registers = (uint32 *)cpuInfo;
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+inline uint64 readXcr0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    // _xgetbv needs the XSAVE target feature on GCC and Clang, which the rest of the build doesn't enable
+    uint32 low;
+    uint32 high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((uint64)high << 32) | low;
+#endif
+}
+
+inline SimdLevel detectSimdLevel()
+{
+    int32 cpuInfo[4];
+    readCpuid(cpuInfo, 0, 0);
+    int32 maxLeaf = cpuInfo[0];
+
+    readCpuid(cpuInfo, 1, 0);
+    bool hasSse41 = cpuInfo[2] & (1 << 19);
+    bool hasOsxsave = cpuInfo[2] & (1 << 27);
+    bool hasAvx = cpuInfo[2] & (1 << 28);
+    if (!hasSse41)
+    {
+        return SIMD_LEVEL_SCALAR;
+    }
+
+    bool hasAvx2 = false;
+    if (maxLeaf >= 7 && hasOsxsave && hasAvx)
+    {
+        // the OS must also be preserving the upper halves of the YMM registers
+        uint64 xcr0 = readXcr0();
+        if ((xcr0 & 6) == 6)
+        {
+            readCpuid(cpuInfo, 7, 0);
+            hasAvx2 = cpuInfo[1] & (1 << 5);
+        }
+    }
+
+    return hasAvx2 ? SIMD_LEVEL_AVX2 : SIMD_LEVEL_SSE4;
+}
+
+// tools lower this to run and compare the narrower kernels, levels above the detected one are never used
+global_variable SimdLevel SimdLevelLimit = SIMD_LEVEL_AVX2;
+
+inline SimdLevel getSimdLevel()
+{
+    static SimdLevel detectedLevel = detectSimdLevel();
+    return detectedLevel < SimdLevelLimit ? detectedLevel : SimdLevelLimit;
+}
+
+/*
+ * Approximates cos(x) for x in [0, pi] as -sin(x - pi/2) using a degree 9 minimax polynomial.
+ * The scalar and vector versions perform the same operations in the same order (and never use
+ * fused multiply-adds) so that they produce bit-identical results.
+ */
+#define COS_APPROX_HALF_PI 1.57079637f
+#define COS_APPROX_C1 -0.166666597f
+#define COS_APPROX_C2 0.00833307858f
+#define COS_APPROX_C3 -0.000198106907f
+#define COS_APPROX_C4 2.60831598e-6f
+
+inline float cosApprox(float x)
+{
+    float t = x - COS_APPROX_HALF_PI;
+    float t2 = t * t;
+    float p = COS_APPROX_C4;
+    p = (p * t2) + COS_APPROX_C3;
+    p = (p * t2) + COS_APPROX_C2;
+    p = (p * t2) + COS_APPROX_C1;
+    p = p * t2;
+    float sinT = t + (t * p);
+    return -sinT;
+}
+inline __m128 cosApprox4(__m128 x)
+{
+    __m128 t = _mm_sub_ps(x, _mm_set1_ps(COS_APPROX_HALF_PI));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(COS_APPROX_C4);
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(COS_APPROX_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(COS_APPROX_C2));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(COS_APPROX_C1));
+    p = _mm_mul_ps(p, t2);
+    __m128 sinT = _mm_add_ps(t, _mm_mul_ps(t, p));
+    return _mm_xor_ps(sinT, _mm_set1_ps(-0.0f));
+}
+inline __m256 cosApprox8(__m256 x)
+{
+    __m256 t = _mm256_sub_ps(x, _mm256_set1_ps(COS_APPROX_HALF_PI));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(COS_APPROX_C4);
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(COS_APPROX_C3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(COS_APPROX_C2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(COS_APPROX_C1));
+    p = _mm256_mul_ps(p, t2);
+    __m256 sinT = _mm256_add_ps(t, _mm256_mul_ps(t, p));
+    return _mm256_xor_ps(sinT, _mm256_set1_ps(-0.0f));
+}
+
+/*
+ * Approximates sin(x) and cos(x) for any x by reducing it to r in [-pi/4, pi/4] around the nearest multiple
+ * of pi/2, evaluating minimax polynomials for sin(r) and cos(r) and then swapping and negating them based
+ * on the quadrant. As above, the scalar and vector versions produce bit-identical results.
+ */
+#define SIN_COS_APPROX_TWO_OVER_PI 0.636619747f
+#define SIN_COS_APPROX_HALF_PI_HI 1.5703125f
+#define SIN_COS_APPROX_HALF_PI_LO 4.83826792e-4f
+#define SIN_COS_APPROX_S1 -0.166666552f
+#define SIN_COS_APPROX_S2 0.00833216123f
+#define SIN_COS_APPROX_S3 -0.000195152956f
+#define SIN_COS_APPROX_C1 0.0416666456f
+#define SIN_COS_APPROX_C2 -0.00138873165f
+#define SIN_COS_APPROX_C3 2.44331568e-5f
+
+inline void sinCosApprox(float x, float *outSin, float *outCos)
+{
+    int32 quadrant = _mm_cvtss_si32(_mm_set_ss(x * SIN_COS_APPROX_TWO_OVER_PI));
+    float q = (float)quadrant;
+    float r = (x - (q * SIN_COS_APPROX_HALF_PI_HI)) - (q * SIN_COS_APPROX_HALF_PI_LO);
+    float z = r * r;
+
+    float sinR = SIN_COS_APPROX_S3;
+    sinR = (sinR * z) + SIN_COS_APPROX_S2;
+    sinR = (sinR * z) + SIN_COS_APPROX_S1;
+    sinR = ((sinR * z) * r) + r;
+
+    float cosR = SIN_COS_APPROX_C3;
+    cosR = (cosR * z) + SIN_COS_APPROX_C2;
+    cosR = (cosR * z) + SIN_COS_APPROX_C1;
+    cosR = (((cosR * z) * z) - (0.5f * z)) + 1.0f;
+
+    float sinX = (quadrant & 1) ? cosR : sinR;
+    float cosX = (quadrant & 1) ? sinR : cosR;
+    *outSin = (quadrant & 2) ? -sinX : sinX;
+    *outCos = ((quadrant + 1) & 2) ? -cosX : cosX;
+}
+inline void sinCosApprox4(__m128 x, __m128 *outSin, __m128 *outCos)
+{
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(SIN_COS_APPROX_TWO_OVER_PI)));
+    __m128 q = _mm_cvtepi32_ps(quadrant);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(SIN_COS_APPROX_HALF_PI_HI)));
+    r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(SIN_COS_APPROX_HALF_PI_LO)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 sinR = _mm_set1_ps(SIN_COS_APPROX_S3);
+    sinR = _mm_add_ps(_mm_mul_ps(sinR, z), _mm_set1_ps(SIN_COS_APPROX_S2));
+    sinR = _mm_add_ps(_mm_mul_ps(sinR, z), _mm_set1_ps(SIN_COS_APPROX_S1));
+    sinR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinR, z), r), r);
+
+    __m128 cosR = _mm_set1_ps(SIN_COS_APPROX_C3);
+    cosR = _mm_add_ps(_mm_mul_ps(cosR, z), _mm_set1_ps(SIN_COS_APPROX_C2));
+    cosR = _mm_add_ps(_mm_mul_ps(cosR, z), _mm_set1_ps(SIN_COS_APPROX_C1));
+    cosR = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cosR, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    cosR = _mm_add_ps(cosR, _mm_set1_ps(1.0f));
+
+    // odd quadrants swap sin and cos, bit 1 of the quadrant (or of the quadrant + 1) becomes the sign bit
+    __m128i one = _mm_set1_epi32(1);
+    __m128i two = _mm_set1_epi32(2);
+    __m128 isOdd = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+    *outSin = _mm_xor_ps(_mm_blendv_ps(sinR, cosR, isOdd), sinSign);
+    *outCos = _mm_xor_ps(_mm_blendv_ps(cosR, sinR, isOdd), cosSign);
+}
+inline void sinCosApprox8(__m256 x, __m256 *outSin, __m256 *outCos)
+{
+    __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(SIN_COS_APPROX_TWO_OVER_PI)));
+    __m256 q = _mm256_cvtepi32_ps(quadrant);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(SIN_COS_APPROX_HALF_PI_HI)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(SIN_COS_APPROX_HALF_PI_LO)));
+    __m256 z = _mm256_mul_ps(r, r);
+
+    __m256 sinR = _mm256_set1_ps(SIN_COS_APPROX_S3);
+    sinR = _mm256_add_ps(_mm256_mul_ps(sinR, z), _mm256_set1_ps(SIN_COS_APPROX_S2));
+    sinR = _mm256_add_ps(_mm256_mul_ps(sinR, z), _mm256_set1_ps(SIN_COS_APPROX_S1));
+    sinR = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinR, z), r), r);
+
+    __m256 cosR = _mm256_set1_ps(SIN_COS_APPROX_C3);
+    cosR = _mm256_add_ps(_mm256_mul_ps(cosR, z), _mm256_set1_ps(SIN_COS_APPROX_C2));
+    cosR = _mm256_add_ps(_mm256_mul_ps(cosR, z), _mm256_set1_ps(SIN_COS_APPROX_C1));
+    cosR = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(cosR, z), z), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+    cosR = _mm256_add_ps(cosR, _mm256_set1_ps(1.0f));
+
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i two = _mm256_set1_epi32(2);
+    __m256 isOdd = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+    __m256 cosSign =
+        _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+    *outSin = _mm256_xor_ps(_mm256_blendv_ps(sinR, cosR, isOdd), sinSign);
+    *outCos = _mm256_xor_ps(_mm256_blendv_ps(cosR, sinR, isOdd), cosSign);
+}
+
+// R16 unorm conversions matching the GPU's float <-> unorm16 conversion rules
+#define UNORM16_MAX 65535.0f
+#define UNORM16_TO_FLOAT (1.0f / 65535.0f)
+
+inline float decodeUnorm16(uint16 value)
+{
+    return (float)value * UNORM16_TO_FLOAT;
+}
+inline uint16 encodeUnorm16(float value)
+{
+    __m128 v = _mm_set_ss(value);
+    v = _mm_min_ss(_mm_max_ss(v, _mm_setzero_ps()), _mm_set_ss(1.0f));
+    return (uint16)_mm_cvtss_si32(_mm_mul_ss(v, _mm_set_ss(UNORM16_MAX)));
+}
+
+inline __m128 decodeUnorm16x4(uint16 *src)
+{
+    __m128i words = _mm_loadl_epi64((__m128i *)src);
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(words)), _mm_set1_ps(UNORM16_TO_FLOAT));
+}
+inline void encodeUnorm16x4(uint16 *dst, __m128 value)
+{
+    value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    __m128i dwords = _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(UNORM16_MAX)));
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi32(dwords, dwords));
+}
+
+inline __m256 decodeUnorm16x8(uint16 *src)
+{
+    __m128i words = _mm_loadu_si128((__m128i *)src);
+    return _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(words)), _mm256_set1_ps(UNORM16_TO_FLOAT));
+}
+inline void encodeUnorm16x8(uint16 *dst, __m256 value)
+{
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    __m256i dwords = _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(UNORM16_MAX)));
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(dwords, dwords), 0x08);
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(words));
+}
+
+#endif